@@ -0,0 +1,330 @@
+#include "FlyRedis/FlyRedis.h"
+#include <chrono>
+
+// Microbenchmark of delimiter scanning and cmd encoding, it does not need redis server.
+// Build it with -mavx2 to scan by AVX2, otherwise SSE2 is used on x64
+
+//////////////////////////////////////////////////////////////////////////
+// Byte by byte implementation which FlyRedis used before FindDelim
+std::vector<std::string> LegacySplitString(const std::string& strInput, char chDelim)
+{
+    std::vector<std::string> vecResult;
+    if (strInput.empty())
+    {
+        return vecResult;
+    }
+    std::string strToken;
+    for (char chValue : strInput)
+    {
+        if (chValue != chDelim)
+        {
+            strToken.append(1, chValue);
+        }
+        else
+        {
+            vecResult.emplace_back(strToken);
+            strToken.clear();
+        }
+    }
+    if (!strToken.empty())
+    {
+        vecResult.emplace_back(strToken);
+    }
+    if (strInput.back() == chDelim)
+    {
+        vecResult.emplace_back("");
+    }
+    return vecResult;
+}
+
+std::string& LegacyTrimLastChar(std::string& strValue, size_t nTrimCount)
+{
+    size_t nLength = strValue.length();
+    if (nLength >= nTrimCount)
+    {
+        strValue.erase(nLength - nTrimCount);
+    }
+    return strValue;
+}
+
+void LegacyParseInfoResponse(const std::string& strInfoResponse, std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo)
+{
+    size_t nLineLen = strInfoResponse.length();
+    std::string strLine;
+    std::string strCurSection;
+    std::string strCurKey;
+    std::string strCurValue;
+    for (size_t nIndex = 0; nIndex < nLineLen; ++nIndex)
+    {
+        char chCur = strInfoResponse[nIndex];
+        strLine.append(1, chCur);
+        if ('\n' == chCur)
+        {
+            if ('#' == strLine[0])
+            {
+                strCurSection.swap(LegacyTrimLastChar(strLine, 2));
+                strLine.clear();
+            }
+            else
+            {
+                strCurValue.swap(LegacyTrimLastChar(strLine, 2));
+                strLine.clear();
+                mapSectionInfo[strCurSection].emplace(strCurKey, strCurValue);
+            }
+        }
+        else if (':' == chCur)
+        {
+            strCurKey.swap(LegacyTrimLastChar(strLine, 1));
+            strLine.clear();
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Count RESP value without keeping it
+class CCountRESPHandler : public CFlyRedisRESPHandler
+{
+public:
+    virtual void OnRESPValue(char /*chType*/, const char* /*pData*/, size_t nLen) override
+    {
+        ++m_nValueCount;
+        m_nValueLen += nLen;
+    }
+    virtual void OnRESPAggregateBegin(char /*chType*/, int /*nCount*/) override
+    {
+    }
+    virtual void OnRESPAggregateEnd(char /*chType*/) override
+    {
+    }
+    size_t m_nValueCount = 0;
+    size_t m_nValueLen = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+std::string BuildInfoResponse()
+{
+    std::string strInfo = "# Server\r\nredis_version:7.2.4\r\nredis_mode:cluster\r\nos:Linux 6.1.0 x86_64\r\nexecutable:/usr/local/bin/redis-server\r\n\r\n";
+    strInfo.append("# Commandstats\r\n");
+    for (int nIndex = 0; nIndex < 240; ++nIndex)
+    {
+        strInfo.append("cmdstat_cmd").append(std::to_string(nIndex)).append(":calls=").append(std::to_string(nIndex * 7919));
+        strInfo.append(",usec=").append(std::to_string(nIndex * 104729)).append(",usec_per_call=1.23,rejected_calls=0,failed_calls=0\r\n");
+    }
+    strInfo.append("\r\n# Keyspace\r\n");
+    for (int nIndex = 0; nIndex < 16; ++nIndex)
+    {
+        strInfo.append("db").append(std::to_string(nIndex)).append(":keys=123456,expires=789,avg_ttl=3600000\r\n");
+    }
+    return strInfo;
+}
+
+std::string BuildClusterNodesResponse()
+{
+    std::string strNodes;
+    for (int nIndex = 0; nIndex < 1000; ++nIndex)
+    {
+        std::string strNodeId = std::to_string(nIndex);
+        strNodeId.insert(0, 40 - strNodeId.length(), 'a');
+        strNodes.append(strNodeId).append(" 10.0.").append(std::to_string(nIndex / 250)).append(".").append(std::to_string(nIndex % 250));
+        strNodes.append(":6379@16379 master - 0 1700000000000 ").append(std::to_string(nIndex)).append(" connected ");
+        strNodes.append(std::to_string(nIndex * 16)).append("-").append(std::to_string(nIndex * 16 + 15)).append("\n");
+    }
+    return strNodes;
+}
+
+std::string BuildArrayResponse()
+{
+    std::vector<std::string> vecParam;
+    for (int nIndex = 0; nIndex < 100000; ++nIndex)
+    {
+        vecParam.emplace_back("member_" + std::to_string(nIndex));
+    }
+    std::string strResponse;
+    CFlyRedis::BuildRedisCmdRequest("", vecParam, strResponse, false);
+    return strResponse;
+}
+
+template <typename Func>
+double RunMS(int nLoop, Func fn)
+{
+    auto tmBegin = std::chrono::steady_clock::now();
+    for (int nIndex = 0; nIndex < nLoop; ++nIndex)
+    {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tmBegin).count();
+}
+
+void PrintResult(const char* pszName, size_t nLen, int nLoop, double fLegacyMS, double fFlyRedisMS)
+{
+    printf("%-16s %8zu bytes x %5d  legacy %9.2f ms  FlyRedis %9.2f ms  speedup %.2fx\n", pszName, nLen, nLoop, fLegacyMS, fFlyRedisMS, fLegacyMS / fFlyRedisMS);
+}
+
+int main()
+{
+#if defined(__AVX2__)
+    printf("FindDelim scans by AVX2\n");
+#elif defined(__SSE2__) || defined(_M_X64)
+    printf("FindDelim scans by SSE2\n");
+#else
+    printf("FindDelim scans byte by byte\n");
+#endif
+    size_t nCheckSum = 0;
+    std::string strInfo = BuildInfoResponse();
+    int nLoop = 2000;
+    double fLegacyMS = RunMS(nLoop, [&]() {
+        std::map<std::string, std::map<std::string, std::string> > mapSectionInfo;
+        LegacyParseInfoResponse(strInfo, mapSectionInfo);
+        nCheckSum += mapSectionInfo.size();
+    });
+    double fFlyRedisMS = RunMS(nLoop, [&]() {
+        std::map<std::string, std::map<std::string, std::string> > mapSectionInfo;
+        CFlyRedis::ParseInfoResponse(strInfo, mapSectionInfo);
+        nCheckSum += mapSectionInfo.size();
+    });
+    PrintResult("INFO", strInfo.length(), nLoop, fLegacyMS, fFlyRedisMS);
+
+    std::string strNodes = BuildClusterNodesResponse();
+    nLoop = 500;
+    fLegacyMS = RunMS(nLoop, [&]() {
+        nCheckSum += LegacySplitString(strNodes, '\n').size();
+    });
+    fFlyRedisMS = RunMS(nLoop, [&]() {
+        nCheckSum += CFlyRedis::SplitString(strNodes, '\n').size();
+    });
+    PrintResult("CLUSTER NODES", strNodes.length(), nLoop, fLegacyMS, fFlyRedisMS);
+
+    // Line scan of array reply, legacy is memchr which the parser used before
+    std::string strArray = BuildArrayResponse();
+    nLoop = 100;
+    const char* pArrayEnd = strArray.data() + strArray.length();
+    fLegacyMS = RunMS(nLoop, [&]() {
+        for (const char* pCur = strArray.data(); pCur < pArrayEnd; ++nCheckSum)
+        {
+            const char* pLineEnd = static_cast<const char*>(memchr(pCur, '\r', pArrayEnd - pCur));
+            pCur = (nullptr == pLineEnd) ? pArrayEnd : pLineEnd + 2;
+        }
+    });
+    fFlyRedisMS = RunMS(nLoop, [&]() {
+        for (const char* pCur = strArray.data(); pCur < pArrayEnd; ++nCheckSum)
+        {
+            pCur = CFlyRedis::FindDelim(pCur, pArrayEnd, '\r') + 2;
+        }
+    });
+    PrintResult("Array CRLF", strArray.length(), nLoop, fLegacyMS, fFlyRedisMS);
+
+    // Whole parse of array reply by RESP parser
+    CFlyRedisRESPParser hRESPParser;
+    CCountRESPHandler hCountRESPHandler;
+    double fParseMS = RunMS(nLoop, [&]() {
+        size_t nConsumed = 0;
+        hRESPParser.Reset();
+        hRESPParser.Parse(strArray.data(), strArray.length(), nConsumed, hCountRESPHandler);
+        nCheckSum += nConsumed;
+    });
+    printf("%-16s %8zu bytes x %5d  %.2f ms  %.1f MB/s\n", "Array parse", strArray.length(), nLoop, fParseMS, strArray.length() * nLoop / fParseMS / 1000.0);
+
+    // Encode SET, legacy is the param list which FlyRedisClient used before CFlyRedisCmdEncoder
+    std::string strKey = "benchmark_key";
+    std::string strValue(64, 'v');
+    std::string strRequest;
+    std::vector<std::string> vecRedisCmdParamList;
+    nLoop = 1000000;
+    fLegacyMS = RunMS(nLoop, [&]() {
+        vecRedisCmdParamList.clear();
+        vecRedisCmdParamList.emplace_back("SET");
+        vecRedisCmdParamList.emplace_back(strKey);
+        vecRedisCmdParamList.emplace_back(strValue);
+        CFlyRedis::BuildRedisCmdRequest("", vecRedisCmdParamList, strRequest, false);
+        nCheckSum += strRequest.length();
+    });
+    static const CFlyRedisCmdName hCmdName("SET");
+    fFlyRedisMS = RunMS(nLoop, [&]() {
+        strRequest.clear();
+        CFlyRedisCmdEncoder::AppendRedisCmd(strRequest, hCmdName, strKey, strValue);
+        nCheckSum += strRequest.length();
+    });
+    PrintResult("SET encode", strRequest.length(), nLoop, fLegacyMS, fFlyRedisMS);
+
+    // Encode SET with 4MB value, gather encoder references the value instead of copying it
+    std::string strLargeValue(4 * 1024 * 1024, 'v');
+    std::vector<FlyRedisGatherParam> vecGatherParam;
+    nLoop = 200;
+    fLegacyMS = RunMS(nLoop, [&]() {
+        strRequest.clear();
+        CFlyRedisCmdEncoder::AppendRedisCmd(strRequest, hCmdName, strKey, strLargeValue);
+        nCheckSum += strRequest.length();
+    });
+    fFlyRedisMS = RunMS(nLoop, [&]() {
+        strRequest.clear();
+        vecGatherParam.clear();
+        CFlyRedisCmdEncoder::AppendGatherRedisCmd(strRequest, vecGatherParam, hCmdName, strKey, strLargeValue);
+        nCheckSum += strRequest.length() + vecGatherParam.size();
+    });
+    PrintResult("SET 4MB encode", strLargeValue.length(), nLoop, fLegacyMS, fFlyRedisMS);
+
+    // Encode and decode score, legacy is std::to_string and atof which FlyRedisClient used before CFlyRedisNumberCodec
+    std::vector<double> vecScore;
+    std::vector<std::string> vecScoreText;
+    for (int nIndex = 0; nIndex < 1000; ++nIndex)
+    {
+        vecScore.push_back(nIndex * 0.25 - 100.0);
+        vecScoreText.push_back(CFlyRedisNumberCodec::DoubleToString(nIndex * 0.37 + 1000.0));
+    }
+    char szScore[32];
+    nLoop = 1000;
+    fLegacyMS = RunMS(nLoop, [&]() {
+        for (double fScore : vecScore)
+        {
+            nCheckSum += std::to_string(fScore).length();
+        }
+    });
+    fFlyRedisMS = RunMS(nLoop, [&]() {
+        for (double fScore : vecScore)
+        {
+            nCheckSum += CFlyRedisNumberCodec::EncodeDouble(szScore, fScore);
+        }
+    });
+    PrintResult("Score encode", vecScore.size(), nLoop, fLegacyMS, fFlyRedisMS);
+    double fScoreSum = 0.0;
+    fLegacyMS = RunMS(nLoop, [&]() {
+        for (const std::string& strScore : vecScoreText)
+        {
+            fScoreSum += atof(strScore.c_str());
+        }
+    });
+    fFlyRedisMS = RunMS(nLoop, [&]() {
+        for (const std::string& strScore : vecScoreText)
+        {
+            double fScore = 0.0;
+            CFlyRedisNumberCodec::DecodeDouble(strScore.data(), strScore.data() + strScore.length(), fScore);
+            fScoreSum += fScore;
+        }
+    });
+    PrintResult("Score decode", vecScoreText.size(), nLoop, fLegacyMS, fFlyRedisMS);
+    nCheckSum += static_cast<size_t>(fScoreSum);
+
+    // Write cmd log of SET into a file, legacy formats it and calls the handler inline, FlyRedis copies the request into async logger which does both in the background thread
+    FILE* pLogFile = tmpfile();
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Command, [pLogFile](const char* pszLogContent) {
+        fputs(pszLogContent, pLogFile);
+        fputc('\n', pLogFile);
+        fflush(pLogFile);
+    });
+    strRequest.clear();
+    CFlyRedisCmdEncoder::AppendRedisCmd(strRequest, hCmdName, strKey, strValue);
+    nLoop = 8000;
+    fLegacyMS = RunMS(nLoop, [&]() {
+        CFlyRedis::LogRedisCmdRequest("127.0.0.1:6379", strRequest);
+    });
+    CFlyRedis::StartAsyncLogger(nLoop);
+    fFlyRedisMS = RunMS(nLoop, [&]() {
+        CFlyRedis::LogRedisCmdRequest("127.0.0.1:6379", strRequest);
+    });
+    CFlyRedis::StopAsyncLogger();
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Command, nullptr);
+    fclose(pLogFile);
+    PrintResult("SET cmd log", strRequest.length(), nLoop, fLegacyMS, fFlyRedisMS);
+    printf("CheckSum %zu\n", nCheckSum + hCountRESPHandler.m_nValueCount);
+    return 0;
+}
@@ -24,12 +24,53 @@
 #include "FlyRedis.h"
 #include "boost/thread.hpp"
 #include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <cmath>
+// Delimiter is scanned by AVX2 or SSE2 if the compiler enables them, such as -mavx2, SSE2 is always enabled on x64
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FLY_REDIS_SIMD_AVX2
+#endif // __AVX2__
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLY_REDIS_SIMD_SSE2
+#endif // __SSE2__
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
+// Asio handler may run after its owner is destroyed, such as the aborted read of a deleted session, then it is dropped
+template <typename THandler>
+struct FlyRedisAliveHandler
+{
+    std::weak_ptr<bool> pAliveToken;
+    THandler hHandler;
+
+    template <typename... TArgs>
+    void operator()(TArgs&&... args)
+    {
+        if (!pAliveToken.expired())
+        {
+            hHandler(std::forward<TArgs>(args)...);
+        }
+    }
+};
+
+template <typename THandler>
+static inline FlyRedisAliveHandler<typename std::decay<THandler>::type> FlyRedisGuardHandler(const std::shared_ptr<bool>& pAliveToken, THandler&& hHandler)
+{
+    return FlyRedisAliveHandler<typename std::decay<THandler>::type>{ pAliveToken, std::forward<THandler>(hHandler) };
+}
 
 //////////////////////////////////////////////////////////////////////////
 // Begin of CFlyRedisNetStream
 #ifdef FLY_REDIS_ENABLE_TLS
 CFlyRedisNetStream::CFlyRedisNetStream(boost::asio::io_context& boostIOContext, bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext)
     :m_boostIOContext(boostIOContext),
+    m_boostReadTimer(boostIOContext),
+    m_boostResolver(boostIOContext),
     m_bUseTLSFlag(bUseTLSFlag),
     m_boostTLSSocketStream(boostIOContext, boostTLSContext),
     m_boostTCPSocketStream(boostIOContext)
@@ -38,6 +79,8 @@ CFlyRedisNetStream::CFlyRedisNetStream(boost::asio::io_context& boostIOContext,
 #else
 CFlyRedisNetStream::CFlyRedisNetStream(boost::asio::io_context& boostIOContext)
     :m_boostIOContext(boostIOContext),
+    m_boostReadTimer(boostIOContext),
+    m_boostResolver(boostIOContext),
     m_boostTCPSocketStream(boostIOContext)
 {
 }
@@ -49,42 +92,50 @@ CFlyRedisNetStream::~CFlyRedisNetStream()
 
 bool CFlyRedisNetStream::Connect()
 {
-    std::vector<std::string> vecField = CFlyRedis::SplitString(m_strRedisAddress, ':');
-    if (vecField.size() != 2)
+    StartAsyncConnect();
+    m_boostIOContext.restart();
+    while (m_bConnecting && m_boostIOContext.run_one() > 0)
     {
-        return false;
     }
-    boost::asio::ip::tcp::resolver boostResolver(m_boostIOContext);
-    boost::asio::ip::tcp::resolver::results_type boostEndPoints = boostResolver.resolve(boost::asio::ip::tcp::v4(), vecField[0], vecField[1]);
-#ifdef FLY_REDIS_ENABLE_TLS
-    if (m_bUseTLSFlag)
+    return m_bConnected;
+}
+
+void CFlyRedisNetStream::StartAsyncConnect()
+{
+    m_bConnected = false;
+    m_bConnectTimeout = false;
+    // Read error of the last connection does not fail the new one
+    m_bReadError = false;
+    std::vector<std::string> vecField = CFlyRedis::SplitString(m_strRedisAddress, ':');
+    if (vecField.size() != 2)
     {
-        return ConnectAsTLS(boostEndPoints);
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "InvalidRedisAddress %s", m_strRedisAddress.c_str());
+        m_bConnecting = false;
+        return;
     }
-#endif // FLY_REDIS_ENABLE_TLS
-    return ConnectAsTCP(boostEndPoints);
+    m_bConnecting = true;
+    m_boostReadTimer.expires_after(std::chrono::milliseconds(m_nReadTimeoutMS));
+    m_boostReadTimer.async_wait(FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleConnectTimeout,
+        this,
+        boost::asio::placeholders::error,
+        ++m_nReadTimerSeq)));
+    m_boostResolver.async_resolve(boost::asio::ip::tcp::v4(), vecField[0], vecField[1],
+        FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleResolve,
+            this,
+            boost::asio::placeholders::error,
+            boost::asio::placeholders::results)));
 }
 
-bool CFlyRedisNetStream::ReadByLength(int nExpectedLen)
+bool CFlyRedisNetStream::ReadByLength(int nExpectedLen, const std::chrono::steady_clock::time_point& tpDeadline)
 {
-    if ((int)m_strGlobalRecvBuff.length() >= nExpectedLen)
+    if (GlobalRecvBuffLen() >= nExpectedLen)
     {
         return true;
     }
-    time_t nExpiredTime = time(nullptr) + m_nReadTimeoutSeconds;
-    while (time(nullptr) < nExpiredTime)
-    {
-        m_boostIOContext.restart();
-        StartAsyncRead();
-        m_boostIOContext.run_for(std::chrono::milliseconds(50));
-        if ((int)m_strGlobalRecvBuff.length() >= nExpectedLen)
-        {
-            break;
-        }
-    }
-    if ((int)m_strGlobalRecvBuff.size() < nExpectedLen)
+    WaitRecvBuff(nExpectedLen, tpDeadline);
+    if (GlobalRecvBuffLen() < nExpectedLen)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "Read Data From Redis Timeout");
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "Read Data From Redis %s, Address %s", m_bReadError ? "Failed" : "Timeout", m_strRedisAddress.c_str());
         return false;
     }
     return true;
@@ -92,14 +143,17 @@ bool CFlyRedisNetStream::ReadByLength(int nExpectedLen)
 
 bool CFlyRedisNetStream::ReadByTime(int nBlockMS)
 {
-    m_boostIOContext.restart();
-    StartAsyncRead();
-    m_boostIOContext.run_for(std::chrono::milliseconds(nBlockMS));
-    return !m_strGlobalRecvBuff.empty();
+    if (GlobalRecvBuffLen() <= 0)
+    {
+        WaitRecvBuff(1, std::chrono::steady_clock::now() + std::chrono::milliseconds(nBlockMS));
+    }
+    return GlobalRecvBuffLen() > 0;
 }
 
 bool CFlyRedisNetStream::Write(const char* buffWrite, size_t nBuffLen)
 {
+    // Reply view of the last request is dropped by the next request
+    m_bRecvBuffPinned = false;
     boost::system::error_code boostErrorCode;
     size_t nSendBytes = 0;
 #ifdef FLY_REDIS_ENABLE_TLS
@@ -124,73 +178,185 @@ bool CFlyRedisNetStream::Write(const char* buffWrite, size_t nBuffLen)
     return true;
 }
 
-#ifdef FLY_REDIS_ENABLE_TLS
-bool CFlyRedisNetStream::ConnectAsTLS(boost::asio::ip::tcp::resolver::results_type& boostEndPoints)
+bool CFlyRedisNetStream::Write(const std::string& strBuff, const std::vector<FlyRedisGatherParam>& vecGatherParam)
 {
+    if (vecGatherParam.empty())
+    {
+        return Write(strBuff.c_str(), strBuff.length());
+    }
+    // Segments of strBuff and gather params are interleaved by offset
+    m_vecGatherBuff.clear();
+    size_t nBuffLen = strBuff.length();
+    size_t nBuffPos = 0;
+    for (const FlyRedisGatherParam& stGatherParam : vecGatherParam)
+    {
+        if (stGatherParam.nOffset > nBuffPos)
+        {
+            m_vecGatherBuff.push_back(boost::asio::buffer(strBuff.data() + nBuffPos, stGatherParam.nOffset - nBuffPos));
+        }
+        m_vecGatherBuff.push_back(boost::asio::buffer(stGatherParam.strParam.data(), stGatherParam.strParam.size()));
+        nBuffPos = stGatherParam.nOffset;
+        nBuffLen += stGatherParam.strParam.size();
+    }
+    if (strBuff.length() > nBuffPos)
+    {
+        m_vecGatherBuff.push_back(boost::asio::buffer(strBuff.data() + nBuffPos, strBuff.length() - nBuffPos));
+    }
+    // Reply view of the last request is dropped by the next request
+    m_bRecvBuffPinned = false;
     boost::system::error_code boostErrorCode;
-    boost::asio::connect(m_boostTLSSocketStream.lowest_layer(), boostEndPoints, boostErrorCode);
+    size_t nSendBytes = 0;
+#ifdef FLY_REDIS_ENABLE_TLS
+    if (m_bUseTLSFlag)
+    {
+        nSendBytes = boost::asio::write(m_boostTLSSocketStream, m_vecGatherBuff, boostErrorCode);
+    }
+    else
+#endif // FLY_REDIS_ENABLE_TLS
+    {
+        nSendBytes = boost::asio::write(m_boostTCPSocketStream, m_vecGatherBuff, boostErrorCode);
+    }
+
     if (boostErrorCode)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "TLS Connect %s Failed As %s", m_strRedisAddress.c_str(), boostErrorCode.message().c_str());
         return false;
     }
-    m_strLocalIP = m_boostTLSSocketStream.lowest_layer().local_endpoint(boostErrorCode).to_string();
-    m_boostTLSSocketStream.handshake(boost::asio::ssl::stream_base::client, boostErrorCode);
-    if (boostErrorCode)
+    if (nBuffLen != nSendBytes)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "TLS HandShake %s Failed As %s", m_strRedisAddress.c_str(), boostErrorCode.message().c_str());
         return false;
     }
-    auto& refLoewstLayer = m_boostTLSSocketStream.lowest_layer();
-    refLoewstLayer.set_option(boost::asio::ip::tcp::socket::keep_alive());
-    // Try to recv first error msg after connect to redis-server
-    bool bResult = true;
-    int nTryCount = 0;
-    char buffRecv[1024] = { 0 };
-    while (++nTryCount < 10)
+    return true;
+}
+
+void CFlyRedisNetStream::StartAsyncReadLoop(const std::function<void(bool)>& fnReadHandler)
+{
+    m_fnReadHandler = fnReadHandler;
+    StartAsyncRead();
+}
+
+void CFlyRedisNetStream::AsyncWrite(const char* buffWrite, size_t nBuffLen, const std::function<void(bool)>& fnWriteHandler)
+{
+    // Write handler belongs to the owner of this stream, it is dropped with this stream
+    auto fnHandleWrite = FlyRedisGuardHandler(m_pAliveToken, [fnWriteHandler, nBuffLen](const boost::system::error_code& boostErrorCode, size_t nSendBytes) {
+        fnWriteHandler(!boostErrorCode && nBuffLen == nSendBytes);
+    });
+#ifdef FLY_REDIS_ENABLE_TLS
+    if (m_bUseTLSFlag)
     {
-        if (refLoewstLayer.available(boostErrorCode) > 0)
-        {
-            // If run to here, maybe the server is running in protected mode, which will response an error msg, just print it as error log and return false
-            m_boostTLSSocketStream.read_some(boost::asio::buffer(buffRecv, sizeof(buffRecv)), boostErrorCode);
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "TLS ConnectEndPointFailed %s As %s", m_strRedisAddress.c_str(), buffRecv);
-            bResult = false;
-            break;
-        }
-        boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+        boost::asio::async_write(m_boostTLSSocketStream, boost::asio::buffer(buffWrite, nBuffLen), fnHandleWrite);
+        return;
     }
-    return bResult;
+#endif // FLY_REDIS_ENABLE_TLS
+    boost::asio::async_write(m_boostTCPSocketStream, boost::asio::buffer(buffWrite, nBuffLen), fnHandleWrite);
 }
+
+void CFlyRedisNetStream::Close()
+{
+    m_fnReadHandler = nullptr;
+    m_bConnected = false;
+    m_bReadError = false;
+    boost::system::error_code boostCloseErrorCode;
+    m_boostResolver.cancel();
+#ifdef FLY_REDIS_ENABLE_TLS
+    m_boostTLSSocketStream.lowest_layer().close(boostCloseErrorCode);
 #endif // FLY_REDIS_ENABLE_TLS
+    m_boostTCPSocketStream.close(boostCloseErrorCode);
+}
 
-bool CFlyRedisNetStream::ConnectAsTCP(boost::asio::ip::tcp::resolver::results_type& boostEndPoints)
+void CFlyRedisNetStream::HandleResolve(const boost::system::error_code& boostErrorCode, const boost::asio::ip::tcp::resolver::results_type& boostEndPoints)
 {
-    boost::system::error_code boostErrorCode;
-    boost::asio::connect(m_boostTCPSocketStream, boostEndPoints, boostErrorCode);
-    if (boostErrorCode)
+    if (boostErrorCode || m_bConnectTimeout)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "Resolve %s Failed %s", m_strRedisAddress.c_str(), boostErrorCode.message().c_str());
+        FinishConnect(false);
+        return;
+    }
+#ifdef FLY_REDIS_ENABLE_TLS
+    if (m_bUseTLSFlag)
+    {
+        boost::asio::async_connect(m_boostTLSSocketStream.lowest_layer(), boostEndPoints,
+            FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleConnect,
+                this,
+                boost::asio::placeholders::error)));
+        return;
+    }
+#endif // FLY_REDIS_ENABLE_TLS
+    boost::asio::async_connect(m_boostTCPSocketStream, boostEndPoints,
+        FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleConnect,
+            this,
+            boost::asio::placeholders::error)));
+}
+
+void CFlyRedisNetStream::HandleConnect(const boost::system::error_code& boostErrorCode)
+{
+    if (boostErrorCode || m_bConnectTimeout)
     {
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "TCP Connect %s Failed %s", m_strRedisAddress.c_str(), boostErrorCode.message().c_str());
-        return false;
+        FinishConnect(false);
+        return;
     }
-    m_strLocalIP = m_boostTCPSocketStream.local_endpoint(boostErrorCode).address().to_string(boostErrorCode);
-    m_boostTCPSocketStream.set_option(boost::asio::ip::tcp::socket::keep_alive());
-    // Try to recv first error msg after connect to redis-server
-    bool bResult = true;
-    int nTryCount = 0;
-    char buffRecv[1024] = { 0 };
-    while (++nTryCount < 10)
+    // The error msg of protected mode will be the response of handshake, there is no need to wait for it here
+    boost::system::error_code boostLocalErrorCode;
+#ifdef FLY_REDIS_ENABLE_TLS
+    if (m_bUseTLSFlag)
     {
-        if (m_boostTCPSocketStream.available(boostErrorCode) > 0)
-        {
-            // If run to here, maybe the server is running in protected mode, which will response an error msg, just print it as error log and return false
-            m_boostTCPSocketStream.read_some(boost::asio::buffer(buffRecv, sizeof(buffRecv)));
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "TCP ConnectEndPointFailed: %s As %s", m_strRedisAddress.c_str(), buffRecv);
-            bResult = false;
-            break;
-        }
-        boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+        auto& refLoewstLayer = m_boostTLSSocketStream.lowest_layer();
+        m_strLocalIP = refLoewstLayer.local_endpoint(boostLocalErrorCode).address().to_string(boostLocalErrorCode);
+        refLoewstLayer.set_option(boost::asio::ip::tcp::socket::keep_alive(), boostLocalErrorCode);
+        m_boostTLSSocketStream.async_handshake(boost::asio::ssl::stream_base::client,
+            FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleTLSHandshake,
+                this,
+                boost::asio::placeholders::error)));
+        return;
+    }
+#endif // FLY_REDIS_ENABLE_TLS
+    m_strLocalIP = m_boostTCPSocketStream.local_endpoint(boostLocalErrorCode).address().to_string(boostLocalErrorCode);
+    m_boostTCPSocketStream.set_option(boost::asio::ip::tcp::socket::keep_alive(), boostLocalErrorCode);
+    FinishConnect(true);
+}
+
+#ifdef FLY_REDIS_ENABLE_TLS
+void CFlyRedisNetStream::HandleTLSHandshake(const boost::system::error_code& boostErrorCode)
+{
+    if (boostErrorCode || m_bConnectTimeout)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "TLS HandShake %s Failed As %s", m_strRedisAddress.c_str(), boostErrorCode.message().c_str());
+        FinishConnect(false);
+        return;
+    }
+    FinishConnect(true);
+}
+#endif // FLY_REDIS_ENABLE_TLS
+
+void CFlyRedisNetStream::HandleConnectTimeout(const boost::system::error_code& boostErrorCode, unsigned int nReadTimerSeq)
+{
+    if (boostErrorCode || nReadTimerSeq != m_nReadTimerSeq || !m_bConnecting)
+    {
+        return;
+    }
+    // Abort the pending operation, its handler finishes the connect
+    CFlyRedis::Logger(FlyRedisLogLevel::Error, "Connect %s Timeout", m_strRedisAddress.c_str());
+    m_bConnectTimeout = true;
+    boost::system::error_code boostCloseErrorCode;
+    m_boostResolver.cancel();
+#ifdef FLY_REDIS_ENABLE_TLS
+    m_boostTLSSocketStream.lowest_layer().close(boostCloseErrorCode);
+#endif // FLY_REDIS_ENABLE_TLS
+    m_boostTCPSocketStream.close(boostCloseErrorCode);
+}
+
+void CFlyRedisNetStream::FinishConnect(bool bConnected)
+{
+    m_bConnecting = false;
+    m_bConnected = bConnected;
+    // The canceled handler will be ignored by its seq
+    m_boostReadTimer.cancel();
+    if (m_fnConnectHandler)
+    {
+        std::function<void(bool)> fnConnectHandler;
+        fnConnectHandler.swap(m_fnConnectHandler);
+        fnConnectHandler(bConnected);
     }
-    return bResult;
 }
 
 void CFlyRedisNetStream::HandleRead(const boost::system::error_code& boostErrorCode, size_t nBytesTransferred)
@@ -198,17 +364,70 @@ void CFlyRedisNetStream::HandleRead(const boost::system::error_code& boostErrorC
     //std::string strReadBuff;
     //strReadBuff.append(m_caThisbuffRecv, nBytesTransferred);
     m_bInAsyncRead = false;
+    // Read loop handler is copied, so it can be reset by Close in itself
+    std::function<void(bool)> fnReadHandler = m_fnReadHandler;
     if (boostErrorCode)
     {
+        m_bReadError = true;
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "HandleRead Error, Msg %s, Address %s", boostErrorCode.message().c_str(), m_strRedisAddress.c_str());
+        if (fnReadHandler)
+        {
+            fnReadHandler(false);
+        }
         return;
     }
     if (0 == nBytesTransferred)
     {
+        m_bReadError = true;
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "HandleRead Error, ByteTransfer Is 0, Address %s", m_strRedisAddress.c_str());
+        if (fnReadHandler)
+        {
+            fnReadHandler(false);
+        }
         return;
     }
-    m_strGlobalRecvBuff.append(m_caThisbuffRecv, nBytesTransferred);
+    AppendRecvBuff(m_caThisbuffRecv, nBytesTransferred);
+    if (fnReadHandler)
+    {
+        // Owner of this stream may be deleted by the read handler
+        std::weak_ptr<bool> pAliveToken = m_pAliveToken;
+        fnReadHandler(true);
+        if (!pAliveToken.expired() && m_fnReadHandler)
+        {
+            StartAsyncRead();
+        }
+    }
+}
+
+void CFlyRedisNetStream::HandleReadTimeout(const boost::system::error_code& boostErrorCode, unsigned int nReadTimerSeq)
+{
+    if (boostErrorCode || nReadTimerSeq != m_nReadTimerSeq)
+    {
+        return;
+    }
+    m_bReadTimeout = true;
+}
+
+void CFlyRedisNetStream::WaitRecvBuff(int nExpectedLen, const std::chrono::steady_clock::time_point& tpDeadline)
+{
+    m_bReadTimeout = false;
+    m_boostReadTimer.expires_at(tpDeadline);
+    m_boostReadTimer.async_wait(FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleReadTimeout,
+        this,
+        boost::asio::placeholders::error,
+        ++m_nReadTimerSeq)));
+    m_boostIOContext.restart();
+    // Every completed read is checked at once, so it returns as soon as enough data arrived
+    while (GlobalRecvBuffLen() < nExpectedLen && !m_bReadTimeout && !m_bReadError)
+    {
+        StartAsyncRead();
+        if (0 == m_boostIOContext.run_one())
+        {
+            break;
+        }
+    }
+    // The canceled handler will be ignored by its seq
+    m_boostReadTimer.cancel();
 }
 
 void CFlyRedisNetStream::StartAsyncRead()
@@ -222,730 +441,3270 @@ void CFlyRedisNetStream::StartAsyncRead()
     if (m_bUseTLSFlag)
     {
         m_boostTLSSocketStream.async_read_some(boost::asio::buffer(m_caThisbuffRecv, sizeof(m_caThisbuffRecv)),
-            boost::bind(&CFlyRedisNetStream::HandleRead,
+            FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleRead,
                 this,
                 boost::asio::placeholders::error,
-                boost::asio::placeholders::bytes_transferred));
+                boost::asio::placeholders::bytes_transferred)));
     }
     else
 #endif // FLY_REDIS_ENABLE_TLS
     {
         m_boostTCPSocketStream.async_read_some(boost::asio::buffer(m_caThisbuffRecv, sizeof(m_caThisbuffRecv)),
-            boost::bind(&CFlyRedisNetStream::HandleRead,
+            FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisNetStream::HandleRead,
                 this,
                 boost::asio::placeholders::error,
-                boost::asio::placeholders::bytes_transferred));
+                boost::asio::placeholders::bytes_transferred)));
     }
 }
 
-// End of CFlyRedisNetStream
-//////////////////////////////////////////////////////////////////////////
-// Begin of RedisSession function
-#ifdef FLY_REDIS_ENABLE_TLS
-CFlyRedisSession::CFlyRedisSession(boost::asio::io_context& boostIOContext, bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext)
-    :m_hNetStream(boostIOContext, bUseTLSFlag, boostTLSContext)
+void CFlyRedisNetStream::AppendRecvBuff(const char* buffRecv, size_t nBuffLen)
 {
+    // Pinned recv buff is only appended, so offset of data in it is stable
+    if (m_bRecvBuffPinned)
+    {
+        m_strGlobalRecvBuff.append(buffRecv, nBuffLen);
+        return;
+    }
+    if (m_nRecvBuffReadPos == m_strGlobalRecvBuff.length())
+    {
+        // Everything has been consumed, reuse the buff from the beginning
+        m_strGlobalRecvBuff.clear();
+        m_nRecvBuffReadPos = 0;
+    }
+    else if (m_nRecvBuffReadPos >= 4096 && m_nRecvBuffReadPos >= m_strGlobalRecvBuff.length() - m_nRecvBuffReadPos)
+    {
+        // Only move the unconsumed tail when the consumed head is larger than it, so the cost is linear
+        m_strGlobalRecvBuff.erase(0, m_nRecvBuffReadPos);
+        m_nRecvBuffReadPos = 0;
+    }
+    m_strGlobalRecvBuff.append(buffRecv, nBuffLen);
 }
-#else
-CFlyRedisSession::CFlyRedisSession(boost::asio::io_context& boostIOContext)
-    :m_hNetStream(boostIOContext)
+
+// End of CFlyRedisNetStream
+//////////////////////////////////////////////////////////////////////////
+// Begin of CFlyRedisRESPParser
+CFlyRedisRESPParser::CFlyRedisRESPParser()
 {
 }
-#endif // FLY_REDIS_ENABLE_TLS
 
-CFlyRedisSession::~CFlyRedisSession()
+void CFlyRedisRESPParser::Reset()
 {
+    m_vecAggregateFrame.clear();
+    m_chPendingBulkType = 0;
+    m_nPendingBulkLen = -1;
+    m_nExpectedLen = 1;
+    m_chReplyType = 0;
 }
 
-void CFlyRedisSession::SetRedisAddress(const std::string& strAddress)
+FlyRedisRESPParseResult CFlyRedisRESPParser::Parse(const char* pBuff, size_t nBuffLen, size_t& nConsumed, CFlyRedisRESPHandler& hHandler)
 {
-    m_hNetStream.SetRedisAddress(strAddress);
+    nConsumed = 0;
+    while (true)
+    {
+        const char* pCur = pBuff + nConsumed;
+        size_t nRemainLen = nBuffLen - nConsumed;
+        if (m_nPendingBulkLen >= 0)
+        {
+            // Bulk payload and its tail CRLF
+            size_t nNeedLen = (size_t)m_nPendingBulkLen + 2;
+            if (nRemainLen < nNeedLen)
+            {
+                m_nExpectedLen = static_cast<int>(nNeedLen);
+                return FlyRedisRESPParseResult::NeedMoreData;
+            }
+            if (pCur[m_nPendingBulkLen] != '\r' || pCur[m_nPendingBulkLen + 1] != '\n')
+            {
+                return FlyRedisRESPParseResult::ProtocolError;
+            }
+            char chType = m_chPendingBulkType;
+            m_nPendingBulkLen = -1;
+            nConsumed += nNeedLen;
+            hHandler.OnRESPValue(chType, pCur, nNeedLen - 2);
+            if (FinishValue(hHandler))
+            {
+                return FlyRedisRESPParseResult::Complete;
+            }
+            continue;
+        }
+        // Scan the whole line, the head char is the type
+        const char* pLineEnd = CFlyRedis::FindDelim(pCur, pBuff + nBuffLen, '\r');
+        if (pLineEnd + 1 >= pBuff + nBuffLen)
+        {
+            m_nExpectedLen = static_cast<int>(nRemainLen) + 1;
+            return FlyRedisRESPParseResult::NeedMoreData;
+        }
+        if (pLineEnd[1] != '\n' || pLineEnd == pCur)
+        {
+            return FlyRedisRESPParseResult::ProtocolError;
+        }
+        char chType = pCur[0];
+        const char* pLineData = pCur + 1;
+        size_t nLineDataLen = pLineEnd - pLineData;
+        nConsumed += (pLineEnd + 2) - pCur;
+        // Attribute is not the reply, the value after it is
+        if (m_vecAggregateFrame.empty() && '|' != chType)
+        {
+            m_chReplyType = chType;
+        }
+        switch (chType)
+        {
+        case '+': // Simple Strings
+        case '-': // Errors
+        case ':': // Integers
+        case ',': // Double
+        case '_': // Null
+        case '#': // Boolean
+        case '(': // BigNumber
+            hHandler.OnRESPValue(chType, ('_' == chType) ? nullptr : pLineData, nLineDataLen);
+            if (FinishValue(hHandler))
+            {
+                return FlyRedisRESPParseResult::Complete;
+            }
+            break;
+        case '$': // Bulk Strings
+        case '!': // BlobError
+        case '=': // VerbatimString
+        {
+            int nLen = 0;
+            if (!ParseLength(pLineData, pLineEnd, nLen))
+            {
+                return FlyRedisRESPParseResult::ProtocolError;
+            }
+            if (nLen < 0)
+            {
+                if (m_vecAggregateFrame.empty())
+                {
+                    m_chReplyType = '_';
+                }
+                hHandler.OnRESPValue(chType, nullptr, 0);
+                if (FinishValue(hHandler))
+                {
+                    return FlyRedisRESPParseResult::Complete;
+                }
+                break;
+            }
+            // If BulkStrings over than 512M, just return false. according the Redis document, the max length should be 512M
+            if (nLen >= 1024 * 1024 * 512)
+            {
+                CFlyRedis::Logger(FlyRedisLogLevel::Error, "Len OverThan 512M: %d", nLen);
+                return FlyRedisRESPParseResult::ProtocolError;
+            }
+            m_chPendingBulkType = chType;
+            m_nPendingBulkLen = nLen;
+            break;
+        }
+        case '*': // Array
+        case '%': // Map
+        case '~': // Set
+        case '|': // Attribute
+        case '>': // Push
+        {
+            int nCount = 0;
+            if (!ParseLength(pLineData, pLineEnd, nCount))
+            {
+                return FlyRedisRESPParseResult::ProtocolError;
+            }
+            if (nCount < 0)
+            {
+                if (m_vecAggregateFrame.empty())
+                {
+                    m_chReplyType = '_';
+                }
+                hHandler.OnRESPValue(chType, nullptr, 0);
+                if (FinishValue(hHandler))
+                {
+                    return FlyRedisRESPParseResult::Complete;
+                }
+                break;
+            }
+            hHandler.OnRESPAggregateBegin(chType, nCount);
+            int nElementCount = ('%' == chType || '|' == chType) ? nCount * 2 : nCount;
+            if (0 == nElementCount)
+            {
+                hHandler.OnRESPAggregateEnd(chType);
+                if ('|' != chType && FinishValue(hHandler))
+                {
+                    return FlyRedisRESPParseResult::Complete;
+                }
+                break;
+            }
+            AggregateFrame stFrame;
+            stFrame.chType = chType;
+            stFrame.nRemainCount = nElementCount;
+            m_vecAggregateFrame.emplace_back(stFrame);
+            break;
+        }
+        default:
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "Unknown HeadCharacter, Char: %d", (int)chType);
+            return FlyRedisRESPParseResult::ProtocolError;
+        }
+    }
 }
 
-const std::string& CFlyRedisSession::GetRedisAddr() const
+bool CFlyRedisRESPParser::FinishValue(CFlyRedisRESPHandler& hHandler)
 {
-    return m_hNetStream.GetRedisAddr();
+    while (!m_vecAggregateFrame.empty())
+    {
+        AggregateFrame& refFrame = m_vecAggregateFrame.back();
+        if (--refFrame.nRemainCount > 0)
+        {
+            return false;
+        }
+        char chType = refFrame.chType;
+        m_vecAggregateFrame.pop_back();
+        hHandler.OnRESPAggregateEnd(chType);
+        // Attribute is followed by the value which it describes, so it is not a value itself
+        if ('|' == chType)
+        {
+            return false;
+        }
+    }
+    m_nExpectedLen = 1;
+    return true;
 }
 
-bool CFlyRedisSession::Connect()
+void CFlyRedisRESPParser::SkipVerbatimFormat(char chType, const char*& pData, size_t& nLen)
 {
-    return m_hNetStream.Connect();
+    // Format is 3 chars and ':', as "=15\r\ntxt:Some string\r\n"
+    if ('=' == chType && nullptr != pData && nLen >= 4 && ':' == pData[3])
+    {
+        pData += 4;
+        nLen -= 4;
+    }
 }
 
-bool CFlyRedisSession::AcceptHashSlot(int nSlot, bool bIsWrite, FlyRedisReadWriteType nFlyRedisReadWriteType) const
+bool CFlyRedisRESPParser::ParseLength(const char* pBegin, const char* pEnd, int& nLength)
 {
-    if (FlyRedisReadWriteType::ReadOnSlaveWriteOnMaster == nFlyRedisReadWriteType && bIsWrite != m_bIsMasterNode)
+    bool bNegative = false;
+    if (pBegin < pEnd && '-' == *pBegin)
+    {
+        bNegative = true;
+        ++pBegin;
+    }
+    if (pBegin == pEnd)
     {
         return false;
     }
-    return nSlot >= m_nMinSlot && nSlot <= m_nMaxSlot;
+    long long nValue = 0;
+    for (; pBegin < pEnd; ++pBegin)
+    {
+        if (*pBegin < '0' || *pBegin > '9')
+        {
+            return false;
+        }
+        nValue = nValue * 10 + (*pBegin - '0');
+        if (nValue > 0x7FFFFFFF)
+        {
+            return false;
+        }
+    }
+    nLength = static_cast<int>(bNegative ? -nValue : nValue);
+    return true;
 }
 
-void CFlyRedisSession::SetSelfSlotRange(int nMinSlot, int nMaxSlot)
+// End of CFlyRedisRESPParser
+//////////////////////////////////////////////////////////////////////////
+// Begin of CFlyRedisResponseBuilder
+CFlyRedisResponseBuilder::CFlyRedisResponseBuilder(FlyRedisResponse& stRedisResponse, const std::string& strRedisAddress)
+    :m_stRedisResponse(stRedisResponse),
+    m_strRedisAddress(strRedisAddress)
 {
-    m_nMinSlot = nMinSlot;
-    m_nMaxSlot = nMaxSlot;
 }
 
-bool CFlyRedisSession::ProcRedisRequest(const std::string& strRedisCmdRequest)
+void CFlyRedisResponseBuilder::OnRESPValue(char chType, const char* pData, size_t nLen)
 {
-    // Build RedisCmdRequest String
-    m_stRedisResponse.Reset();
-    m_bRedisResponseError = false;
-    // Send Msg To RedisServer
-    m_hNetStream.Write(strRedisCmdRequest.c_str(), strRedisCmdRequest.length());
-    if (!RecvRedisResponse())
+    // INFO of RESP3 is VerbatimString, its format prefix is not a part of the text
+    CFlyRedisRESPParser::SkipVerbatimFormat(chType, pData, nLen);
+    std::string& strRedisResponse = m_stRedisResponse.strRedisResponse;
+    strRedisResponse.clear();
+    if (nullptr != pData)
     {
-        return false;
+        strRedisResponse.append(pData, nLen);
     }
-    return !m_bRedisResponseError;
+    if ('-' == chType || '!' == chType)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisResponseError %s", strRedisResponse.c_str());
+        m_bRedisResponseError = true;
+        m_strLastResponseErrorMsg = strRedisResponse;
+    }
+    else if (nullptr != pData || '$' == chType || '_' == chType)
+    {
+        // Null bulk string was filled as empty string, HGET maybe return it
+        m_stRedisResponse.vecRedisResponse.emplace_back(strRedisResponse);
+    }
+    FinishElement();
+}
+
+void CFlyRedisResponseBuilder::OnRESPAggregateBegin(char chType, int /*nCount*/)
+{
+    m_stRedisResponse.strRedisResponse.clear();
+    m_vecAggregateType.emplace_back(chType);
+    m_vecExpectMapValue.emplace_back(false);
+}
+
+void CFlyRedisResponseBuilder::OnRESPAggregateEnd(char /*chType*/)
+{
+    m_vecAggregateType.pop_back();
+    m_vecExpectMapValue.pop_back();
+    FinishElement();
+}
+
+void CFlyRedisResponseBuilder::FinishElement()
+{
+    if (m_vecAggregateType.empty())
+    {
+        return;
+    }
+    switch (m_vecAggregateType.back())
+    {
+    case '%':
+    case '|':
+        if (!m_vecExpectMapValue.back())
+        {
+            m_strMapKey.swap(m_stRedisResponse.strRedisResponse);
+            m_vecExpectMapValue.back() = true;
+        }
+        else
+        {
+            std::string strValue;
+            strValue.swap(m_stRedisResponse.strRedisResponse);
+            m_stRedisResponse.mapRedisResponse.emplace(std::move(m_strMapKey), std::move(strValue));
+            m_vecExpectMapValue.back() = false;
+        }
+        break;
+    case '~':
+        m_stRedisResponse.setRedisResponse.emplace(m_stRedisResponse.strRedisResponse);
+        break;
+    default:
+        break;
+    }
+}
+
+// End of CFlyRedisResponseBuilder
+//////////////////////////////////////////////////////////////////////////
+// Begin of CFlyRedisReplyBuilder
+CFlyRedisReplyArena::CFlyRedisReplyArena(size_t nBlockLen)
+    :m_nBlockLen(nBlockLen)
+{
+}
+
+void* CFlyRedisReplyArena::Allocate(size_t nLen, size_t nAlign)
+{
+    while (true)
+    {
+        if (m_nBlockIndex < m_vecArenaBlock.size())
+        {
+            ArenaBlock& stArenaBlock = m_vecArenaBlock[m_nBlockIndex];
+            size_t nOffset = (m_nBlockOffset + nAlign - 1) & ~(nAlign - 1);
+            if (nOffset + nLen <= stArenaBlock.nLen)
+            {
+                m_nBlockOffset = nOffset + nLen;
+                m_nAllocatedLen += nLen;
+                return stArenaBlock.pData.get() + nOffset;
+            }
+            // The tail of this block is wasted, it is reused after Reset
+            if (m_nBlockIndex + 1 < m_vecArenaBlock.size())
+            {
+                ++m_nBlockIndex;
+                m_nBlockOffset = 0;
+                continue;
+            }
+        }
+        // Large payload gets a block of its own size, it is released by Reset
+        ArenaBlock stArenaBlock;
+        stArenaBlock.nLen = std::max(m_nBlockLen, nLen + nAlign);
+        stArenaBlock.pData.reset(new char[stArenaBlock.nLen]);
+        m_vecArenaBlock.emplace_back(std::move(stArenaBlock));
+        m_nBlockIndex = m_vecArenaBlock.size() - 1;
+        m_nBlockOffset = 0;
+    }
+}
+
+const char* CFlyRedisReplyArena::CopyString(const char* pData, size_t nLen)
+{
+    char* pCopy = static_cast<char*>(Allocate(nLen + 1, 1));
+    memcpy(pCopy, pData, nLen);
+    pCopy[nLen] = '\0';
+    return pCopy;
+}
+
+void CFlyRedisReplyArena::Reset()
+{
+    size_t nKeepCount = 0;
+    for (size_t nIndex = 0; nIndex < m_vecArenaBlock.size(); ++nIndex)
+    {
+        if (m_vecArenaBlock[nIndex].nLen <= m_nBlockLen)
+        {
+            if (nKeepCount != nIndex)
+            {
+                m_vecArenaBlock[nKeepCount] = std::move(m_vecArenaBlock[nIndex]);
+            }
+            ++nKeepCount;
+        }
+    }
+    m_vecArenaBlock.resize(nKeepCount);
+    m_nBlockIndex = 0;
+    m_nBlockOffset = 0;
+    m_nAllocatedLen = 0;
+}
+
+CFlyRedisReplyBuilder::CFlyRedisReplyBuilder()
+    :m_hReplyArena(16 * 1024)
+{
+}
+
+void CFlyRedisReplyBuilder::Reset()
+{
+    m_hReplyArena.Reset();
+    m_pReply = nullptr;
+    m_vecAggregateFrame.clear();
+    m_nDropDepth = 0;
+    m_nFlattenDepth = 0;
+    m_bRedisResponseError = false;
+    m_vecReplyViewOffset.clear();
+}
+
+void CFlyRedisReplyBuilder::ResolveReplyView()
+{
+    if (nullptr == m_pRecvBuff)
+    {
+        return;
+    }
+    const char* pRecvBuff = m_pRecvBuff->data();
+    for (auto& pairReplyViewOffset : m_vecReplyViewOffset)
+    {
+        pairReplyViewOffset.first->pData = pRecvBuff + pairReplyViewOffset.second;
+    }
+    m_vecReplyViewOffset.clear();
+}
+
+void CFlyRedisReplyBuilder::OnRESPValue(char chType, const char* pData, size_t nLen)
+{
+    if (m_nDropDepth > 0)
+    {
+        return;
+    }
+    // Text of VerbatimString is returned as Bulk, its format prefix is dropped
+    CFlyRedisRESPParser::SkipVerbatimFormat(chType, pData, nLen);
+    bool bIsReply = m_vecAggregateFrame.empty();
+    if (m_fnElementVisitor && !bIsReply)
+    {
+        ++m_vecAggregateFrame.back().nFilledCount;
+        m_fnElementVisitor((nullptr != pData) ? boost::string_view(pData, nLen) : boost::string_view());
+        return;
+    }
+    FlyRedisReplyNode* pNode = NextReplyNode();
+    if (nullptr == pNode)
+    {
+        return;
+    }
+    if (nullptr == pData)
+    {
+        pNode->nType = FlyRedisReplyType::Null;
+        return;
+    }
+    if (m_bReplyView && nullptr != m_pRecvBuff)
+    {
+        // Data is valid until the next read, scalar is parsed now and string is resolved when the reply is complete
+        pNode->pData = pData;
+        m_vecReplyViewOffset.emplace_back(pNode, pData - m_pRecvBuff->data());
+    }
+    else
+    {
+        pNode->pData = m_hReplyArena.CopyString(pData, nLen);
+    }
+    pNode->nLen = nLen;
+    switch (chType)
+    {
+    case '+':
+        pNode->nType = FlyRedisReplyType::Status;
+        break;
+    case '-':
+    case '!':
+        pNode->nType = FlyRedisReplyType::Error;
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisResponseError %.*s", static_cast<int>(nLen), pData);
+        if (bIsReply)
+        {
+            m_bRedisResponseError = true;
+            m_strLastResponseErrorMsg.assign(pData, nLen);
+        }
+        break;
+    case ':':
+        pNode->nType = FlyRedisReplyType::Int;
+        CFlyRedisNumberCodec::DecodeInt(pNode->pData, pNode->pData + pNode->nLen, pNode->nInt);
+        break;
+    case ',':
+        pNode->nType = FlyRedisReplyType::Double;
+        CFlyRedisNumberCodec::DecodeDouble(pNode->pData, pNode->pData + pNode->nLen, pNode->fDouble);
+        break;
+    case '#':
+        pNode->nType = FlyRedisReplyType::Bool;
+        pNode->nInt = ('t' == pNode->pData[0]) ? 1 : 0;
+        break;
+    case '(':
+        pNode->nType = FlyRedisReplyType::BigNumber;
+        break;
+    default:
+        pNode->nType = FlyRedisReplyType::Bulk;
+        break;
+    }
+}
+
+void CFlyRedisReplyBuilder::OnRESPAggregateBegin(char chType, int nCount)
+{
+    if ('|' == chType || m_nDropDepth > 0)
+    {
+        ++m_nDropDepth;
+        return;
+    }
+    // Element of top level aggregate is not kept in visit mode, so its nested aggregate is flattened
+    if (m_fnElementVisitor && !m_vecAggregateFrame.empty())
+    {
+        // First element is nested aggregate, such as member and score pair of RESP3 WITHSCORES, the flattened count is visited again
+        AggregateFrame& refFrame = m_vecAggregateFrame.back();
+        if (0 == m_nFlattenDepth && 0 == refFrame.nFilledCount && m_fnElementCountVisitor)
+        {
+            long long nFlattenCount = static_cast<long long>(refFrame.pNode->GetElementCount()) * (('%' == chType) ? nCount * 2LL : nCount);
+            if (nFlattenCount <= std::numeric_limits<int>::max())
+            {
+                m_fnElementCountVisitor(static_cast<int>(nFlattenCount));
+            }
+        }
+        ++m_nFlattenDepth;
+        return;
+    }
+    FlyRedisReplyNode* pNode = NextReplyNode();
+    if (nullptr == pNode)
+    {
+        return;
+    }
+    switch (chType)
+    {
+    case '%':
+        pNode->nType = FlyRedisReplyType::Map;
+        break;
+    case '~':
+        pNode->nType = FlyRedisReplyType::Set;
+        break;
+    case '>':
+        pNode->nType = FlyRedisReplyType::Push;
+        break;
+    default:
+        pNode->nType = FlyRedisReplyType::Array;
+        break;
+    }
+    pNode->nCount = nCount;
+    // Element count is known by the header, so every element is allocated at once
+    int nElementCount = pNode->GetElementCount();
+    if (nElementCount > 0 && m_fnElementVisitor)
+    {
+        if (m_fnElementCountVisitor)
+        {
+            m_fnElementCountVisitor(nElementCount);
+        }
+    }
+    else if (nElementCount > 0)
+    {
+        FlyRedisReplyNode* pElement = static_cast<FlyRedisReplyNode*>(m_hReplyArena.Allocate(sizeof(FlyRedisReplyNode) * nElementCount, alignof(FlyRedisReplyNode)));
+        for (int nIndex = 0; nIndex < nElementCount; ++nIndex)
+        {
+            new (pElement + nIndex) FlyRedisReplyNode();
+        }
+        pNode->pElement = pElement;
+    }
+    AggregateFrame stFrame;
+    stFrame.pNode = pNode;
+    stFrame.nFilledCount = 0;
+    m_vecAggregateFrame.emplace_back(stFrame);
+}
+
+void CFlyRedisReplyBuilder::OnRESPAggregateEnd(char /*chType*/)
+{
+    if (m_nDropDepth > 0)
+    {
+        --m_nDropDepth;
+        return;
+    }
+    if (m_nFlattenDepth > 0)
+    {
+        --m_nFlattenDepth;
+        return;
+    }
+    if (!m_vecAggregateFrame.empty())
+    {
+        m_vecAggregateFrame.pop_back();
+    }
+}
+
+FlyRedisReplyNode* CFlyRedisReplyBuilder::NextReplyNode()
+{
+    if (m_vecAggregateFrame.empty())
+    {
+        m_pReply = new (m_hReplyArena.Allocate(sizeof(FlyRedisReplyNode), alignof(FlyRedisReplyNode))) FlyRedisReplyNode();
+        return m_pReply;
+    }
+    AggregateFrame& refFrame = m_vecAggregateFrame.back();
+    if (refFrame.nFilledCount >= refFrame.pNode->GetElementCount())
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ReplyElementOverflow %d", refFrame.nFilledCount);
+        return nullptr;
+    }
+    return refFrame.pNode->pElement + refFrame.nFilledCount++;
+}
+
+// End of CFlyRedisReplyBuilder
+//////////////////////////////////////////////////////////////////////////
+// Begin of CFlyRedisClusterTopologyBuilder
+int FlyRedisClusterTopology::AddRedisNode(const std::string& strRedisAddress, bool bIsMaster)
+{
+    for (size_t nIndex = 0; nIndex < vecRedisAddress.size(); ++nIndex)
+    {
+        if (vecRedisAddress[nIndex] == strRedisAddress)
+        {
+            return static_cast<int>(nIndex);
+        }
+    }
+    vecRedisAddress.emplace_back(strRedisAddress);
+    vecMasterFlag.emplace_back(bIsMaster);
+    return static_cast<int>(vecRedisAddress.size()) - 1;
+}
+
+CFlyRedisClusterTopologyBuilder::CFlyRedisClusterTopologyBuilder(FlyRedisClusterTopology& stClusterTopology, const std::string& strRedisAddress, bool bIsShardsReply)
+    :m_stClusterTopology(stClusterTopology),
+    m_strDefaultHost(strRedisAddress.substr(0, strRedisAddress.rfind(':'))),
+    m_bIsShardsReply(bIsShardsReply)
+{
+}
+
+void CFlyRedisClusterTopologyBuilder::OnRESPValue(char chType, const char* pData, size_t nLen)
+{
+    std::string strValue;
+    if (nullptr != pData)
+    {
+        strValue.assign(pData, nLen);
+    }
+    if ('-' == chType || '!' == chType)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisResponseError %s", strValue.c_str());
+        m_bRedisResponseError = true;
+        return;
+    }
+    size_t nDepth = m_vecElementIndex.size();
+    int nIndex = m_vecElementIndex.empty() ? 0 : m_vecElementIndex.back();
+    if (!m_bIsShardsReply)
+    {
+        // CLUSTER SLOTS: [[min, max, [host, port, id], [host, port, id]...]...], the first node is master
+        if (2 == nDepth && nIndex < 2)
+        {
+            m_vecSlotValue.emplace_back(atoi(strValue.c_str()));
+        }
+        else if (3 == nDepth && 0 == nIndex)
+        {
+            m_strNodeHost = strValue;
+        }
+        else if (3 == nDepth && 1 == nIndex)
+        {
+            m_strNodePort = strValue;
+        }
+    }
+    else if (2 == nDepth)
+    {
+        // CLUSTER SHARDS: [{slots: [min, max...], nodes: [{endpoint: host, ip: ip, port: port, role: master...}...]}...]
+        if (0 == nIndex % 2)
+        {
+            m_strMapKey = strValue;
+        }
+    }
+    else if (3 == nDepth)
+    {
+        if (0 == m_strMapKey.compare("slots"))
+        {
+            m_vecSlotValue.emplace_back(atoi(strValue.c_str()));
+        }
+    }
+    else if (4 == nDepth)
+    {
+        if (0 == nIndex % 2)
+        {
+            m_strNodeKey = strValue;
+        }
+        else if (0 == m_strNodeKey.compare("endpoint"))
+        {
+            m_strNodeHost = strValue;
+        }
+        else if (0 == m_strNodeKey.compare("ip"))
+        {
+            m_strNodeIP = strValue;
+        }
+        else if (0 == m_strNodeKey.compare("port") || (0 == m_strNodeKey.compare("tls-port") && m_strNodePort.empty()))
+        {
+            m_strNodePort = strValue;
+        }
+        else if (0 == m_strNodeKey.compare("role"))
+        {
+            m_bNodeIsMaster = (0 == strValue.compare("master"));
+        }
+        else if (0 == m_strNodeKey.compare("health"))
+        {
+            m_bNodeIsOnline = (0 == strValue.compare("online"));
+        }
+    }
+    if (!m_vecElementIndex.empty())
+    {
+        ++m_vecElementIndex.back();
+    }
+}
+
+void CFlyRedisClusterTopologyBuilder::OnRESPAggregateBegin(char /*chType*/, int /*nCount*/)
+{
+    m_vecElementIndex.emplace_back(0);
+}
+
+void CFlyRedisClusterTopologyBuilder::OnRESPAggregateEnd(char /*chType*/)
+{
+    size_t nDepth = m_vecElementIndex.size();
+    m_vecElementIndex.pop_back();
+    // Index of the finished aggregate in its parent
+    int nIndex = m_vecElementIndex.empty() ? 0 : m_vecElementIndex.back();
+    if (2 == nDepth)
+    {
+        FinishSlotRange();
+    }
+    else if (!m_bIsShardsReply && 3 == nDepth && nIndex >= 2)
+    {
+        FinishRedisNode(2 == nIndex);
+    }
+    else if (m_bIsShardsReply && 4 == nDepth && 0 == m_strMapKey.compare("nodes"))
+    {
+        FinishRedisNode(m_bNodeIsMaster);
+    }
+    if (!m_vecElementIndex.empty())
+    {
+        ++m_vecElementIndex.back();
+    }
+}
+
+void CFlyRedisClusterTopologyBuilder::FinishRedisNode(bool bIsMaster)
+{
+    // Unknown endpoint is replied as empty or ?, it is the same host as the queried node
+    std::string strHost = m_strNodeHost;
+    if (strHost.empty() || 0 == strHost.compare("?"))
+    {
+        strHost = m_strNodeIP;
+    }
+    if (strHost.empty() || 0 == strHost.compare("?"))
+    {
+        strHost = m_strDefaultHost;
+    }
+    if (!m_strNodePort.empty() && (bIsMaster || m_bNodeIsOnline))
+    {
+        int nNodeIndex = m_stClusterTopology.AddRedisNode(strHost + ":" + m_strNodePort, bIsMaster);
+        if (bIsMaster)
+        {
+            m_nMasterIndex = nNodeIndex;
+        }
+        else if (m_nSlaveIndex < 0)
+        {
+            m_nSlaveIndex = nNodeIndex;
+        }
+    }
+    m_strNodeKey.clear();
+    m_strNodeHost.clear();
+    m_strNodeIP.clear();
+    m_strNodePort.clear();
+    m_bNodeIsMaster = false;
+    m_bNodeIsOnline = true;
+}
+
+void CFlyRedisClusterTopologyBuilder::FinishSlotRange()
+{
+    for (size_t nIndex = 0; nIndex + 1 < m_vecSlotValue.size(); nIndex += 2)
+    {
+        int nMinSlot = m_vecSlotValue[nIndex];
+        int nMaxSlot = m_vecSlotValue[nIndex + 1];
+        if (m_nMasterIndex < 0 || nMinSlot < 0 || nMinSlot > nMaxSlot || nMaxSlot >= FLY_REDIS_CLUSTER_SLOT_COUNT)
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Warning, "InvalidSlotRange %d-%d, MasterIndex %d", nMinSlot, nMaxSlot, m_nMasterIndex);
+            continue;
+        }
+        for (int nSlot = nMinSlot; nSlot <= nMaxSlot; ++nSlot)
+        {
+            m_stClusterTopology.vecSlotMaster[nSlot] = m_nMasterIndex;
+            m_stClusterTopology.vecSlotSlave[nSlot] = m_nSlaveIndex;
+        }
+    }
+    m_vecSlotValue.clear();
+    m_nMasterIndex = -1;
+    m_nSlaveIndex = -1;
+    m_strMapKey.clear();
+}
+
+// End of CFlyRedisClusterTopologyBuilder
+//////////////////////////////////////////////////////////////////////////
+// Begin of CFlyRedisLatencyHistogram
+// Index of the highest set bit, nValue should not be 0
+static inline int FlyRedisLastSetBit(unsigned int nValue)
+{
+#ifdef _MSC_VER
+    unsigned long nIndex = 0;
+    _BitScanReverse(&nIndex, nValue);
+    return static_cast<int>(nIndex);
+#else
+    return 31 - __builtin_clz(nValue);
+#endif // _MSC_VER
+}
+
+CFlyRedisLatencyHistogram::CFlyRedisLatencyHistogram()
+{
+    Reset();
+}
+
+void CFlyRedisLatencyHistogram::Record(unsigned long long nLatencyUS)
+{
+    ++m_nBucketCount[GetBucketIndex(nLatencyUS)];
+    ++m_nCount;
+    m_nSumUS += nLatencyUS;
+    if (nLatencyUS > m_nMaxUS)
+    {
+        m_nMaxUS = nLatencyUS;
+    }
+}
+
+void CFlyRedisLatencyHistogram::Merge(const CFlyRedisLatencyHistogram& hOther)
+{
+    for (int nIndex = 0; nIndex < FLY_REDIS_LATENCY_BUCKET_COUNT; ++nIndex)
+    {
+        m_nBucketCount[nIndex] += hOther.m_nBucketCount[nIndex];
+    }
+    m_nCount += hOther.m_nCount;
+    m_nSumUS += hOther.m_nSumUS;
+    if (hOther.m_nMaxUS > m_nMaxUS)
+    {
+        m_nMaxUS = hOther.m_nMaxUS;
+    }
+}
+
+void CFlyRedisLatencyHistogram::Reset()
+{
+    memset(m_nBucketCount, 0, sizeof(m_nBucketCount));
+    m_nCount = 0;
+    m_nSumUS = 0;
+    m_nMaxUS = 0;
+}
+
+unsigned long long CFlyRedisLatencyHistogram::GetPercentileUS(double fPercentile) const
+{
+    if (0 == m_nCount)
+    {
+        return 0;
+    }
+    // Rank of the record at fPercentile, it is in [1, m_nCount]
+    unsigned long long nRank = static_cast<unsigned long long>(std::ceil(fPercentile / 100.0 * static_cast<double>(m_nCount)));
+    nRank = std::max(1ULL, std::min(nRank, m_nCount));
+    unsigned long long nPassed = 0;
+    for (int nIndex = 0; nIndex < FLY_REDIS_LATENCY_BUCKET_COUNT; ++nIndex)
+    {
+        nPassed += m_nBucketCount[nIndex];
+        if (nPassed >= nRank)
+        {
+            return std::min(GetBucketUpperBound(nIndex), m_nMaxUS);
+        }
+    }
+    return m_nMaxUS;
+}
+
+int CFlyRedisLatencyHistogram::GetBucketIndex(unsigned long long nLatencyUS)
+{
+    if (nLatencyUS < (1ULL << FLY_REDIS_LATENCY_SUB_BUCKET_BITS))
+    {
+        return static_cast<int>(nLatencyUS);
+    }
+    if (nLatencyUS >= (1ULL << FLY_REDIS_LATENCY_MAX_BITS))
+    {
+        return FLY_REDIS_LATENCY_BUCKET_COUNT - 1;
+    }
+    // Bucket group is the power of two, bucket in group is the bits after the highest set bit
+    int nHighBit = FlyRedisLastSetBit(static_cast<unsigned int>(nLatencyUS));
+    int nShift = nHighBit - FLY_REDIS_LATENCY_SUB_BUCKET_BITS;
+    int nSubIndex = static_cast<int>(nLatencyUS >> nShift) & ((1 << FLY_REDIS_LATENCY_SUB_BUCKET_BITS) - 1);
+    return ((nShift + 1) << FLY_REDIS_LATENCY_SUB_BUCKET_BITS) + nSubIndex;
+}
+
+unsigned long long CFlyRedisLatencyHistogram::GetBucketUpperBound(int nBucketIndex)
+{
+    int nGroup = nBucketIndex >> FLY_REDIS_LATENCY_SUB_BUCKET_BITS;
+    if (0 == nGroup)
+    {
+        return static_cast<unsigned long long>(nBucketIndex);
+    }
+    int nShift = nGroup - 1;
+    unsigned long long nSubIndex = static_cast<unsigned long long>(nBucketIndex & ((1 << FLY_REDIS_LATENCY_SUB_BUCKET_BITS) - 1));
+    return (((1ULL << FLY_REDIS_LATENCY_SUB_BUCKET_BITS) + nSubIndex + 1) << nShift) - 1;
+}
+
+// End of CFlyRedisLatencyHistogram
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisSession function
+// FlyRedisReplyType of RESP type char, it is counted by FlyRedisNodeStats
+static inline FlyRedisReplyType FlyRedisReplyTypeOf(char chType)
+{
+    switch (chType)
+    {
+    case '+':
+        return FlyRedisReplyType::Status;
+    case '-':
+    case '!':
+        return FlyRedisReplyType::Error;
+    case ':':
+        return FlyRedisReplyType::Int;
+    case ',':
+        return FlyRedisReplyType::Double;
+    case '#':
+        return FlyRedisReplyType::Bool;
+    case '(':
+        return FlyRedisReplyType::BigNumber;
+    case '*':
+        return FlyRedisReplyType::Array;
+    case '%':
+        return FlyRedisReplyType::Map;
+    case '~':
+        return FlyRedisReplyType::Set;
+    case '>':
+        return FlyRedisReplyType::Push;
+    case '_':
+        return FlyRedisReplyType::Null;
+    default:
+        return FlyRedisReplyType::Bulk;
+    }
+}
+
+#ifdef FLY_REDIS_ENABLE_TLS
+CFlyRedisSession::CFlyRedisSession(boost::asio::io_context& boostIOContext, bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext)
+    :m_hNetStream(boostIOContext, bUseTLSFlag, boostTLSContext),
+    m_hResponseBuilder(m_stRedisResponse, m_hNetStream.GetRedisAddr())
+{
+}
+#else
+CFlyRedisSession::CFlyRedisSession(boost::asio::io_context& boostIOContext)
+    :m_hNetStream(boostIOContext),
+    m_hResponseBuilder(m_stRedisResponse, m_hNetStream.GetRedisAddr())
+{
+}
+#endif // FLY_REDIS_ENABLE_TLS
+
+CFlyRedisSession::~CFlyRedisSession()
+{
+}
+
+void CFlyRedisSession::SetRedisAddress(const std::string& strAddress)
+{
+    m_hNetStream.SetRedisAddress(strAddress);
+}
+
+const std::string& CFlyRedisSession::GetRedisAddr() const
+{
+    return m_hNetStream.GetRedisAddr();
+}
+
+bool CFlyRedisSession::Connect()
+{
+    return m_hNetStream.Connect();
+}
+
+void CFlyRedisSession::StartAsyncConnect()
+{
+    m_hNetStream.StartAsyncConnect();
+}
+
+bool CFlyRedisSession::IsConnecting() const
+{
+    return m_hNetStream.IsConnecting();
+}
+
+bool CFlyRedisSession::IsConnected() const
+{
+    return m_hNetStream.IsConnected();
+}
+
+bool CFlyRedisSession::SendHandshake(const FlyRedisHandshakeConfig& stHandshakeConfig, bool bReadOnly)
+{
+    std::string strRedisCmdRequest;
+    std::vector<std::string> vecRedisCmdParamList;
+    if (!stHandshakeConfig.strPassword.empty())
+    {
+        vecRedisCmdParamList.emplace_back("AUTH");
+        if (!stHandshakeConfig.strUserName.empty())
+        {
+            vecRedisCmdParamList.emplace_back(stHandshakeConfig.strUserName);
+        }
+        vecRedisCmdParamList.emplace_back(stHandshakeConfig.strPassword);
+        CFlyRedis::AppendRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+        vecRedisCmdParamList.clear();
+    }
+    if (stHandshakeConfig.nRESPVersion > 0)
+    {
+        vecRedisCmdParamList.emplace_back("HELLO");
+        vecRedisCmdParamList.emplace_back(std::to_string(stHandshakeConfig.nRESPVersion));
+        CFlyRedis::AppendRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+        vecRedisCmdParamList.clear();
+    }
+    if (!stHandshakeConfig.strClientName.empty())
+    {
+        vecRedisCmdParamList.emplace_back("CLIENT");
+        vecRedisCmdParamList.emplace_back("SETNAME");
+        vecRedisCmdParamList.emplace_back(stHandshakeConfig.strClientName);
+        CFlyRedis::AppendRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+        vecRedisCmdParamList.clear();
+    }
+    if (bReadOnly)
+    {
+        vecRedisCmdParamList.emplace_back("READONLY");
+        CFlyRedis::AppendRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+        vecRedisCmdParamList.clear();
+    }
+    vecRedisCmdParamList.emplace_back("INFO");
+    vecRedisCmdParamList.emplace_back("Server");
+    CFlyRedis::AppendRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    vecRedisCmdParamList.back() = "Cluster";
+    CFlyRedis::AppendRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    return SendRedisRequest(strRedisCmdRequest);
+}
+
+bool CFlyRedisSession::RecvHandshake(const FlyRedisHandshakeConfig& stHandshakeConfig, bool bReadOnly)
+{
+    // Every response is received before the result is checked, so nothing is left in recv buff
+    FlyRedisPipelineResponse stAuthResponse;
+    FlyRedisPipelineResponse stHelloResponse;
+    FlyRedisPipelineResponse stSetNameResponse;
+    FlyRedisPipelineResponse stReadOnlyResponse;
+    FlyRedisPipelineResponse stServerInfoResponse;
+    FlyRedisPipelineResponse stClusterInfoResponse;
+    bool bRecvResult = (stHandshakeConfig.strPassword.empty() || RecvPipelineResponse(stAuthResponse))
+        && (stHandshakeConfig.nRESPVersion <= 0 || RecvPipelineResponse(stHelloResponse))
+        && (stHandshakeConfig.strClientName.empty() || RecvPipelineResponse(stSetNameResponse))
+        && (!bReadOnly || RecvPipelineResponse(stReadOnlyResponse))
+        && RecvPipelineResponse(stServerInfoResponse)
+        && RecvPipelineResponse(stClusterInfoResponse);
+    if (!bRecvResult)
+    {
+        return false;
+    }
+    if (!stHandshakeConfig.strPassword.empty() && (stAuthResponse.bResponseError || 0 != stAuthResponse.stRedisResponse.strRedisResponse.compare("OK")))
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisNode %s Run AUTH failed", GetRedisAddr().c_str());
+        return false;
+    }
+    if (stServerInfoResponse.bResponseError)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisNode %s Run INFO SERVER failed", GetRedisAddr().c_str());
+        return false;
+    }
+    std::map<std::string, std::map<std::string, std::string> > mapSectionInfo;
+    CFlyRedis::ParseInfoResponse(stServerInfoResponse.stRedisResponse.strRedisResponse, mapSectionInfo);
+    CFlyRedis::ParseInfoResponse(stClusterInfoResponse.stRedisResponse.strRedisResponse, mapSectionInfo);
+    m_strRedisVersion = GetServerInfoSectionField(mapSectionInfo, "# Server", "redis_version");
+    m_bClusterEnabled = (0 == GetServerInfoSectionField(mapSectionInfo, "# Cluster", "cluster_enabled").compare("1"));
+    // The server before Redis 6.* replies error of HELLO, the session keeps RESP2
+    if (stHandshakeConfig.nRESPVersion > 0)
+    {
+        if (stHelloResponse.bResponseError)
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisNode %s Run HELLO %d failed", GetRedisAddr().c_str(), stHandshakeConfig.nRESPVersion);
+        }
+        else
+        {
+            m_nRESPVersion = stHandshakeConfig.nRESPVersion;
+        }
+    }
+    if (stSetNameResponse.bResponseError)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisNode %s Run CLIENT SETNAME failed", GetRedisAddr().c_str());
+    }
+    if (stReadOnlyResponse.bResponseError)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisNode %s Run READONLY failed", GetRedisAddr().c_str());
+    }
+    return !m_strRedisVersion.empty();
+}
+
+bool CFlyRedisSession::ProcRedisRequest(const std::string& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam)
+{
+    // Build RedisCmdRequest String
+    m_stRedisResponse.Reset();
+    m_hResponseBuilder.Reset();
+    std::chrono::steady_clock::time_point tpBegin = std::chrono::steady_clock::now();
+    // Send Msg To RedisServer
+    WriteRedisRequest(strRedisCmdRequest, pVecGatherParam);
+    if (!RecvRedisResponse())
+    {
+        return false;
+    }
+    RecordLatency(tpBegin);
+    return !m_hResponseBuilder.HasResponseError();
+}
+
+bool CFlyRedisSession::ProcRedisRequest(const std::string& strRedisCmdRequest, CFlyRedisRESPHandler& hHandler)
+{
+    m_stRedisResponse.Reset();
+    m_hResponseBuilder.Reset();
+    std::chrono::steady_clock::time_point tpBegin = std::chrono::steady_clock::now();
+    WriteRedisRequest(strRedisCmdRequest, nullptr);
+    if (!RecvRedisResponse(hHandler))
+    {
+        return false;
+    }
+    RecordLatency(tpBegin);
+    return true;
+}
+
+bool CFlyRedisSession::ProcRedisRequest(const std::string& strRedisCmdRequest, CFlyRedisReplyBuilder& hReplyBuilder, const std::vector<FlyRedisGatherParam>* pVecGatherParam)
+{
+    m_stRedisResponse.Reset();
+    m_hResponseBuilder.Reset();
+    hReplyBuilder.Reset();
+    hReplyBuilder.BindRecvBuff(nullptr);
+    std::chrono::steady_clock::time_point tpBegin = std::chrono::steady_clock::now();
+    WriteRedisRequest(strRedisCmdRequest, pVecGatherParam);
+    if (hReplyBuilder.IsReplyView())
+    {
+        // Pin recv buff after write, it is unpinned by the next request
+        m_hNetStream.PinRecvBuff();
+        hReplyBuilder.BindRecvBuff(&m_hNetStream.GetRecvBuff());
+    }
+    if (!RecvRedisResponse(hReplyBuilder))
+    {
+        return false;
+    }
+    RecordLatency(tpBegin);
+    hReplyBuilder.ResolveReplyView();
+    return !hReplyBuilder.HasResponseError();
+}
+
+bool CFlyRedisSession::SendRedisRequest(const std::string& strRedisCmdRequest)
+{
+    m_stRedisResponse.Reset();
+    m_hResponseBuilder.Reset();
+    if (!WriteRedisRequest(strRedisCmdRequest, nullptr))
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "Write Data To Redis Failed, Address %s", GetRedisAddr().c_str());
+        m_bBroken = true;
+        return false;
+    }
+    return true;
+}
+
+bool CFlyRedisSession::RecvPipelineResponse(FlyRedisPipelineResponse& stPipelineResponse)
+{
+    m_stRedisResponse.Reset();
+    m_hResponseBuilder.Reset();
+    if (!RecvRedisResponse())
+    {
+        return false;
+    }
+    // Error response of one cmd does not break the pipeline
+    stPipelineResponse.bResponseError = m_hResponseBuilder.HasResponseError();
+    stPipelineResponse.stRedisResponse.Swap(m_stRedisResponse);
+    return true;
+}
+
+bool CFlyRedisSession::TrySendRedisRequest(const std::string& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam)
+{
+    // Build RedisCmdRequest String
+    m_stRedisResponse.Reset();
+    m_hResponseBuilder.Reset();
+    // Send Msg To RedisServer
+    WriteRedisRequest(strRedisCmdRequest, pVecGatherParam);
+    return true;
+}
+
+bool CFlyRedisSession::WriteRedisRequest(const std::string& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam)
+{
+    bool bResult = false;
+    size_t nBytesSent = strRedisCmdRequest.length();
+    if (nullptr != pVecGatherParam && !pVecGatherParam->empty())
+    {
+        bResult = m_hNetStream.Write(strRedisCmdRequest, *pVecGatherParam);
+        for (const FlyRedisGatherParam& stGatherParam : *pVecGatherParam)
+        {
+            nBytesSent += stGatherParam.strParam.size();
+        }
+    }
+    else
+    {
+        bResult = m_hNetStream.Write(strRedisCmdRequest.c_str(), strRedisCmdRequest.length());
+    }
+    if (nullptr != m_pNodeStats)
+    {
+        if (bResult)
+        {
+            m_pNodeStats->nBytesSent += nBytesSent;
+        }
+        else
+        {
+            ++m_pNodeStats->nNetworkErrorCount;
+        }
+    }
+    return bResult;
+}
+
+void CFlyRedisSession::RecordLatency(const std::chrono::steady_clock::time_point& tpBegin)
+{
+    if (nullptr != m_pNodeStats)
+    {
+        m_pNodeStats->hLatency.RecordSince(tpBegin);
+    }
+}
+
+bool CFlyRedisSession::TryRecvRedisResponse(int nBlockMS)
+{
+    if (!m_hNetStream.ReadByTime(nBlockMS))
+    {
+        return false;
+    }
+    bool bResult = true;
+    while (m_hNetStream.GlobalRecvBuffLen() > 0)
+    {
+        if (!RecvRedisResponse())
+        {
+            bResult = false;
+            break;
+        }
+    }
+    return bResult && !m_hResponseBuilder.HasResponseError();
+}
+
+bool CFlyRedisSession::FetchClusterTopology(FlyRedisClusterTopology& stClusterTopology)
+{
+    // CLUSTER SHARDS was added in Redis 7.0, and CLUSTER SLOTS was deprecated since then
+    stClusterTopology = FlyRedisClusterTopology();
+    if (atoi(m_strRedisVersion.c_str()) >= 7 && CLUSTER_SHARDS(stClusterTopology))
+    {
+        return true;
+    }
+    stClusterTopology = FlyRedisClusterTopology();
+    return CLUSTER_SLOTS(stClusterTopology);
+}
+
+std::string CFlyRedisSession::GetLastFullResponseString() const
+{
+    std::string strResult;
+    if (!m_stRedisResponse.strRedisResponse.empty())
+    {
+        strResult.append("Str:").append(m_stRedisResponse.strRedisResponse);
+    }
+    if (!m_stRedisResponse.vecRedisResponse.empty())
+    {
+        strResult.append(";Vec:");
+        for (auto& strVal : m_stRedisResponse.vecRedisResponse)
+        {
+            strResult.append(strVal).append(",");
+        }
+    }
+    if (!m_stRedisResponse.setRedisResponse.empty())
+    {
+        strResult.append(";Set:");
+        for (auto& strVal : m_stRedisResponse.setRedisResponse)
+        {
+            strResult.append(strVal).append(",");
+        }
+    }
+    if (!m_stRedisResponse.mapRedisResponse.empty())
+    {
+        strResult.append(";Map:");
+        for (auto& kvp : m_stRedisResponse.mapRedisResponse)
+        {
+            strResult.append(kvp.first).append("=").append(kvp.second).append(",");
+        }
+    }
+    return strResult;
+}
+
+bool CFlyRedisSession::AUTH(const std::string& strPassword)
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("AUTH");
+    vecRedisCmdParamList.emplace_back(strPassword);
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    return m_stRedisResponse.strRedisResponse.compare("OK") == 0;
+}
+
+bool CFlyRedisSession::PING()
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("PING");
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    return m_stRedisResponse.strRedisResponse.compare("PONG") == 0;
+}
+
+bool CFlyRedisSession::READONLY()
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("READONLY");
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    return m_stRedisResponse.strRedisResponse.compare("OK") == 0;
+}
+
+bool CFlyRedisSession::ASKING()
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("ASKING");
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    return m_stRedisResponse.strRedisResponse.compare("OK") == 0;
+}
+
+bool CFlyRedisSession::INFO(const std::string& strSection, std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo)
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("INFO");
+    if (!strSection.empty())
+    {
+        vecRedisCmdParamList.emplace_back(strSection);
+    }
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    CFlyRedis::ParseInfoResponse(m_stRedisResponse.strRedisResponse, mapSectionInfo);
+    return true;
+}
+
+bool CFlyRedisSession::CLUSTER_NODES(std::vector<std::string>& vecResult)
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("CLUSTER");
+    vecRedisCmdParamList.emplace_back("NODES");
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    vecResult = CFlyRedis::SplitString(m_stRedisResponse.strRedisResponse, '\n');
+    return true;
+}
+
+bool CFlyRedisSession::CLUSTER_SLOTS(FlyRedisClusterTopology& stClusterTopology)
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("CLUSTER");
+    vecRedisCmdParamList.emplace_back("SLOTS");
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    CFlyRedisClusterTopologyBuilder hClusterTopologyBuilder(stClusterTopology, GetRedisAddr(), false);
+    if (!ProcRedisRequest(strRedisCmdRequest, hClusterTopologyBuilder))
+    {
+        return false;
+    }
+    return !hClusterTopologyBuilder.HasResponseError() && !stClusterTopology.vecRedisAddress.empty();
+}
+
+bool CFlyRedisSession::CLUSTER_SHARDS(FlyRedisClusterTopology& stClusterTopology)
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("CLUSTER");
+    vecRedisCmdParamList.emplace_back("SHARDS");
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    CFlyRedisClusterTopologyBuilder hClusterTopologyBuilder(stClusterTopology, GetRedisAddr(), true);
+    if (!ProcRedisRequest(strRedisCmdRequest, hClusterTopologyBuilder))
+    {
+        return false;
+    }
+    return !hClusterTopologyBuilder.HasResponseError() && !stClusterTopology.vecRedisAddress.empty();
+}
+
+bool CFlyRedisSession::SCRIPT_LOAD(const std::string& strScript, std::string& strResult)
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("SCRIPT");
+    vecRedisCmdParamList.emplace_back("LOAD");
+    vecRedisCmdParamList.emplace_back(strScript);
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    strResult.swap(m_stRedisResponse.strRedisResponse);
+    return true;
+}
+
+bool CFlyRedisSession::SCRIPT_FLUSH()
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("SCRIPT");
+    vecRedisCmdParamList.emplace_back("FLUSH");
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, true);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    return m_stRedisResponse.strRedisResponse.compare("OK") == 0;
+}
+
+bool CFlyRedisSession::SCRIPT_EXISTS(const std::string& strSHA)
+{
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("SCRIPT");
+    vecRedisCmdParamList.emplace_back("EXISTS");
+    vecRedisCmdParamList.emplace_back(strSHA);
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    return m_stRedisResponse.strRedisResponse.compare("1") == 0;
+}
+
+bool CFlyRedisSession::HELLO(int nVersion)
+{
+    if (!VerifyRedisServerVersion6("HELLO"))
+    {
+        return false;
+    }
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("HELLO");
+    vecRedisCmdParamList.emplace_back(std::to_string(nVersion));
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    m_nRESPVersion = nVersion;
+    return true;
+}
+
+bool CFlyRedisSession::HELLO_AUTH_SETNAME(int nVersion, const std::string& strUserName, const std::string& strPassword, const std::string& strClientName)
+{
+    if (!VerifyRedisServerVersion6("HELLO"))
+    {
+        return false;
+    }
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.emplace_back("HELLO");
+    vecRedisCmdParamList.emplace_back(std::to_string(nVersion));
+    if (!strUserName.empty() && !strPassword.empty())
+    {
+        vecRedisCmdParamList.emplace_back("AUTH");
+        vecRedisCmdParamList.emplace_back(strUserName);
+        vecRedisCmdParamList.emplace_back(strPassword);
+    }
+    if (!strClientName.empty())
+    {
+        vecRedisCmdParamList.emplace_back("SETNAME");
+        vecRedisCmdParamList.emplace_back(strClientName);
+    }
+    std::string strRedisCmdRequest;
+    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
+    if (!ProcRedisRequest(strRedisCmdRequest))
+    {
+        return false;
+    }
+    m_nRESPVersion = nVersion;
+    return true;
+}
+
+bool CFlyRedisSession::RecvRedisResponse()
+{
+    return RecvRedisResponse(m_hResponseBuilder);
+}
+
+bool CFlyRedisSession::RecvRedisResponse(CFlyRedisRESPHandler& hHandler)
+{
+    std::chrono::steady_clock::time_point tpDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_hNetStream.GetReadTimeoutMS());
+    while (true)
+    {
+        size_t nConsumed = 0;
+        FlyRedisRESPParseResult nParseResult = m_hRESPParser.Parse(m_hNetStream.GlobalRecvBuffData(), m_hNetStream.GlobalRecvBuffLen(), nConsumed, hHandler);
+        m_hNetStream.SkipRecvBuff(nConsumed);
+        if (nullptr != m_pNodeStats)
+        {
+            m_pNodeStats->nBytesReceived += nConsumed;
+        }
+        if (FlyRedisRESPParseResult::Complete == nParseResult)
+        {
+            if (nullptr != m_pNodeStats)
+            {
+                ++m_pNodeStats->nReplyCount[static_cast<int>(FlyRedisReplyTypeOf(m_hRESPParser.GetReplyTypeChar()))];
+            }
+            break;
+        }
+        if (FlyRedisRESPParseResult::ProtocolError == nParseResult)
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "RESPProtocolError, %s", GetRedisAddr().c_str());
+            if (nullptr != m_pNodeStats)
+            {
+                ++m_pNodeStats->nNetworkErrorCount;
+            }
+            m_hRESPParser.Reset();
+            m_bBroken = true;
+            return false;
+        }
+        // Wait until the buff is long enough to continue parsing, the parsed part will not be parsed again
+        if (!m_hNetStream.ReadByLength(m_hRESPParser.GetExpectedLen(), tpDeadline))
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "NetStream Read %d Failed, %s", m_hRESPParser.GetExpectedLen(), GetRedisAddr().c_str());
+            if (nullptr != m_pNodeStats && m_hNetStream.IsReadTimeout())
+            {
+                ++m_pNodeStats->nTimeoutCount;
+            }
+            else if (nullptr != m_pNodeStats)
+            {
+                ++m_pNodeStats->nNetworkErrorCount;
+            }
+            m_hRESPParser.Reset();
+            m_bBroken = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CFlyRedisSession::VerifyRedisServerVersion6(const char* pszCmdName) const
+{
+    int nMainVersion = atoi(m_strRedisVersion.c_str());
+    if (nMainVersion < 6)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisVersion %s Not Support %s command", m_strRedisVersion.c_str(), pszCmdName);
+        return false;
+    }
+    return true;
+}
+
+std::string CFlyRedisSession::GetServerInfoSectionField(const std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo, const std::string& strSection, const std::string& strField)
+{
+    auto itFindSection = mapSectionInfo.find(strSection);
+    if (itFindSection == mapSectionInfo.end())
+    {
+        return std::string();
+    }
+    const std::map<std::string, std::string>& mapKVP = itFindSection->second;
+    auto itFindKey = mapKVP.find(strField);
+    if (itFindKey == mapKVP.end())
+    {
+        return std::string();
+    }
+    return itFindKey->second;
+}
+
+// End of RedisSession function
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisPipeline
+CFlyRedisPipeline::CFlyRedisPipeline()
+{
+}
+
+CFlyRedisPipeline::~CFlyRedisPipeline()
+{
+}
+
+void CFlyRedisPipeline::AppendRedisCmd(const std::string& strKey, bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList)
+{
+    m_vecPipelineRedisCmd.emplace_back();
+    PipelineRedisCmd& stRedisCmd = m_vecPipelineRedisCmd.back();
+    stRedisCmd.strKey = strKey;
+    stRedisCmd.bIsWrite = bIsWrite;
+    stRedisCmd.vecRedisCmdParamList = vecRedisCmdParamList;
+}
+
+void CFlyRedisPipeline::Clear()
+{
+    m_vecPipelineRedisCmd.clear();
+}
+
+void CFlyRedisPipeline::DEL(const std::string& strKey)
+{
+    AppendRedisCmd(strKey, true, { "DEL", strKey });
+}
+
+void CFlyRedisPipeline::EXPIRE(const std::string& strKey, int nSeconds)
+{
+    AppendRedisCmd(strKey, true, { "EXPIRE", strKey, std::to_string(nSeconds) });
+}
+
+void CFlyRedisPipeline::PEXPIRE(const std::string& strKey, int nMS)
+{
+    AppendRedisCmd(strKey, true, { "PEXPIRE", strKey, std::to_string(nMS) });
+}
+
+void CFlyRedisPipeline::GET(const std::string& strKey)
+{
+    AppendRedisCmd(strKey, false, { "GET", strKey });
+}
+
+void CFlyRedisPipeline::SET(const std::string& strKey, const std::string& strValue)
+{
+    AppendRedisCmd(strKey, true, { "SET", strKey, strValue });
+}
+
+void CFlyRedisPipeline::INCRBY(const std::string& strKey, int nIncrement)
+{
+    AppendRedisCmd(strKey, true, { "INCRBY", strKey, std::to_string(nIncrement) });
+}
+
+void CFlyRedisPipeline::HDEL(const std::string& strKey, const std::string& strField)
+{
+    AppendRedisCmd(strKey, true, { "HDEL", strKey, strField });
+}
+
+void CFlyRedisPipeline::HGET(const std::string& strKey, const std::string& strField)
+{
+    AppendRedisCmd(strKey, false, { "HGET", strKey, strField });
+}
+
+void CFlyRedisPipeline::HSET(const std::string& strKey, const std::string& strField, const std::string& strValue)
+{
+    AppendRedisCmd(strKey, true, { "HSET", strKey, strField, strValue });
+}
+
+void CFlyRedisPipeline::HINCRBY(const std::string& strKey, const std::string& strField, int nIncVal)
+{
+    AppendRedisCmd(strKey, true, { "HINCRBY", strKey, strField, std::to_string(nIncVal) });
+}
+
+// End of RedisPipeline
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisSessionPool
+CFlyRedisSessionPool::CFlyRedisSessionPool()
+{
+}
+
+CFlyRedisSessionPool::~CFlyRedisSessionPool()
+{
+    Close();
+}
+
+void CFlyRedisSessionPool::SetRedisConfig(const std::string& strHost, int nPort, const std::string& strPassword)
+{
+    std::string strRedisAddress = strHost;
+    strRedisAddress.append(":").append(std::to_string(nPort));
+    m_setRedisAddressSeed.emplace(strRedisAddress);
+    m_stHandshakeConfig.strPassword = strPassword;
 }
 
-bool CFlyRedisSession::TrySendRedisRequest(const std::string& strRedisCmdRequest)
+void CFlyRedisSessionPool::SetReadTimeoutMS(int nMS)
 {
-    // Build RedisCmdRequest String
-    m_stRedisResponse.Reset();
-    m_bRedisResponseError = false;
-    // Send Msg To RedisServer
-    m_hNetStream.Write(strRedisCmdRequest.c_str(), strRedisCmdRequest.length());
+    m_nReadTimeoutMS = nMS;
+}
+
+void CFlyRedisSessionPool::SetRedisReadWriteType(FlyRedisReadWriteType nFlyRedisReadWriteType)
+{
+    m_nFlyRedisReadWriteType = nFlyRedisReadWriteType;
+}
+
+void CFlyRedisSessionPool::SetRedisClusterDetectType(FlyRedisClusterDetectType nFlyRedisClusterDetectType)
+{
+    m_nFlyRedisClusterDetectType = nFlyRedisClusterDetectType;
+}
+
+void CFlyRedisSessionPool::SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName)
+{
+    m_stHandshakeConfig.nRESPVersion = nRESPVersion;
+    m_stHandshakeConfig.strUserName = strUserName;
+    m_stHandshakeConfig.strClientName = strClientName;
+}
+
+bool CFlyRedisSessionPool::SetTLSContext(const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert, const std::string& strTLSCACertDir)
+{
+#ifdef FLY_REDIS_ENABLE_TLS
+    m_bUseTLSFlag = true;
+    return CFlyRedis::LoadTLSContext(m_boostTLSContext, strTLSCert, strTLSKey, strTLSCACert, strTLSCACertDir);
+#else
+    CFlyRedis::Logger(FlyRedisLogLevel::Error, "TLS Is Disable, %s, %s, %s, %s", strTLSCert.c_str(), strTLSKey.c_str(), strTLSCACert.c_str(), strTLSCACertDir.c_str());
+    return false;
+#endif // FLY_REDIS_ENABLE_TLS
+}
+
+void CFlyRedisSessionPool::SetSessionCountPerNode(int nMinSessionCount, int nMaxSessionCount)
+{
+    m_nMinSessionCount = std::max(nMinSessionCount, 0);
+    m_nMaxSessionCount = std::max(nMaxSessionCount, 1);
+    if (m_nMinSessionCount > m_nMaxSessionCount)
+    {
+        m_nMinSessionCount = m_nMaxSessionCount;
+    }
+}
+
+bool CFlyRedisSessionPool::Open()
+{
+    // Cluster flag and topology are resolved by the first reachable node
+    PoolRedisSession* pSeedSession = nullptr;
+    for (auto& strAddress : m_setRedisAddressSeed)
+    {
+        pSeedSession = CreatePoolRedisSession(strAddress, false);
+        if (nullptr != pSeedSession)
+        {
+            break;
+        }
+    }
+    if (nullptr == pSeedSession)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "No RedisNode Is Reachable");
+        return false;
+    }
+    CFlyRedisSession& hSeedSession = pSeedSession->hRedisSession;
+    switch (m_nFlyRedisClusterDetectType)
+    {
+    case FlyRedisClusterDetectType::AutoDetect:
+        m_bClusterFlag = hSeedSession.GetHandshakeClusterEnabledFlag();
+        break;
+    case FlyRedisClusterDetectType::EnableCluster:
+        m_bClusterFlag = true;
+        break;
+    case FlyRedisClusterDetectType::DisableCluster:
+        m_bClusterFlag = false;
+        break;
+    default:
+        break;
+    }
+    FlyRedisClusterTopology stClusterTopology;
+    if (m_bClusterFlag && !hSeedSession.FetchClusterTopology(stClusterTopology))
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "FetchClusterTopologyFailed %s", hSeedSession.GetRedisAddr().c_str());
+        delete pSeedSession;
+        pSeedSession = nullptr;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lockPool(m_mutexPool);
+        m_strRedisAddress = hSeedSession.GetRedisAddr();
+        m_stClusterTopology = stClusterTopology;
+        if (!m_bClusterFlag)
+        {
+            m_mapRedisNodePool[m_strRedisAddress];
+        }
+        for (size_t nIndex = 0; nIndex < stClusterTopology.vecRedisAddress.size(); ++nIndex)
+        {
+            // If read and write on master only, there is no session for slave
+            bool bIsMaster = stClusterTopology.vecMasterFlag[nIndex];
+            if (bIsMaster || FlyRedisReadWriteType::ReadOnSlaveWriteOnMaster == m_nFlyRedisReadWriteType)
+            {
+                m_mapRedisNodePool[stClusterTopology.vecRedisAddress[nIndex]].bReadOnly = !bIsMaster;
+            }
+        }
+        // Seed session is kept if it is a master node in pool
+        auto itFind = m_mapRedisNodePool.find(m_strRedisAddress);
+        if (itFind != m_mapRedisNodePool.end() && !itFind->second.bReadOnly)
+        {
+            itFind->second.vecIdleSession.emplace_back(pSeedSession);
+            ++itFind->second.nSessionCount;
+            pSeedSession = nullptr;
+        }
+    }
+    delete pSeedSession;
+    pSeedSession = nullptr;
+    WarmUpRedisNode();
     return true;
 }
 
-bool CFlyRedisSession::TryRecvRedisResponse(int nBlockMS)
+void CFlyRedisSessionPool::Close()
 {
-    if (!m_hNetStream.ReadByTime(nBlockMS))
+    std::lock_guard<std::mutex> lockPool(m_mutexPool);
+    if (!m_mapLeasedRedisSession.empty())
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Warning, "ClosePoolWithLeasedSession %d", static_cast<int>(m_mapLeasedRedisSession.size()));
+    }
+    for (auto& kvp : m_mapRedisNodePool)
+    {
+        for (PoolRedisSession* pPoolRedisSession : kvp.second.vecIdleSession)
+        {
+            delete pPoolRedisSession;
+        }
+    }
+    m_mapRedisNodePool.clear();
+    m_stClusterTopology = FlyRedisClusterTopology();
+    m_strRedisAddress.clear();
+    m_bClusterFlag = false;
+    m_cvPool.notify_all();
+}
+
+std::string CFlyRedisSessionPool::ResolveRedisNode(int nSlot, bool bIsWrite)
+{
+    std::lock_guard<std::mutex> lockPool(m_mutexPool);
+    if (!m_bClusterFlag || nSlot < 0 || nSlot >= FLY_REDIS_CLUSTER_SLOT_COUNT)
+    {
+        return m_strRedisAddress;
+    }
+    int nNodeIndex = m_stClusterTopology.vecSlotMaster[nSlot];
+    if (FlyRedisReadWriteType::ReadOnSlaveWriteOnMaster == m_nFlyRedisReadWriteType && !bIsWrite)
+    {
+        if (m_stClusterTopology.vecSlotSlave[nSlot] >= 0)
+        {
+            nNodeIndex = m_stClusterTopology.vecSlotSlave[nSlot];
+        }
+        else
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Warning, "SlaveFailedSoRedirToMaster %d", nSlot);
+        }
+    }
+    if (nNodeIndex < 0)
+    {
+        return std::string();
+    }
+    return m_stClusterTopology.vecRedisAddress[nNodeIndex];
+}
+
+CFlyRedisSession* CFlyRedisSessionPool::LeaseRedisSession(const std::string& strRedisAddress)
+{
+    if (strRedisAddress.empty())
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "LeaseRedisSessionWithoutAddress");
+        return nullptr;
+    }
+    std::unique_lock<std::mutex> lockPool(m_mutexPool);
+    std::chrono::steady_clock::time_point tpDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_nReadTimeoutMS);
+    // The node is added if it is not in pool, it is the target of MOVED or ASK
+    RedisNodePool* pRedisNodePool = &m_mapRedisNodePool[strRedisAddress];
+    while (pRedisNodePool->vecIdleSession.empty() && pRedisNodePool->nSessionCount >= m_nMaxSessionCount)
+    {
+        if (std::cv_status::timeout == m_cvPool.wait_until(lockPool, tpDeadline))
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "LeaseRedisSessionTimeout %s", strRedisAddress.c_str());
+            return nullptr;
+        }
+        pRedisNodePool = &m_mapRedisNodePool[strRedisAddress];
+    }
+    if (!pRedisNodePool->vecIdleSession.empty())
+    {
+        PoolRedisSession* pPoolRedisSession = pRedisNodePool->vecIdleSession.back();
+        pRedisNodePool->vecIdleSession.pop_back();
+        m_mapLeasedRedisSession.emplace(&pPoolRedisSession->hRedisSession, pPoolRedisSession);
+        return &pPoolRedisSession->hRedisSession;
+    }
+    // Connect without lock, so other thread is not blocked by it
+    ++pRedisNodePool->nSessionCount;
+    bool bReadOnly = pRedisNodePool->bReadOnly;
+    lockPool.unlock();
+    PoolRedisSession* pPoolRedisSession = CreatePoolRedisSession(strRedisAddress, bReadOnly);
+    lockPool.lock();
+    if (nullptr == pPoolRedisSession)
+    {
+        --m_mapRedisNodePool[strRedisAddress].nSessionCount;
+        m_cvPool.notify_all();
+        return nullptr;
+    }
+    m_mapLeasedRedisSession.emplace(&pPoolRedisSession->hRedisSession, pPoolRedisSession);
+    return &pPoolRedisSession->hRedisSession;
+}
+
+void CFlyRedisSessionPool::ReturnRedisSession(CFlyRedisSession* pRedisSession)
+{
+    PoolRedisSession* pPoolRedisSession = nullptr;
+    {
+        std::lock_guard<std::mutex> lockPool(m_mutexPool);
+        auto itFind = m_mapLeasedRedisSession.find(pRedisSession);
+        if (itFind == m_mapLeasedRedisSession.end())
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "ReturnRedisSessionNotLeased %p", static_cast<void*>(pRedisSession));
+            return;
+        }
+        pPoolRedisSession = itFind->second;
+        m_mapLeasedRedisSession.erase(itFind);
+        // Broken session and the session of closed pool is destroyed
+        auto itFindNode = m_mapRedisNodePool.find(pRedisSession->GetRedisAddr());
+        if (itFindNode != m_mapRedisNodePool.end())
+        {
+            if (!pRedisSession->IsBroken())
+            {
+                itFindNode->second.vecIdleSession.emplace_back(pPoolRedisSession);
+                pPoolRedisSession = nullptr;
+            }
+            else
+            {
+                CFlyRedis::Logger(FlyRedisLogLevel::Warning, "DestroyBrokenRedisSession %s", pRedisSession->GetRedisAddr().c_str());
+                --itFindNode->second.nSessionCount;
+                ++m_mapNodeConnectStats[pRedisSession->GetRedisAddr()].nBrokenSessionCount;
+            }
+        }
+        m_cvPool.notify_all();
+    }
+    delete pPoolRedisSession;
+}
+
+void CFlyRedisSessionPool::MoveRedisSlot(int nSlot, const std::string& strRedisAddress)
+{
+    if (nSlot < 0 || nSlot >= FLY_REDIS_CLUSTER_SLOT_COUNT)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lockPool(m_mutexPool);
+    m_stClusterTopology.vecSlotMaster[nSlot] = m_stClusterTopology.AddRedisNode(strRedisAddress, true);
+    m_stClusterTopology.vecSlotSlave[nSlot] = -1;
+}
+
+int CFlyRedisSessionPool::GetRedisSessionCount()
+{
+    std::lock_guard<std::mutex> lockPool(m_mutexPool);
+    int nSessionCount = 0;
+    for (auto& kvp : m_mapRedisNodePool)
+    {
+        nSessionCount += kvp.second.nSessionCount;
+    }
+    return nSessionCount;
+}
+
+void CFlyRedisSessionPool::FetchRedisNodeList(std::vector<std::string>& vecRedisNodeList)
+{
+    std::lock_guard<std::mutex> lockPool(m_mutexPool);
+    vecRedisNodeList.reserve(m_mapRedisNodePool.size());
+    for (auto& kvp : m_mapRedisNodePool)
+    {
+        vecRedisNodeList.emplace_back(kvp.first);
+    }
+}
+
+void CFlyRedisSessionPool::FetchNodeConnectStats(std::map<std::string, FlyRedisNodeStats>& mapNodeStats)
+{
+    std::lock_guard<std::mutex> lockPool(m_mutexPool);
+    for (auto& kvp : m_mapNodeConnectStats)
+    {
+        FlyRedisNodeStats& stNodeStats = mapNodeStats[kvp.first];
+        stNodeStats.nConnectCount = kvp.second.nConnectCount;
+        stNodeStats.nReconnectCount = kvp.second.nReconnectCount;
+    }
+}
+
+CFlyRedisSessionPool::PoolRedisSession* CFlyRedisSessionPool::CreatePoolRedisSession(const std::string& strRedisAddress, bool bReadOnly)
+{
+#ifdef FLY_REDIS_ENABLE_TLS
+    PoolRedisSession* pPoolRedisSession = new PoolRedisSession(m_bUseTLSFlag, m_boostTLSContext);
+#else
+    PoolRedisSession* pPoolRedisSession = new PoolRedisSession();
+#endif // FLY_REDIS_ENABLE_TLS
+    CFlyRedisSession& hRedisSession = pPoolRedisSession->hRedisSession;
+    hRedisSession.SetRedisAddress(strRedisAddress);
+    hRedisSession.SetReadTimeoutMS(m_nReadTimeoutMS);
+    if (!hRedisSession.Connect()
+        || !hRedisSession.SendHandshake(m_stHandshakeConfig, bReadOnly)
+        || !hRedisSession.RecvHandshake(m_stHandshakeConfig, bReadOnly))
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "CreateRedisSessionFailed %s", strRedisAddress.c_str());
+        delete pPoolRedisSession;
+        pPoolRedisSession = nullptr;
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lockPool(m_mutexPool);
+    NodeConnectStats& stNodeConnectStats = m_mapNodeConnectStats[strRedisAddress];
+    ++stNodeConnectStats.nConnectCount;
+    if (stNodeConnectStats.nBrokenSessionCount > 0)
+    {
+        --stNodeConnectStats.nBrokenSessionCount;
+        ++stNodeConnectStats.nReconnectCount;
+    }
+    return pPoolRedisSession;
+}
+
+void CFlyRedisSessionPool::WarmUpRedisNode()
+{
+    // Reserve the session count first, so lease does not connect more than max session
+    std::vector<std::pair<std::string, bool> > vecRedisNode;
+    std::vector<int> vecMissingCount;
+    {
+        std::lock_guard<std::mutex> lockPool(m_mutexPool);
+        for (auto& kvp : m_mapRedisNodePool)
+        {
+            int nMissingCount = m_nMinSessionCount - kvp.second.nSessionCount;
+            if (nMissingCount > 0)
+            {
+                kvp.second.nSessionCount += nMissingCount;
+                vecRedisNode.emplace_back(kvp.first, kvp.second.bReadOnly);
+                vecMissingCount.emplace_back(nMissingCount);
+            }
+        }
+    }
+    std::vector<std::thread> vecWarmUpThread;
+    for (size_t nIndex = 0; nIndex < vecRedisNode.size(); ++nIndex)
+    {
+        std::string strRedisAddress = vecRedisNode[nIndex].first;
+        bool bReadOnly = vecRedisNode[nIndex].second;
+        int nMissingCount = vecMissingCount[nIndex];
+        vecWarmUpThread.emplace_back([this, strRedisAddress, bReadOnly, nMissingCount]() {
+            for (int nCount = 0; nCount < nMissingCount; ++nCount)
+            {
+                PoolRedisSession* pPoolRedisSession = CreatePoolRedisSession(strRedisAddress, bReadOnly);
+                std::lock_guard<std::mutex> lockPool(m_mutexPool);
+                RedisNodePool& stRedisNodePool = m_mapRedisNodePool[strRedisAddress];
+                if (nullptr != pPoolRedisSession)
+                {
+                    stRedisNodePool.vecIdleSession.emplace_back(pPoolRedisSession);
+                }
+                else
+                {
+                    --stRedisNodePool.nSessionCount;
+                }
+                m_cvPool.notify_all();
+            }
+        });
+    }
+    for (std::thread& hWarmUpThread : vecWarmUpThread)
+    {
+        hWarmUpThread.join();
+    }
+}
+
+// End of RedisSessionPool
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisMultiplexSession
+CFlyRedisMultiplexSession::CFlyRedisMultiplexSession()
+    :m_bRunning(false),
+    m_pSubmittedRedisCmd(nullptr)
+{
+}
+
+CFlyRedisMultiplexSession::~CFlyRedisMultiplexSession()
+{
+    Close();
+}
+
+void CFlyRedisMultiplexSession::SetRedisConfig(const std::string& strHost, int nPort, const std::string& strPassword)
+{
+    m_strRedisAddress = strHost;
+    m_strRedisAddress.append(":").append(std::to_string(nPort));
+    m_stHandshakeConfig.strPassword = strPassword;
+}
+
+void CFlyRedisMultiplexSession::SetReadTimeoutMS(int nMS)
+{
+    m_nReadTimeoutMS = nMS;
+}
+
+void CFlyRedisMultiplexSession::SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName)
+{
+    m_stHandshakeConfig.nRESPVersion = nRESPVersion;
+    m_stHandshakeConfig.strUserName = strUserName;
+    m_stHandshakeConfig.strClientName = strClientName;
+}
+
+bool CFlyRedisMultiplexSession::SetTLSContext(const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert, const std::string& strTLSCACertDir)
+{
+#ifdef FLY_REDIS_ENABLE_TLS
+    m_bUseTLSFlag = true;
+    return CFlyRedis::LoadTLSContext(m_boostTLSContext, strTLSCert, strTLSKey, strTLSCACert, strTLSCACertDir);
+#else
+    CFlyRedis::Logger(FlyRedisLogLevel::Error, "TLS Is Disable, %s, %s, %s, %s", strTLSCert.c_str(), strTLSKey.c_str(), strTLSCACert.c_str(), strTLSCACertDir.c_str());
+    return false;
+#endif // FLY_REDIS_ENABLE_TLS
+}
+
+bool CFlyRedisMultiplexSession::Open()
+{
+    if (m_bRunning.load())
+    {
+        return true;
+    }
+    m_pRedisSession = CreateRedisSession();
+    if (nullptr == m_pRedisSession)
+    {
+        return false;
+    }
+    m_bRunning.store(true);
+    m_hIOThread = std::thread(&CFlyRedisMultiplexSession::RunIOThread, this);
+    return true;
+}
+
+void CFlyRedisMultiplexSession::Close()
+{
+    if (m_hIOThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lockIOThread(m_mutexIOThread);
+            m_bRunning.store(false);
+        }
+        m_cvIOThread.notify_one();
+        m_hIOThread.join();
+    }
+    m_bRunning.store(false);
+    delete m_pRedisSession;
+    m_pRedisSession = nullptr;
+}
+
+bool CFlyRedisMultiplexSession::RunRedisCmd(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, FlyRedisPipelineResponse& stPipelineResponse)
+{
+    if (!m_bRunning.load())
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "MultiplexSessionIsNotOpen %s", m_strRedisAddress.c_str());
+        return false;
+    }
+    MultiplexRedisCmd stRedisCmd;
+    CFlyRedis::BuildRedisCmdRequest(m_strRedisAddress, vecRedisCmdParamList, stRedisCmd.strRedisCmdRequest, bIsWrite);
+    std::future<bool> futureResult = stRedisCmd.promiseResult.get_future();
+    SubmitRedisCmd(&stRedisCmd);
+    bool bResult = futureResult.get();
+    stPipelineResponse.bResponseError = stRedisCmd.stPipelineResponse.bResponseError;
+    stPipelineResponse.stRedisResponse.Swap(stRedisCmd.stPipelineResponse.stRedisResponse);
+    return bResult;
+}
+
+bool CFlyRedisMultiplexSession::ExecPipeline(const CFlyRedisPipeline& hPipeline, std::vector<FlyRedisPipelineResponse>& vecResponse)
+{
+    const std::vector<CFlyRedisPipeline::PipelineRedisCmd>& vecRedisCmd = hPipeline.GetRedisCmdList();
+    int nCmdCount = static_cast<int>(vecRedisCmd.size());
+    vecResponse.clear();
+    vecResponse.resize(nCmdCount);
+    if (!m_bRunning.load())
     {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "MultiplexSessionIsNotOpen %s", m_strRedisAddress.c_str());
         return false;
     }
+    // Every cmd is submitted before waiting any result, so they are sent in as few writes as possible
+    std::vector<MultiplexRedisCmd> vecMultiplexRedisCmd(nCmdCount);
+    std::vector<std::future<bool> > vecFutureResult;
+    vecFutureResult.reserve(nCmdCount);
+    for (int nIndex = 0; nIndex < nCmdCount; ++nIndex)
+    {
+        const CFlyRedisPipeline::PipelineRedisCmd& stRedisCmd = vecRedisCmd[nIndex];
+        MultiplexRedisCmd& stMultiplexRedisCmd = vecMultiplexRedisCmd[nIndex];
+        CFlyRedis::BuildRedisCmdRequest(m_strRedisAddress, stRedisCmd.vecRedisCmdParamList, stMultiplexRedisCmd.strRedisCmdRequest, stRedisCmd.bIsWrite);
+        vecFutureResult.emplace_back(stMultiplexRedisCmd.promiseResult.get_future());
+        SubmitRedisCmd(&stMultiplexRedisCmd);
+    }
     bool bResult = true;
-    while (m_hNetStream.GlobalRecvBuffLen() > 0)
+    for (int nIndex = 0; nIndex < nCmdCount; ++nIndex)
     {
-        if (!RecvRedisResponse())
+        if (!vecFutureResult[nIndex].get())
         {
             bResult = false;
-            break;
+        }
+        vecResponse[nIndex].bResponseError = vecMultiplexRedisCmd[nIndex].stPipelineResponse.bResponseError;
+        vecResponse[nIndex].stRedisResponse.Swap(vecMultiplexRedisCmd[nIndex].stPipelineResponse.stRedisResponse);
+    }
+    return bResult;
+}
+
+void CFlyRedisMultiplexSession::SubmitRedisCmd(MultiplexRedisCmd* pRedisCmd)
+{
+    MultiplexRedisCmd* pHead = m_pSubmittedRedisCmd.load(std::memory_order_relaxed);
+    do
+    {
+        pRedisCmd->pNext = pHead;
+    } while (!m_pSubmittedRedisCmd.compare_exchange_weak(pHead, pRedisCmd, std::memory_order_release, std::memory_order_relaxed));
+    // Queue is not empty, so IO thread has been woken up by the previous cmd
+    if (nullptr == pHead)
+    {
+        std::lock_guard<std::mutex> lockIOThread(m_mutexIOThread);
+        m_cvIOThread.notify_one();
+    }
+}
+
+CFlyRedisMultiplexSession::MultiplexRedisCmd* CFlyRedisMultiplexSession::TakeSubmittedRedisCmd()
+{
+    // Queue is taken as a whole, so there is no ABA problem, and it is reversed into submitted order
+    MultiplexRedisCmd* pRedisCmd = m_pSubmittedRedisCmd.exchange(nullptr, std::memory_order_acquire);
+    MultiplexRedisCmd* pRedisCmdList = nullptr;
+    while (nullptr != pRedisCmd)
+    {
+        MultiplexRedisCmd* pNext = pRedisCmd->pNext;
+        pRedisCmd->pNext = pRedisCmdList;
+        pRedisCmdList = pRedisCmd;
+        pRedisCmd = pNext;
+    }
+    return pRedisCmdList;
+}
+
+void CFlyRedisMultiplexSession::SendRedisCmdList(MultiplexRedisCmd* pRedisCmdList, std::deque<MultiplexRedisCmd*>& dequeSentRedisCmd)
+{
+    // Broken session is reconnected before the next write, the cmd fails if it can not be reconnected
+    if (nullptr == m_pRedisSession || m_pRedisSession->IsBroken())
+    {
+        delete m_pRedisSession;
+        m_pRedisSession = CreateRedisSession();
+    }
+    bool bSendFlag = (nullptr != m_pRedisSession);
+    if (bSendFlag)
+    {
+        m_strRedisCmdRequest.clear();
+        for (MultiplexRedisCmd* pRedisCmd = pRedisCmdList; nullptr != pRedisCmd; pRedisCmd = pRedisCmd->pNext)
+        {
+            m_strRedisCmdRequest.append(pRedisCmd->strRedisCmdRequest);
+        }
+        bSendFlag = m_pRedisSession->SendRedisRequest(m_strRedisCmdRequest);
+    }
+    while (nullptr != pRedisCmdList)
+    {
+        MultiplexRedisCmd* pRedisCmd = pRedisCmdList;
+        pRedisCmdList = pRedisCmdList->pNext;
+        if (bSendFlag)
+        {
+            dequeSentRedisCmd.emplace_back(pRedisCmd);
+        }
+        else
+        {
+            FinishRedisCmd(pRedisCmd, false);
         }
     }
-    return bResult && !m_bRedisResponseError;
 }
 
-bool CFlyRedisSession::ResolveServerVersion()
+void CFlyRedisMultiplexSession::FinishRedisCmd(MultiplexRedisCmd* pRedisCmd, bool bResult)
 {
-    // Check server version, update RESP version for Redis 6.*
-    std::map<std::string, std::map<std::string, std::string> > mapSectionInfo;
-    if (!INFO("Server", mapSectionInfo))
-    {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisNode %s Run INFO SERVER failed", GetRedisAddr().c_str());
-        return false;
-    }
-    m_strRedisVersion = GetServerInfoSectionField(mapSectionInfo, "# Server", "redis_version");
-    return !m_strRedisVersion.empty();
+    // The runner may destroy the cmd once result is set, so the promise is moved out first
+    std::promise<bool> promiseResult(std::move(pRedisCmd->promiseResult));
+    promiseResult.set_value(bResult);
 }
 
-bool CFlyRedisSession::GetClusterEnabledFlag()
+CFlyRedisSession* CFlyRedisMultiplexSession::CreateRedisSession()
 {
-    std::map<std::string, std::map<std::string, std::string> > mapSectionInfo;
-    if (!INFO("Cluster", mapSectionInfo))
+#ifdef FLY_REDIS_ENABLE_TLS
+    CFlyRedisSession* pRedisSession = new CFlyRedisSession(m_boostIOContext, m_bUseTLSFlag, m_boostTLSContext);
+#else
+    CFlyRedisSession* pRedisSession = new CFlyRedisSession(m_boostIOContext);
+#endif // FLY_REDIS_ENABLE_TLS
+    pRedisSession->SetRedisAddress(m_strRedisAddress);
+    pRedisSession->SetReadTimeoutMS(m_nReadTimeoutMS);
+    if (!pRedisSession->Connect()
+        || !pRedisSession->SendHandshake(m_stHandshakeConfig, false)
+        || !pRedisSession->RecvHandshake(m_stHandshakeConfig, false))
     {
-        return false;
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "CreateRedisSessionFailed %s", m_strRedisAddress.c_str());
+        delete pRedisSession;
+        pRedisSession = nullptr;
+        return nullptr;
     }
-    std::string strClusterEnabled = GetServerInfoSectionField(mapSectionInfo, "# Cluster", "cluster_enabled");
-    return (0 == strClusterEnabled.compare("1"));
+    return pRedisSession;
 }
 
-std::string CFlyRedisSession::GetLastFullResponseString() const
+void CFlyRedisMultiplexSession::RunIOThread()
 {
-    std::string strResult;
-    if (!m_stRedisResponse.strRedisResponse.empty())
-    {
-        strResult.append("Str:").append(m_stRedisResponse.strRedisResponse);
-    }
-    if (!m_stRedisResponse.vecRedisResponse.empty())
+    std::deque<MultiplexRedisCmd*> dequeSentRedisCmd;
+    while (true)
     {
-        strResult.append(";Vec:");
-        for (auto& strVal : m_stRedisResponse.vecRedisResponse)
+        MultiplexRedisCmd* pRedisCmdList = TakeSubmittedRedisCmd();
+        if (nullptr == pRedisCmdList)
         {
-            strResult.append(strVal).append(",");
+            // Queued cmd is still run after Close is called
+            std::unique_lock<std::mutex> lockIOThread(m_mutexIOThread);
+            m_cvIOThread.wait(lockIOThread, [this]() { return !m_bRunning.load() || nullptr != m_pSubmittedRedisCmd.load(); });
+            if (!m_bRunning.load() && nullptr == m_pSubmittedRedisCmd.load())
+            {
+                break;
+            }
+            continue;
         }
-    }
-    if (!m_stRedisResponse.setRedisResponse.empty())
-    {
-        strResult.append(";Set:");
-        for (auto& strVal : m_stRedisResponse.setRedisResponse)
+        SendRedisCmdList(pRedisCmdList, dequeSentRedisCmd);
+        // Response is matched in FIFO order, cmd submitted meanwhile is sent before waiting the next response
+        while (!dequeSentRedisCmd.empty())
         {
-            strResult.append(strVal).append(",");
+            MultiplexRedisCmd* pRedisCmd = dequeSentRedisCmd.front();
+            dequeSentRedisCmd.pop_front();
+            bool bResult = m_pRedisSession->RecvPipelineResponse(pRedisCmd->stPipelineResponse);
+            FinishRedisCmd(pRedisCmd, bResult);
+            if (!bResult)
+            {
+                // Stream is broken, response of the other sent cmd will not be received
+                while (!dequeSentRedisCmd.empty())
+                {
+                    FinishRedisCmd(dequeSentRedisCmd.front(), false);
+                    dequeSentRedisCmd.pop_front();
+                }
+                break;
+            }
+            if (nullptr != m_pSubmittedRedisCmd.load(std::memory_order_relaxed))
+            {
+                SendRedisCmdList(TakeSubmittedRedisCmd(), dequeSentRedisCmd);
+            }
         }
     }
-    if (!m_stRedisResponse.mapRedisResponse.empty())
+}
+
+// End of RedisMultiplexSession
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisAsyncSession
+#ifdef FLY_REDIS_ENABLE_TLS
+CFlyRedisAsyncSession::CFlyRedisAsyncSession(boost::asio::io_context& boostIOContext, bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext)
+    :m_boostIOContext(boostIOContext),
+    m_hNetStream(boostIOContext, bUseTLSFlag, boostTLSContext),
+    m_hResponseBuilder(m_stRedisResponse, m_strRedisAddress),
+    m_boostResponseTimer(boostIOContext)
+{
+}
+#else
+CFlyRedisAsyncSession::CFlyRedisAsyncSession(boost::asio::io_context& boostIOContext)
+    :m_boostIOContext(boostIOContext),
+    m_hNetStream(boostIOContext),
+    m_hResponseBuilder(m_stRedisResponse, m_strRedisAddress),
+    m_boostResponseTimer(boostIOContext)
+{
+}
+#endif // FLY_REDIS_ENABLE_TLS
+
+CFlyRedisAsyncSession::~CFlyRedisAsyncSession()
+{
+    Close();
+}
+
+void CFlyRedisAsyncSession::SetRedisConfig(const std::string& strHost, int nPort, const std::string& strPassword)
+{
+    m_strRedisAddress = strHost;
+    m_strRedisAddress.append(":").append(std::to_string(nPort));
+    m_stHandshakeConfig.strPassword = strPassword;
+}
+
+void CFlyRedisAsyncSession::SetReadTimeoutMS(int nMS)
+{
+    m_hNetStream.SetReadTimeoutMS(nMS);
+}
+
+void CFlyRedisAsyncSession::SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName)
+{
+    m_stHandshakeConfig.nRESPVersion = nRESPVersion;
+    m_stHandshakeConfig.strUserName = strUserName;
+    m_stHandshakeConfig.strClientName = strClientName;
+}
+
+void CFlyRedisAsyncSession::Close()
+{
+    if (!m_bOpen && !m_bOpening)
     {
-        strResult.append(";Map:");
-        for (auto& kvp : m_stRedisResponse.mapRedisResponse)
-        {
-            strResult.append(kvp.first).append("=").append(kvp.second).append(",");
-        }
+        return;
     }
-    return strResult;
+    FailEveryRedisCmd(boost::asio::error::operation_aborted);
 }
 
-bool CFlyRedisSession::AUTH(const std::string& strPassword)
+void CFlyRedisAsyncSession::StartOpen(const FlyRedisAsyncOpenHandler& fnOpenHandler)
 {
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("AUTH");
-    vecRedisCmdParamList.emplace_back(strPassword);
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    if (m_bOpen || m_bOpening)
     {
-        return false;
+        boost::asio::post(m_boostIOContext, std::bind(fnOpenHandler, boost::system::error_code(boost::asio::error::already_connected)));
+        return;
+    }
+    m_bOpening = true;
+    m_fnOpenHandler = fnOpenHandler;
+    m_hNetStream.SetRedisAddress(m_strRedisAddress);
+    m_hNetStream.SetConnectHandler(boost::bind(&CFlyRedisAsyncSession::HandleConnect, this, boost::placeholders::_1));
+    m_hNetStream.StartAsyncConnect();
+    if (!m_hNetStream.IsConnecting())
+    {
+        m_hNetStream.SetConnectHandler(nullptr);
+        m_bOpening = false;
+        m_fnOpenHandler = nullptr;
+        boost::asio::post(m_boostIOContext, std::bind(fnOpenHandler, boost::system::error_code(boost::asio::error::invalid_argument)));
     }
-    return m_stRedisResponse.strRedisResponse.compare("OK") == 0;
 }
 
-bool CFlyRedisSession::PING()
+void CFlyRedisAsyncSession::SubmitRedisCmd(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, const FlyRedisAsyncCmdHandler& fnCmdHandler)
 {
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("PING");
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    if (!m_bOpen && !m_bOpening)
     {
-        return false;
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "AsyncSessionIsNotOpen %s", m_strRedisAddress.c_str());
+        PostRedisCmdHandler(fnCmdHandler, boost::asio::error::not_connected);
+        return;
     }
-    return m_stRedisResponse.strRedisResponse.compare("PONG") == 0;
+    CFlyRedis::AppendRedisCmdRequest(m_strRedisAddress, vecRedisCmdParamList, m_strPendingRequest, bIsWrite);
+    m_dequeRedisCmdHandler.emplace_back(fnCmdHandler);
+    StartWrite();
 }
 
-bool CFlyRedisSession::READONLY()
+void CFlyRedisAsyncSession::SubmitPipeline(const CFlyRedisPipeline& hPipeline, const FlyRedisAsyncPipelineHandler& fnPipelineHandler)
 {
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("READONLY");
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    const std::vector<CFlyRedisPipeline::PipelineRedisCmd>& vecRedisCmd = hPipeline.GetRedisCmdList();
+    int nCmdCount = static_cast<int>(vecRedisCmd.size());
+    std::shared_ptr<std::vector<FlyRedisPipelineResponse> > pVecResponse = std::make_shared<std::vector<FlyRedisPipelineResponse> >(nCmdCount);
+    if (0 == nCmdCount)
     {
-        return false;
+        boost::asio::post(m_boostIOContext, [fnPipelineHandler, pVecResponse]() { fnPipelineHandler(boost::system::error_code(), *pVecResponse); });
+        return;
+    }
+    // Response is passed in the order of cmd, so the handler of the last cmd finishes the pipeline
+    std::shared_ptr<boost::system::error_code> pErrorCode = std::make_shared<boost::system::error_code>();
+    for (int nIndex = 0; nIndex < nCmdCount; ++nIndex)
+    {
+        bool bLastCmd = (nIndex + 1 == nCmdCount);
+        SubmitRedisCmd(vecRedisCmd[nIndex].bIsWrite, vecRedisCmd[nIndex].vecRedisCmdParamList,
+            [fnPipelineHandler, pVecResponse, pErrorCode, nIndex, bLastCmd](const boost::system::error_code& boostErrorCode, FlyRedisPipelineResponse& stPipelineResponse) {
+            if (boostErrorCode && !*pErrorCode)
+            {
+                *pErrorCode = boostErrorCode;
+            }
+            FlyRedisPipelineResponse& stResponse = (*pVecResponse)[nIndex];
+            stResponse.bResponseError = stPipelineResponse.bResponseError;
+            stResponse.stRedisResponse.Swap(stPipelineResponse.stRedisResponse);
+            if (bLastCmd)
+            {
+                fnPipelineHandler(*pErrorCode, *pVecResponse);
+            }
+        });
     }
-    return m_stRedisResponse.strRedisResponse.compare("OK") == 0;
 }
 
-bool CFlyRedisSession::INFO(const std::string& strSection, std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo)
+void CFlyRedisAsyncSession::HandleConnect(bool bConnected)
 {
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("INFO");
-    if (!strSection.empty())
+    if (!m_bOpening)
     {
-        vecRedisCmdParamList.emplace_back(strSection);
+        return;
     }
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    if (!bConnected)
     {
-        return false;
+        FailEveryRedisCmd(boost::asio::error::connection_refused);
+        return;
     }
-    // Parse info section key-value field
-    size_t nLineLen = m_stRedisResponse.strRedisResponse.length();
-    std::string strLine;
-    std::string strCurSection;
-    std::string strCurKey;
-    std::string strCurValue;
-    for (size_t nIndex = 0; nIndex < nLineLen; ++nIndex)
+    m_hNetStream.StartAsyncReadLoop(boost::bind(&CFlyRedisAsyncSession::HandleRead, this, boost::placeholders::_1));
+    // Handshake cmd is sent before the queued cmd, and the session is open when the last one is done
+    std::vector<std::vector<std::string> > vecHandshakeCmd;
+    if (!m_stHandshakeConfig.strPassword.empty())
     {
-        char chCur = m_stRedisResponse.strRedisResponse[nIndex];
-        strLine.append(1, chCur);
-        if ('\n' == chCur)
+        vecHandshakeCmd.emplace_back(1, "AUTH");
+        if (!m_stHandshakeConfig.strUserName.empty())
         {
-            if ('#' == strLine[0])
-            {
-                // Parse section name
-                strCurSection.swap(TrimLastChar(strLine, 2));
-                strLine.clear();
-            }
-            else
-            {
-                strCurValue.swap(TrimLastChar(strLine, 2));
-                strLine.clear();
-                auto itFindSection = mapSectionInfo.find(strCurSection);
-                if (itFindSection == mapSectionInfo.end())
-                {
-                    std::map<std::string, std::string> mapKVP;
-                    mapKVP.emplace(strCurKey, strCurValue);
-                    mapSectionInfo.emplace(strCurSection, mapKVP);
-                }
-                else
-                {
-                    std::map<std::string, std::string>& mapKVP = itFindSection->second;
-                    mapKVP.emplace(strCurKey, strCurValue);
-                }
-            }
+            vecHandshakeCmd.back().emplace_back(m_stHandshakeConfig.strUserName);
         }
-        else if (':' == chCur)
+        vecHandshakeCmd.back().emplace_back(m_stHandshakeConfig.strPassword);
+    }
+    if (m_stHandshakeConfig.nRESPVersion > 0)
+    {
+        vecHandshakeCmd.push_back({ "HELLO", std::to_string(m_stHandshakeConfig.nRESPVersion) });
+    }
+    if (!m_stHandshakeConfig.strClientName.empty())
+    {
+        vecHandshakeCmd.push_back({ "CLIENT", "SETNAME", m_stHandshakeConfig.strClientName });
+    }
+    if (vecHandshakeCmd.empty())
+    {
+        // Open handler may delete this session
+        std::weak_ptr<bool> pAliveToken = m_pAliveToken;
+        FinishOpen(boost::system::error_code());
+        if (!pAliveToken.expired())
         {
-            strCurKey.swap(TrimLastChar(strLine, 1));
-            strLine.clear();
+            StartWrite();
         }
+        return;
     }
-    return true;
-}
-
-bool CFlyRedisSession::CLUSTER_NODES(std::vector<std::string>& vecResult)
-{
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("CLUSTER");
-    vecRedisCmdParamList.emplace_back("NODES");
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    std::string strHandshakeRequest;
+    int nHandshakeCmdCount = static_cast<int>(vecHandshakeCmd.size());
+    for (int nIndex = nHandshakeCmdCount - 1; nIndex >= 0; --nIndex)
     {
-        return false;
+        std::string strCmd = vecHandshakeCmd[nIndex].front();
+        bool bLastCmd = (nIndex + 1 == nHandshakeCmdCount);
+        // Failed handler is posted, this session is not touched by it
+        m_dequeRedisCmdHandler.emplace_front([this, strCmd, bLastCmd](const boost::system::error_code& boostErrorCode, FlyRedisPipelineResponse& stPipelineResponse) {
+            if (!boostErrorCode)
+            {
+                HandleHandshakeResponse(stPipelineResponse, strCmd, bLastCmd);
+            }
+        });
     }
-    vecResult = CFlyRedis::SplitString(m_stRedisResponse.strRedisResponse, '\n');
-    return true;
+    for (auto& vecRedisCmdParamList : vecHandshakeCmd)
+    {
+        CFlyRedis::AppendRedisCmdRequest(m_strRedisAddress, vecRedisCmdParamList, strHandshakeRequest, false);
+    }
+    m_strPendingRequest.insert(0, strHandshakeRequest);
+    StartWrite();
 }
 
-bool CFlyRedisSession::SCRIPT_LOAD(const std::string& strScript, std::string& strResult)
+void CFlyRedisAsyncSession::HandleHandshakeResponse(FlyRedisPipelineResponse& stPipelineResponse, const std::string& strCmd, bool bLastCmd)
 {
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("SCRIPT");
-    vecRedisCmdParamList.emplace_back("LOAD");
-    vecRedisCmdParamList.emplace_back(strScript);
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    if (stPipelineResponse.bResponseError)
     {
-        return false;
+        if (0 == strCmd.compare("AUTH"))
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisNode %s Run AUTH failed", m_strRedisAddress.c_str());
+            FailEveryRedisCmd(boost::asio::error::access_denied);
+            return;
+        }
+        CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisNode %s Run %s failed", m_strRedisAddress.c_str(), strCmd.c_str());
+    }
+    if (bLastCmd)
+    {
+        FinishOpen(boost::system::error_code());
     }
-    strResult.swap(m_stRedisResponse.strRedisResponse);
-    return true;
 }
 
-bool CFlyRedisSession::SCRIPT_FLUSH()
+void CFlyRedisAsyncSession::FinishOpen(const boost::system::error_code& boostErrorCode)
 {
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("SCRIPT");
-    vecRedisCmdParamList.emplace_back("FLUSH");
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, true);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    m_bOpening = false;
+    m_bOpen = !boostErrorCode;
+    FlyRedisAsyncOpenHandler fnOpenHandler;
+    fnOpenHandler.swap(m_fnOpenHandler);
+    if (fnOpenHandler)
     {
-        return false;
+        fnOpenHandler(boostErrorCode);
     }
-    return m_stRedisResponse.strRedisResponse.compare("OK") == 0;
 }
 
-bool CFlyRedisSession::SCRIPT_EXISTS(const std::string& strSHA)
+void CFlyRedisAsyncSession::StartWrite()
 {
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("SCRIPT");
-    vecRedisCmdParamList.emplace_back("EXISTS");
-    vecRedisCmdParamList.emplace_back(strSHA);
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    if (m_bWriting || m_strPendingRequest.empty() || !m_hNetStream.IsConnected())
     {
-        return false;
+        return;
+    }
+    // Cmd queued while writing is sent in the next write
+    m_strWritingRequest.swap(m_strPendingRequest);
+    m_strPendingRequest.clear();
+    m_bWriting = true;
+    m_hNetStream.AsyncWrite(m_strWritingRequest.c_str(), m_strWritingRequest.length(), boost::bind(&CFlyRedisAsyncSession::HandleWrite, this, boost::placeholders::_1));
+    if (!m_bResponseTimerRunning)
+    {
+        StartResponseTimer();
     }
-    return m_stRedisResponse.strRedisResponse.compare("1") == 0;
 }
 
-bool CFlyRedisSession::HELLO(int nVersion)
+void CFlyRedisAsyncSession::HandleWrite(bool bWriteResult)
 {
-    if (!VerifyRedisServerVersion6("HELLO"))
-    {
-        return false;
-    }
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("HELLO");
-    vecRedisCmdParamList.emplace_back(std::to_string(nVersion));
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    m_bWriting = false;
+    m_strWritingRequest.clear();
+    if (!bWriteResult)
     {
-        return false;
+        // Write is aborted by Close, every cmd has failed
+        if (m_hNetStream.IsConnected())
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "Write Data To Redis Failed, Address %s", m_strRedisAddress.c_str());
+            FailEveryRedisCmd(boost::asio::error::connection_reset);
+        }
+        return;
     }
-    m_nRESPVersion = nVersion;
-    return true;
+    StartWrite();
 }
 
-bool CFlyRedisSession::HELLO_AUTH_SETNAME(int nVersion, const std::string& strUserName, const std::string& strPassword, const std::string& strClientName)
+void CFlyRedisAsyncSession::HandleRead(bool bReadResult)
 {
-    if (!VerifyRedisServerVersion6("HELLO"))
+    if (!bReadResult)
     {
-        return false;
+        FailEveryRedisCmd(boost::asio::error::connection_reset);
+        return;
     }
-    std::vector<std::string> vecRedisCmdParamList;
-    vecRedisCmdParamList.emplace_back("HELLO");
-    vecRedisCmdParamList.emplace_back(std::to_string(nVersion));
-    if (!strUserName.empty() && !strPassword.empty())
+    // Handler may close or delete this session, so the state is checked before every response
+    std::weak_ptr<bool> pAliveToken = m_pAliveToken;
+    bool bRecvResponse = false;
+    while (m_hNetStream.IsConnected())
     {
-        vecRedisCmdParamList.emplace_back("AUTH");
-        vecRedisCmdParamList.emplace_back(strUserName);
-        vecRedisCmdParamList.emplace_back(strPassword);
+        size_t nConsumed = 0;
+        FlyRedisRESPParseResult nParseResult = m_hRESPParser.Parse(m_hNetStream.GlobalRecvBuffData(), m_hNetStream.GlobalRecvBuffLen(), nConsumed, m_hResponseBuilder);
+        m_hNetStream.SkipRecvBuff(nConsumed);
+        if (FlyRedisRESPParseResult::NeedMoreData == nParseResult)
+        {
+            break;
+        }
+        if (FlyRedisRESPParseResult::ProtocolError == nParseResult)
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "RESPProtocolError, %s", m_strRedisAddress.c_str());
+            FailEveryRedisCmd(boost::system::errc::make_error_code(boost::system::errc::protocol_error));
+            break;
+        }
+        FlyRedisPipelineResponse stPipelineResponse;
+        stPipelineResponse.bResponseError = m_hResponseBuilder.HasResponseError();
+        stPipelineResponse.stRedisResponse.Swap(m_stRedisResponse);
+        m_hResponseBuilder.Reset();
+        if (m_dequeRedisCmdHandler.empty())
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Warning, "UnexpectedRedisResponse %s", m_strRedisAddress.c_str());
+            continue;
+        }
+        FlyRedisAsyncCmdHandler fnCmdHandler;
+        fnCmdHandler.swap(m_dequeRedisCmdHandler.front());
+        m_dequeRedisCmdHandler.pop_front();
+        bRecvResponse = true;
+        fnCmdHandler(boost::system::error_code(), stPipelineResponse);
+        if (pAliveToken.expired())
+        {
+            return;
+        }
     }
-    if (!strClientName.empty())
+    if (!bRecvResponse || !m_hNetStream.IsConnected())
     {
-        vecRedisCmdParamList.emplace_back("SETNAME");
-        vecRedisCmdParamList.emplace_back(strClientName);
+        return;
     }
-    std::string strRedisCmdRequest;
-    CFlyRedis::BuildRedisCmdRequest(GetRedisAddr(), vecRedisCmdParamList, strRedisCmdRequest, false);
-    if (!ProcRedisRequest(strRedisCmdRequest))
+    if (m_dequeRedisCmdHandler.empty())
     {
-        return false;
+        StopResponseTimer();
     }
-    m_nRESPVersion = nVersion;
-    return true;
+    else
+    {
+        StartResponseTimer();
+    }
+}
+
+void CFlyRedisAsyncSession::StartResponseTimer()
+{
+    m_bResponseTimerRunning = true;
+    m_boostResponseTimer.expires_after(std::chrono::milliseconds(m_hNetStream.GetReadTimeoutMS()));
+    m_boostResponseTimer.async_wait(FlyRedisGuardHandler(m_pAliveToken, boost::bind(&CFlyRedisAsyncSession::HandleResponseTimeout,
+        this,
+        boost::asio::placeholders::error,
+        ++m_nResponseTimerSeq)));
 }
 
-bool CFlyRedisSession::RecvRedisResponse()
+void CFlyRedisAsyncSession::StopResponseTimer()
+{
+    m_bResponseTimerRunning = false;
+    ++m_nResponseTimerSeq;
+    m_boostResponseTimer.cancel();
+}
+
+void CFlyRedisAsyncSession::HandleResponseTimeout(const boost::system::error_code& boostErrorCode, unsigned int nResponseTimerSeq)
 {
-    if (!m_hNetStream.ReadByLength(1))
+    if (boostErrorCode || nResponseTimerSeq != m_nResponseTimerSeq)
     {
-        return false;
+        return;
     }
-    char chHead = 0;
-    if (!m_hNetStream.PickFirstChar(chHead))
+    m_bResponseTimerRunning = false;
+    CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisResponseTimeout %s", m_strRedisAddress.c_str());
+    FailEveryRedisCmd(boost::asio::error::timed_out);
+}
+
+void CFlyRedisAsyncSession::FailEveryRedisCmd(const boost::system::error_code& boostErrorCode)
+{
+    // Handler is posted, so it can reopen or destroy this session
+    StopResponseTimer();
+    m_hNetStream.Close();
+    m_bOpen = false;
+    m_strPendingRequest.clear();
+    m_hRESPParser.Reset();
+    m_hResponseBuilder.Reset();
+    m_stRedisResponse.Reset();
+    if (m_bOpening)
     {
-        return false;
+        m_bOpening = false;
+        FlyRedisAsyncOpenHandler fnOpenHandler;
+        fnOpenHandler.swap(m_fnOpenHandler);
+        boost::asio::post(m_boostIOContext, std::bind(fnOpenHandler, boostErrorCode));
     }
-    bool bResult = false;
-    switch (chHead)
+    std::deque<FlyRedisAsyncCmdHandler> dequeRedisCmdHandler;
+    dequeRedisCmdHandler.swap(m_dequeRedisCmdHandler);
+    for (auto& fnCmdHandler : dequeRedisCmdHandler)
     {
-    case '-': // Errors 
-        bResult = ReadRedisResponseError();
-        break;
-    case '+': // Simple Strings
-        bResult = ReadRedisResponseSimpleStrings();
-        break;
-    case ':': // Integers 
-        bResult = ReadRedisResponseIntegers();
-        break;
-    case '$': // Bulk Strings
-        bResult = ReadRedisResponseBulkStrings();
-        break;
-    case '*': // Array
-        bResult = ReadRedisResponseArrays();
-        break;
-    case ',': // Double
-        bResult = ReadRedisResponseDouble();
-        break;
-    case '_': // Null
-        bResult = ReadRedisResponseNull();
-        break;
-    case '#': // Boolean
-        bResult = ReadRedisResponseBoolean();
-        break;
-    case '!': // BlobError
-        bResult = ReadRedisResponseBlobError();
-        break;
-    case '=': // VerbatimString
-        bResult = ReadRedisResponseVerbatimString();
-        break;
-    case '(': // BigNumber
-        bResult = ReadRedisResponseBigNumber();
-        break;
-    case '%': // Map
-        bResult = ReadRedisResponseMap();
-        break;
-    case '~': // Set
-        bResult = ReadRedisResponseSet();
-        break;
-    case '|': // Attribute
-        bResult = ReadRedisResponseAttribute();
-        break;
-    default:
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "Unknown HeadCharacter, %s, Char: %s", GetRedisAddr().c_str(), std::to_string(chHead).c_str());
-        break;
+        PostRedisCmdHandler(fnCmdHandler, boostErrorCode);
     }
-    return bResult;
 }
 
-bool CFlyRedisSession::ReadRedisResponseError()
+void CFlyRedisAsyncSession::PostRedisCmdHandler(const FlyRedisAsyncCmdHandler& fnCmdHandler, const boost::system::error_code& boostErrorCode)
+{
+    boost::asio::post(m_boostIOContext, [fnCmdHandler, boostErrorCode]() {
+        FlyRedisPipelineResponse stPipelineResponse;
+        fnCmdHandler(boostErrorCode, stPipelineResponse);
+    });
+}
+
+// End of RedisAsyncSession
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisCoroutineClient
+#ifdef FLY_REDIS_ENABLE_COROUTINE
+CFlyRedisCoroutineClient::CFlyRedisCoroutineClient(CFlyRedisAsyncSession& hAsyncSession)
+    :m_hAsyncSession(hAsyncSession)
+{
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::Open()
 {
-    if (!ReadUntilCRLF())
+    boost::system::error_code boostErrorCode;
+    co_await m_hAsyncSession.AsyncOpen(boost::asio::redirect_error(boost::asio::use_awaitable, boostErrorCode));
+    if (boostErrorCode)
     {
-        return false;
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "OpenAsyncSessionFailed, Msg %s", boostErrorCode.message().c_str());
+        co_return false;
     }
-    CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisResponseError %s", m_stRedisResponse.strRedisResponse.c_str());
-    m_bRedisResponseError = true;
-    m_strLastResponseErrorMsg = m_stRedisResponse.strRedisResponse;
-    return true;
+    co_return true;
 }
 
-bool CFlyRedisSession::ReadRedisResponseSimpleStrings()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RunRedisCmd(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, FlyRedisPipelineResponse& stPipelineResponse)
 {
-    if (!ReadUntilCRLF())
+    boost::system::error_code boostErrorCode;
+    stPipelineResponse = co_await m_hAsyncSession.AsyncRunRedisCmd(bIsWrite, vecRedisCmdParamList, boost::asio::redirect_error(boost::asio::use_awaitable, boostErrorCode));
+    if (boostErrorCode)
     {
-        return false;
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "RunRedisCmdFailed %s, Msg %s", vecRedisCmdParamList.empty() ? "" : vecRedisCmdParamList.front().c_str(), boostErrorCode.message().c_str());
+        co_return false;
     }
-    m_stRedisResponse.vecRedisResponse.emplace_back(m_stRedisResponse.strRedisResponse);
-    return true;
+    co_return !stPipelineResponse.bResponseError;
 }
 
-bool CFlyRedisSession::ReadRedisResponseIntegers()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::ExecPipeline(const CFlyRedisPipeline& hPipeline, std::vector<FlyRedisPipelineResponse>& vecResponse)
 {
-    if (!ReadUntilCRLF())
+    boost::system::error_code boostErrorCode;
+    vecResponse = co_await m_hAsyncSession.AsyncExecPipeline(hPipeline, boost::asio::redirect_error(boost::asio::use_awaitable, boostErrorCode));
+    if (boostErrorCode)
     {
-        return false;
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ExecPipelineFailed, Msg %s", boostErrorCode.message().c_str());
+        co_return false;
     }
-    m_stRedisResponse.vecRedisResponse.emplace_back(m_stRedisResponse.strRedisResponse);
-    return true;
+    co_return true;
 }
 
-bool CFlyRedisSession::ReadRedisResponseBulkStrings()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::DEL(const std::string& strKey, int& nResult)
 {
-    return ReadRedisResponseVarLenString();
+    std::vector<std::string> vecRedisCmdParamList = { "DEL", strKey };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseArrays()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::EXISTS(const std::string& strKey, int& nResult)
 {
-    // Read Length
-    if (!ReadUntilCRLF())
-    {
-        return false;
-    }
-    int nLen = atoi(m_stRedisResponse.strRedisResponse.c_str());
-    m_stRedisResponse.strRedisResponse.clear();
-    if (nLen < 0)
-    {
-        return false;
-    }
-    if (0 == nLen)
-    {
-        return true;
-    }
-    for (int nIndex = 0; nIndex < nLen; ++nIndex)
-    {
-        RecvRedisResponse();
-    }
-    return true;
+    std::vector<std::string> vecRedisCmdParamList = { "EXISTS", strKey };
+    co_return co_await RunRedisCmdOnResponseInt(false, vecRedisCmdParamList, nResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseMap()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::EXPIRE(const std::string& strKey, int nSeconds, int& nResult)
 {
-    ReadUntilCRLF();
-    std::string strKey;
-    std::string strValue;
-    int nKVPCount = atoi(m_stRedisResponse.strRedisResponse.c_str());
-    m_stRedisResponse.strRedisResponse.clear();
-    for (int nKVPIndex = 0; nKVPIndex < nKVPCount; ++nKVPIndex)
+    std::vector<std::string> vecRedisCmdParamList = { "EXPIRE", strKey, std::to_string(nSeconds) };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::TTL(const std::string& strKey, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "TTL", strKey };
+    co_return co_await RunRedisCmdOnResponseInt(false, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::GET(const std::string& strKey, std::string& strResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "GET", strKey };
+    co_return co_await RunRedisCmdOnResponseString(false, vecRedisCmdParamList, strResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::SET(const std::string& strKey, const std::string& strValue)
+{
+    std::string strResult;
+    std::vector<std::string> vecRedisCmdParamList = { "SET", strKey, strValue };
+    co_return co_await RunRedisCmdOnResponseString(true, vecRedisCmdParamList, strResult) && strResult.compare("OK") == 0;
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::SETEX(const std::string& strKey, int nTimeOutSeconds, const std::string& strValue, std::string& strResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "SETEX", strKey, std::to_string(nTimeOutSeconds), strValue };
+    co_return co_await RunRedisCmdOnResponseString(true, vecRedisCmdParamList, strResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::INCR(const std::string& strKey, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "INCR", strKey };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::INCRBY(const std::string& strKey, int nIncrement, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "INCRBY", strKey, std::to_string(nIncrement) };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::MGET(const std::vector<std::string>& vecKey, std::vector<std::string>& vecResult)
+{
+    if (vecKey.empty())
     {
-        RecvRedisResponse();
-        strKey.swap(m_stRedisResponse.strRedisResponse);
-        RecvRedisResponse();
-        strValue.swap(m_stRedisResponse.strRedisResponse);
-        m_stRedisResponse.mapRedisResponse.emplace(strKey, strValue);
+        co_return false;
     }
-    return true;
+    std::vector<std::string> vecRedisCmdParamList;
+    vecRedisCmdParamList.reserve(vecKey.size() + 1);
+    vecRedisCmdParamList.emplace_back("MGET");
+    vecRedisCmdParamList.insert(vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
+    co_return co_await RunRedisCmdOnResponseVector(false, vecRedisCmdParamList, vecResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseDouble()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::HGET(const std::string& strKey, const std::string& strField, std::string& strResult)
 {
-    ReadUntilCRLF();
-    m_stRedisResponse.vecRedisResponse.emplace_back(m_stRedisResponse.strRedisResponse);
-    return true;
+    std::vector<std::string> vecRedisCmdParamList = { "HGET", strKey, strField };
+    co_return co_await RunRedisCmdOnResponseString(false, vecRedisCmdParamList, strResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseNull()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::HSET(const std::string& strKey, const std::string& strField, const std::string& strValue, int& nResult)
 {
-    ReadUntilCRLF();
-    m_stRedisResponse.vecRedisResponse.emplace_back(m_stRedisResponse.strRedisResponse);
-    return true;
+    std::vector<std::string> vecRedisCmdParamList = { "HSET", strKey, strField, strValue };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseBoolean()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::HDEL(const std::string& strKey, const std::string& strField, int& nResult)
 {
-    ReadUntilCRLF();
-    m_stRedisResponse.vecRedisResponse.emplace_back(m_stRedisResponse.strRedisResponse);
-    return true;
+    std::vector<std::string> vecRedisCmdParamList = { "HDEL", strKey, strField };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::HINCRBY(const std::string& strKey, const std::string& strField, int nIncVal, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "HINCRBY", strKey, strField, std::to_string(nIncVal) };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::HGETALL(const std::string& strKey, std::map<std::string, std::string>& mapFieldValue)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "HGETALL", strKey };
+    co_return co_await RunRedisCmdOnResponseKVP(false, vecRedisCmdParamList, mapFieldValue);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::LPUSH(const std::string& strKey, const std::string& strValue, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "LPUSH", strKey, strValue };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RPUSH(const std::string& strKey, const std::string& strValue, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "RPUSH", strKey, strValue };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::LPOP(const std::string& strKey, std::string& strResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "LPOP", strKey };
+    co_return co_await RunRedisCmdOnResponseString(true, vecRedisCmdParamList, strResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RPOP(const std::string& strKey, std::string& strResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "RPOP", strKey };
+    co_return co_await RunRedisCmdOnResponseString(true, vecRedisCmdParamList, strResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::LRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "LRANGE", strKey, std::to_string(nStart), std::to_string(nStop) };
+    co_return co_await RunRedisCmdOnResponseVector(false, vecRedisCmdParamList, vecResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseBlobError()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::SADD(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    return ReadRedisResponseVarLenString();
+    std::vector<std::string> vecRedisCmdParamList = { "SADD", strKey, strValue };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseVerbatimString()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::SREM(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    return ReadRedisResponseVarLenString();
+    std::vector<std::string> vecRedisCmdParamList = { "SREM", strKey, strValue };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
 }
 
-bool CFlyRedisSession::ReadRedisResponseBigNumber()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::SMEMBERS(const std::string& strKey, std::set<std::string>& setResult)
 {
-    if (!ReadUntilCRLF())
+    std::vector<std::string> vecRedisCmdParamList = { "SMEMBERS", strKey };
+    co_return co_await RunRedisCmdOnResponseSet(false, vecRedisCmdParamList, setResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::ZADD(const std::string& strKey, double fScore, const std::string& strMember, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "ZADD", strKey, CFlyRedisNumberCodec::DoubleToString(fScore), strMember };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::ZSCORE(const std::string& strKey, const std::string& strMember, double& fResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "ZSCORE", strKey, strMember };
+    co_return co_await RunRedisCmdOnResponseDouble(false, vecRedisCmdParamList, fResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::ZRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "ZRANGE", strKey, std::to_string(nStart), std::to_string(nStop) };
+    co_return co_await RunRedisCmdOnResponseVector(false, vecRedisCmdParamList, vecResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::PUBLISH(const std::string& strChannel, const std::string& strMsg, int& nResult)
+{
+    std::vector<std::string> vecRedisCmdParamList = { "PUBLISH", strChannel, strMsg };
+    co_return co_await RunRedisCmdOnResponseInt(true, vecRedisCmdParamList, nResult);
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RunRedisCmdOnResponseString(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::string& strResult)
+{
+    FlyRedisPipelineResponse stPipelineResponse;
+    if (!co_await RunRedisCmd(bIsWrite, vecRedisCmdParamList, stPipelineResponse))
     {
-        return false;
+        co_return false;
     }
-    m_stRedisResponse.vecRedisResponse.emplace_back(m_stRedisResponse.strRedisResponse);
-    return true;
+    strResult.swap(stPipelineResponse.stRedisResponse.strRedisResponse);
+    co_return true;
 }
 
-bool CFlyRedisSession::ReadRedisResponseSet()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RunRedisCmdOnResponseInt(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, int& nResult)
 {
-    // Read Length
-    if (!ReadUntilCRLF())
+    std::string strResult;
+    if (!co_await RunRedisCmdOnResponseString(bIsWrite, vecRedisCmdParamList, strResult))
     {
-        return false;
+        co_return false;
     }
-    int nLen = atoi(m_stRedisResponse.strRedisResponse.c_str());
-    m_stRedisResponse.strRedisResponse.clear();
-    if (nLen < 0)
+    long long nValue = 0;
+    if (!CFlyRedisNumberCodec::DecodeInt(strResult.data(), strResult.data() + strResult.length(), nValue))
     {
-        return false;
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ResponseIsNotInt %s, %s", vecRedisCmdParamList.front().c_str(), strResult.c_str());
+        co_return false;
     }
-    if (0 == nLen)
+    nResult = static_cast<int>(nValue);
+    co_return true;
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RunRedisCmdOnResponseDouble(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, double& fResult)
+{
+    std::string strResult;
+    if (!co_await RunRedisCmdOnResponseString(bIsWrite, vecRedisCmdParamList, strResult))
     {
-        return true;
+        co_return false;
     }
-    for (int nIndex = 0; nIndex < nLen; ++nIndex)
+    fResult = 0.0;
+    CFlyRedisNumberCodec::DecodeDouble(strResult.data(), strResult.data() + strResult.length(), fResult);
+    co_return true;
+}
+
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RunRedisCmdOnResponseVector(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::vector<std::string>& vecResult)
+{
+    FlyRedisPipelineResponse stPipelineResponse;
+    if (!co_await RunRedisCmd(bIsWrite, vecRedisCmdParamList, stPipelineResponse))
     {
-        RecvRedisResponse();
-        m_stRedisResponse.setRedisResponse.emplace(m_stRedisResponse.strRedisResponse);
+        co_return false;
     }
-    return true;
+    vecResult.swap(stPipelineResponse.stRedisResponse.vecRedisResponse);
+    co_return true;
 }
 
-bool CFlyRedisSession::ReadRedisResponseAttribute()
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RunRedisCmdOnResponseSet(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::set<std::string>& setResult)
 {
-    ReadUntilCRLF();
-    std::string strKey;
-    std::string strValue;
-    int nKVPCount = atoi(m_stRedisResponse.strRedisResponse.c_str());
-    m_stRedisResponse.strRedisResponse.clear();
-    for (int nKVPIndex = 0; nKVPIndex < nKVPCount; ++nKVPIndex)
+    FlyRedisPipelineResponse stPipelineResponse;
+    if (!co_await RunRedisCmd(bIsWrite, vecRedisCmdParamList, stPipelineResponse))
     {
-        RecvRedisResponse();
-        strKey.swap(m_stRedisResponse.strRedisResponse);
-        RecvRedisResponse();
-        strValue.swap(m_stRedisResponse.strRedisResponse);
-        m_stRedisResponse.mapRedisResponse.emplace(strKey, strValue);
+        co_return false;
     }
-    return true;
+    // Every member of RESP2 array and RESP3 set is in vecRedisResponse
+    const std::vector<std::string>& vecRedisResponse = stPipelineResponse.stRedisResponse.vecRedisResponse;
+    setResult.insert(vecRedisResponse.begin(), vecRedisResponse.end());
+    co_return true;
 }
 
-bool CFlyRedisSession::VerifyRedisServerVersion6(const char* pszCmdName) const
+boost::asio::awaitable<bool> CFlyRedisCoroutineClient::RunRedisCmdOnResponseKVP(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::map<std::string, std::string>& mapResult)
 {
-    int nMainVersion = atoi(m_strRedisVersion.c_str());
-    if (nMainVersion < 6)
+    FlyRedisPipelineResponse stPipelineResponse;
+    if (!co_await RunRedisCmd(bIsWrite, vecRedisCmdParamList, stPipelineResponse))
+    {
+        co_return false;
+    }
+    // RESP3 replies a map, RESP2 replies an array of field and value
+    FlyRedisResponse& stRedisResponse = stPipelineResponse.stRedisResponse;
+    if (!stRedisResponse.mapRedisResponse.empty())
+    {
+        mapResult.swap(stRedisResponse.mapRedisResponse);
+        co_return true;
+    }
+    const std::vector<std::string>& vecRedisResponse = stRedisResponse.vecRedisResponse;
+    int nLineCount = (int)vecRedisResponse.size();
+    if (nLineCount % 2 != 0)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ResponseLineCountIsNotEven %d", nLineCount);
+        co_return false;
+    }
+    for (int nKeyIndex = 0; nKeyIndex < nLineCount; nKeyIndex += 2)
+    {
+        if (!mapResult.emplace(vecRedisResponse[nKeyIndex], vecRedisResponse[nKeyIndex + 1]).second)
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "ResponseLineReduplicateField %s", vecRedisCmdParamList.front().c_str());
+            co_return false;
+        }
+    }
+    co_return true;
+}
+#endif // FLY_REDIS_ENABLE_COROUTINE
+
+// End of RedisCoroutineClient
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisNumberCodec
+// Power of 10 which is exact in double, integer below 2^53 divided by it is rounded correctly
+static const double CONST_EXACT_POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int CONST_EXACT_POW10_MAX = 22;
+static const unsigned long long CONST_EXACT_INT_LIMIT = 1ULL << 53;
+
+// Decode digits without sign, return false if there is no digit, other char, or it overflows
+static inline bool FlyRedisDecodeDigit(const char* pBegin, const char* pEnd, unsigned long long& nValue)
+{
+    if (pBegin >= pEnd)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisVersion %s Not Support %s command", m_strRedisVersion.c_str(), pszCmdName);
         return false;
     }
+    unsigned long long nResult = 0;
+    for (const char* pCur = pBegin; pCur < pEnd; ++pCur)
+    {
+        unsigned int nDigit = static_cast<unsigned int>(static_cast<unsigned char>(*pCur)) - '0';
+        if (nDigit > 9)
+        {
+            return false;
+        }
+        if (nResult > (ULLONG_MAX - nDigit) / 10)
+        {
+            return false;
+        }
+        nResult = nResult * 10 + nDigit;
+    }
+    nValue = nResult;
     return true;
 }
 
-bool CFlyRedisSession::ReadUntilCRLF()
+size_t CFlyRedisNumberCodec::EncodeInt(char* pBuff, long long nValue)
 {
-    m_stRedisResponse.strRedisResponse.clear();
-    bool bResult = true;
-    char chPreValue = 0;
-    while (true)
+    if (nValue >= 0)
+    {
+        return EncodeUInt(pBuff, static_cast<unsigned long long>(nValue));
+    }
+    pBuff[0] = '-';
+    return 1 + EncodeUInt(pBuff + 1, 0ULL - static_cast<unsigned long long>(nValue));
+}
+
+size_t CFlyRedisNumberCodec::EncodeUInt(char* pBuff, unsigned long long nValue)
+{
+    // Digits are written from the end of a local buff, then copied at once
+    char szDigit[20];
+    char* pDigit = szDigit + sizeof(szDigit);
+    do
+    {
+        *--pDigit = static_cast<char>('0' + nValue % 10);
+        nValue /= 10;
+    } while (0 != nValue);
+    size_t nLen = szDigit + sizeof(szDigit) - pDigit;
+    memcpy(pBuff, pDigit, nLen);
+    return nLen;
+}
+
+size_t CFlyRedisNumberCodec::EncodeDouble(char* pBuff, double fValue)
+{
+    // Redis accepts inf and -inf as score
+    if (std::isnan(fValue))
+    {
+        memcpy(pBuff, "nan", 3);
+        return 3;
+    }
+    if (std::isinf(fValue))
     {
-        if (!m_hNetStream.ReadByLength(1))
+        if (fValue < 0)
         {
-            bResult = false;
-            break;
+            memcpy(pBuff, "-inf", 4);
+            return 4;
         }
-        char chCurValue = 0;
-        if (!m_hNetStream.PickFirstChar(chCurValue))
+        memcpy(pBuff, "inf", 3);
+        return 3;
+    }
+    // Fast path, find the fewest fraction digits of N / 10^K which is decoded back to fValue, N is below 2^53 so the decode is exact
+    double fAbsValue = std::fabs(fValue);
+    for (int nExp = 0; nExp <= CONST_EXACT_POW10_MAX; ++nExp)
+    {
+        double fScaled = fAbsValue * CONST_EXACT_POW10[nExp];
+        if (fScaled >= static_cast<double>(CONST_EXACT_INT_LIMIT))
         {
-            bResult = false;
             break;
         }
-        m_stRedisResponse.strRedisResponse.append(1, chCurValue);
-        if (chPreValue == '\r' && chCurValue == '\n')
+        unsigned long long nDigit = static_cast<unsigned long long>(fScaled + 0.5);
+        if (static_cast<double>(nDigit) / CONST_EXACT_POW10[nExp] != fAbsValue)
+        {
+            continue;
+        }
+        char szDigit[24];
+        size_t nDigitLen = EncodeUInt(szDigit, nDigit);
+        size_t nLen = 0;
+        if (fValue < 0)
+        {
+            pBuff[nLen++] = '-';
+        }
+        size_t nFractionLen = static_cast<size_t>(nExp);
+        if (0 == nFractionLen)
+        {
+            memcpy(pBuff + nLen, szDigit, nDigitLen);
+            return nLen + nDigitLen;
+        }
+        if (nDigitLen > nFractionLen)
+        {
+            memcpy(pBuff + nLen, szDigit, nDigitLen - nFractionLen);
+            nLen += nDigitLen - nFractionLen;
+            pBuff[nLen++] = '.';
+            memcpy(pBuff + nLen, szDigit + nDigitLen - nFractionLen, nFractionLen);
+            return nLen + nFractionLen;
+        }
+        pBuff[nLen++] = '0';
+        pBuff[nLen++] = '.';
+        memset(pBuff + nLen, '0', nFractionLen - nDigitLen);
+        nLen += nFractionLen - nDigitLen;
+        memcpy(pBuff + nLen, szDigit, nDigitLen);
+        return nLen + nDigitLen;
+    }
+    // Slow path, the fewest significant digits which is decoded back to fValue, 17 digits is always enough
+    int nLen = 0;
+    for (int nPrecision = 15; nPrecision <= 17; ++nPrecision)
+    {
+        nLen = snprintf(pBuff, 32, "%.*g", nPrecision, fValue);
+        if (strtod(pBuff, nullptr) == fValue)
         {
-            TrimLastChar(m_stRedisResponse.strRedisResponse, 2);
             break;
         }
-        chPreValue = chCurValue;
     }
-    return bResult;
+    return static_cast<size_t>(nLen);
+}
+
+std::string CFlyRedisNumberCodec::DoubleToString(double fValue)
+{
+    char szValue[32];
+    return std::string(szValue, EncodeDouble(szValue, fValue));
 }
 
-bool CFlyRedisSession::ReadRedisResponseVarLenString()
+bool CFlyRedisNumberCodec::DecodeInt(const char* pBegin, const char* pEnd, long long& nValue)
 {
-    // Read Length
-    if (!ReadUntilCRLF())
+    bool bNegative = false;
+    if (pBegin < pEnd && ('-' == *pBegin || '+' == *pBegin))
+    {
+        bNegative = ('-' == *pBegin);
+        ++pBegin;
+    }
+    unsigned long long nResult = 0;
+    if (!FlyRedisDecodeDigit(pBegin, pEnd, nResult))
     {
         return false;
     }
-    int nLen = atoi(m_stRedisResponse.strRedisResponse.c_str());
-    m_stRedisResponse.strRedisResponse.clear();
-    if (-1 == nLen)
+    if (bNegative)
     {
-        m_stRedisResponse.vecRedisResponse.emplace_back(""); // HGET maybe return Empty String
+        if (nResult > static_cast<unsigned long long>(LLONG_MAX) + 1)
+        {
+            return false;
+        }
+        nValue = (0 == nResult) ? 0 : -static_cast<long long>(nResult - 1) - 1;
         return true;
     }
-    if (nLen < 0)
+    if (nResult > static_cast<unsigned long long>(LLONG_MAX))
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "Len LessThan 0: %s", m_stRedisResponse.strRedisResponse.c_str());
         return false;
     }
-    // If BulkStrings over than 512M, just return false. according the Redis document, the max length should be 512M
-    // Just for safe
-    if (nLen >= 1024 * 1024 * 512)
+    nValue = static_cast<long long>(nResult);
+    return true;
+}
+
+bool CFlyRedisNumberCodec::DecodeUInt(const char* pBegin, const char* pEnd, unsigned long long& nValue)
+{
+    if (pBegin < pEnd && '+' == *pBegin)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "Len OverThan 512M: %s", m_stRedisResponse.strRedisResponse.c_str());
-        return false;
+        ++pBegin;
     }
-    // Length: 2 char for \r\n
-    m_stRedisResponse.strRedisResponse.clear();
-    if (!m_hNetStream.ReadByLength(nLen))
+    return FlyRedisDecodeDigit(pBegin, pEnd, nValue);
+}
+
+bool CFlyRedisNumberCodec::DecodeDouble(const char* pBegin, const char* pEnd, double& fValue)
+{
+    if (pBegin >= pEnd)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "NetStream Read %d Failed", nLen);
         return false;
     }
-    if (!m_hNetStream.ConsumeRecvBuff(m_stRedisResponse.strRedisResponse, nLen))
+    // Fast path, decimal without exponent whose digits are below 2^53, it is N / 10^K which is exact
+    const char* pCur = pBegin;
+    bool bNegative = false;
+    if ('-' == *pCur || '+' == *pCur)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "NetStream ConsumeRecvBuff %d Failed", nLen);
-        return false;
+        bNegative = ('-' == *pCur);
+        ++pCur;
+    }
+    unsigned long long nDigit = 0;
+    int nDigitCount = 0;
+    const char* pPoint = nullptr;
+    for (; pCur < pEnd && nDigitCount <= 19; ++pCur)
+    {
+        if (*pCur >= '0' && *pCur <= '9')
+        {
+            nDigit = nDigit * 10 + (*pCur - '0');
+            ++nDigitCount;
+        }
+        else if ('.' == *pCur && nullptr == pPoint)
+        {
+            pPoint = pCur;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (pCur == pEnd && nDigitCount > 0 && nDigitCount <= 19 && nDigit <= CONST_EXACT_INT_LIMIT)
+    {
+        int nFractionLen = (nullptr == pPoint) ? 0 : static_cast<int>(pEnd - pPoint - 1);
+        if (nFractionLen <= CONST_EXACT_POW10_MAX)
+        {
+            double fResult = static_cast<double>(nDigit) / CONST_EXACT_POW10[nFractionLen];
+            fValue = bNegative ? -fResult : fResult;
+            return true;
+        }
     }
-    // Read tail CRLF to make stream empty
-    if (!m_hNetStream.ReadByLength(2))
+    // Slow path, such as exponent, inf or long digits. Text is not null terminated, it is copied to stack for strtod
+    char szValue[128];
+    size_t nLen = static_cast<size_t>(pEnd - pBegin);
+    if (nLen >= sizeof(szValue))
     {
         return false;
     }
-    std::string strCRLF;
-    if (!m_hNetStream.ConsumeRecvBuff(strCRLF, 2))
+    memcpy(szValue, pBegin, nLen);
+    szValue[nLen] = '\0';
+    char* pValueEnd = nullptr;
+    double fResult = strtod(szValue, &pValueEnd);
+    if (pValueEnd != szValue + nLen)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "NetStream ConsumeRecvBuff CRLF Failed");
         return false;
     }
-    m_stRedisResponse.vecRedisResponse.emplace_back(m_stRedisResponse.strRedisResponse);
+    fValue = fResult;
     return true;
 }
 
-std::string& CFlyRedisSession::TrimLastChar(std::string& strValue, size_t nTrimCount) const
+// End of RedisNumberCodec
+//////////////////////////////////////////////////////////////////////////
+// Begin of RedisCmdEncoder
+CFlyRedisCmdName::CFlyRedisCmdName(const char* pszCmdName, const char* pszSubCmdName)
 {
-    size_t nLength = strValue.length();
-    if (nLength >= nTrimCount)
+    const char* arrName[2] = { pszCmdName, pszSubCmdName };
+    for (const char* pszName : arrName)
     {
-        strValue.erase(nLength - nTrimCount);
+        if (nullptr == pszName)
+        {
+            continue;
+        }
+        size_t nNameLen = strlen(pszName);
+        CFlyRedisCmdEncoder::AppendHeader(m_strPrefix, '$', nNameLen);
+        m_strPrefix.append(pszName, nNameLen).append("\r\n", 2);
+        ++m_nParamCount;
     }
-    return strValue;
 }
 
-std::string CFlyRedisSession::GetServerInfoSectionField(const std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo, const std::string& strSection, const std::string& strField)
+void CFlyRedisCmdEncoder::AppendHeader(std::string& strOutput, char chType, size_t nLen)
 {
-    auto itFindSection = mapSectionInfo.find(strSection);
-    if (itFindSection == mapSectionInfo.end())
+    char szHeader[24];
+    szHeader[0] = chType;
+    size_t nHeaderLen = 1 + CFlyRedisNumberCodec::EncodeUInt(szHeader + 1, nLen);
+    szHeader[nHeaderLen++] = '\r';
+    szHeader[nHeaderLen++] = '\n';
+    strOutput.append(szHeader, nHeaderLen);
+}
+
+size_t CFlyRedisCmdEncoder::GetOneMaxEncodeLen(const std::vector<FlyRedisGatherParam>* pVecGatherParam, const std::vector<std::string>& vecParam)
+{
+    size_t nLen = 0;
+    for (const std::string& strParam : vecParam)
     {
-        return std::string();
+        nLen += GetOneMaxEncodeLen(pVecGatherParam, boost::string_view(strParam));
     }
-    const std::map<std::string, std::string>& mapKVP = itFindSection->second;
-    auto itFindKey = mapKVP.find(strField);
-    if (itFindKey == mapKVP.end())
+    return nLen;
+}
+
+void CFlyRedisCmdEncoder::AppendOneParam(std::string& strOutput, std::vector<FlyRedisGatherParam>* pVecGatherParam, const std::vector<std::string>& vecParam)
+{
+    for (const std::string& strParam : vecParam)
     {
-        return std::string();
+        AppendOneParam(strOutput, pVecGatherParam, boost::string_view(strParam));
     }
-    return itFindKey->second;
 }
 
-// End of RedisSession function
+// End of RedisCmdEncoder
 //////////////////////////////////////////////////////////////////////////
 // Begin of RedisClient
 #define CHECK_CUR_REDIS_SESSION() if (nullptr == m_pCurRedisSession) { CFlyRedis::Logger(FlyRedisLogLevel::Error, "CurRedisSessionIsNull"); m_bHasBadRedisSession = true; return false; }
 
 CFlyRedisClient::CFlyRedisClient()
+    :m_vecRedisSlotOwner(FLY_REDIS_CLUSTER_SLOT_COUNT),
+    m_bHasNewClusterTopology(false)
 {
 }
 
@@ -959,12 +3718,25 @@ void CFlyRedisClient::SetRedisConfig(const std::string& strHost, int nPort, cons
     std::string strRedisAddress = strHost;
     strRedisAddress.append(":").append(std::to_string(nPort));
     m_setRedisAddressSeed.emplace(strRedisAddress);
-    m_strRedisPasswod = strPassword;
+    m_stHandshakeConfig.strPassword = strPassword;
 }
 
 void CFlyRedisClient::SetReadTimeoutSeconds(int nSeconds)
 {
-    m_nReadTimeoutSeconds = nSeconds;
+    SetReadTimeoutMS(nSeconds * 1000);
+}
+
+void CFlyRedisClient::SetReadTimeoutMS(int nMS)
+{
+    m_nReadTimeoutMS = nMS;
+    for (auto& kvp : m_mapRedisSession)
+    {
+        CFlyRedisSession* pRedisSession = kvp.second;
+        if (nullptr != pRedisSession)
+        {
+            pRedisSession->SetReadTimeoutMS(nMS);
+        }
+    }
 }
 
 void CFlyRedisClient::SetRedisReadWriteType(FlyRedisReadWriteType nFlyRedisReadWriteType)
@@ -977,6 +3749,23 @@ void CFlyRedisClient::SetRedisClusterDetectType(FlyRedisClusterDetectType nFlyRe
     m_nFlyRedisClusterDetectType = nFlyRedisClusterDetectType;
 }
 
+void CFlyRedisClient::SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName)
+{
+    m_stHandshakeConfig.nRESPVersion = nRESPVersion;
+    m_stHandshakeConfig.strUserName = strUserName;
+    m_stHandshakeConfig.strClientName = strClientName;
+}
+
+void CFlyRedisClient::SetRedisSessionPool(CFlyRedisSessionPool* pRedisSessionPool)
+{
+    m_pRedisSessionPool = pRedisSessionPool;
+}
+
+void CFlyRedisClient::SetClusterTopologyRefreshMS(int nMS)
+{
+    m_nClusterTopologyRefreshMS = nMS;
+}
+
 bool CFlyRedisClient::SetTLSContext(const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert)
 {
     return SetTLSContext(strTLSCert, strTLSKey, strTLSCACert, "");
@@ -986,47 +3775,7 @@ bool CFlyRedisClient::SetTLSContext(const std::string& strTLSCert, const std::st
 {
 #ifdef FLY_REDIS_ENABLE_TLS
     m_bUseTLSFlag = true;
-    boost::system::error_code boostErrorCode;
-    m_boostTLSContext.set_options(boost::asio::ssl::context::no_sslv2 | boost::asio::ssl::context::no_sslv3, boostErrorCode);
-    if (boostErrorCode)
-    {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL set_options failed: %s", boostErrorCode.message().c_str());
-        return false;
-    }
-    m_boostTLSContext.set_verify_mode(boost::asio::ssl::verify_peer, boostErrorCode);
-    if (boostErrorCode)
-    {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL set_verify_mode failed: %s", boostErrorCode.message().c_str());
-        return false;
-    }
-    m_boostTLSContext.load_verify_file(strTLSCACert.c_str(), boostErrorCode);
-    if (boostErrorCode)
-    {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL load_verify_file failed: %s", boostErrorCode.message().c_str());
-        return false;
-    }
-    if (!strTLSCACertDir.empty())
-    {
-        m_boostTLSContext.add_verify_path(strTLSCACertDir.c_str(), boostErrorCode);
-        if (boostErrorCode)
-        {
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL add_verify_path failed: %s", boostErrorCode.message().c_str());
-            return false;
-        }
-    }
-    m_boostTLSContext.use_certificate_chain_file(strTLSCert.c_str(), boostErrorCode);
-    if (boostErrorCode)
-    {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL use_certificate_chain_file failed: %s", boostErrorCode.message().c_str());
-        return false;
-    }
-    m_boostTLSContext.use_private_key_file(strTLSKey.c_str(), boost::asio::ssl::context_base::file_format::pem, boostErrorCode);
-    if (boostErrorCode)
-    {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL use_private_key_file failed: %s", boostErrorCode.message().c_str());
-        return false;
-    }
-    return true;
+    return CFlyRedis::LoadTLSContext(m_boostTLSContext, strTLSCert, strTLSKey, strTLSCACert, strTLSCACertDir);
 #else
     CFlyRedis::Logger(FlyRedisLogLevel::Error, "TLS Is Disable, %s, %s, %s", strTLSCert.c_str(), strTLSKey.c_str(), strTLSCACert.c_str(), strTLSCACertDir.c_str());
     return false;
@@ -1054,6 +3803,12 @@ std::string CFlyRedisClient::GetLocalIP() const
 
 bool CFlyRedisClient::Open()
 {
+    // Session is leased from pool for every cmd, so nothing is connected here
+    if (nullptr != m_pRedisSessionPool)
+    {
+        m_bClusterFlag = m_pRedisSessionPool->GetClusterFlag();
+        return true;
+    }
     for (auto& strAddress : m_setRedisAddressSeed)
     {
         CFlyRedisSession* pRedisSession = CreateRedisSession(strAddress);
@@ -1072,7 +3827,7 @@ bool CFlyRedisClient::Open()
     switch (m_nFlyRedisClusterDetectType)
     {
     case FlyRedisClusterDetectType::AutoDetect:
-        m_bClusterFlag = m_pCurRedisSession->GetClusterEnabledFlag();
+        m_bClusterFlag = m_pCurRedisSession->GetHandshakeClusterEnabledFlag();
         break;
     case FlyRedisClusterDetectType::EnableCluster:
         m_bClusterFlag = true;
@@ -1091,11 +3846,18 @@ bool CFlyRedisClient::Open()
     {
         return true;
     }
-    return ConnectToEveryRedisNode();
+    bResult = ConnectToEveryRedisNode();
+    StartClusterTopologyRefresh();
+    return bResult;
 }
 
 void CFlyRedisClient::Close()
 {
+    ReturnPoolRedisSession();
+    StopClusterTopologyRefresh();
+    m_pClusterTopology.reset();
+    std::atomic_store(&m_pNewClusterTopology, std::shared_ptr<const FlyRedisClusterTopology>());
+    m_bHasNewClusterTopology.store(false);
     m_bClusterFlag = false;
     std::map<std::string, CFlyRedisSession*> mapRedisSessionCopy = m_mapRedisSession;
     for (auto& kvp : mapRedisSessionCopy)
@@ -1110,6 +3872,11 @@ void CFlyRedisClient::Close()
 
 void CFlyRedisClient::FetchRedisNodeList(std::vector<std::string>& vecRedisNodeList) const
 {
+    if (nullptr != m_pRedisSessionPool)
+    {
+        m_pRedisSessionPool->FetchRedisNodeList(vecRedisNodeList);
+        return;
+    }
     vecRedisNodeList.reserve(m_mapRedisSession.size());
     for (auto& kvp : m_mapRedisSession)
     {
@@ -1137,6 +3904,8 @@ bool CFlyRedisClient::ChooseCurRedisNode(const std::string& strNodeAddr)
 
 void CFlyRedisClient::HELLO(int nRESPVersion)
 {
+    // The session which is connected later runs HELLO in handshake
+    m_stHandshakeConfig.nRESPVersion = nRESPVersion;
     for (auto& kvp : m_mapRedisSession)
     {
         CFlyRedisSession* pFlyRedisSession = kvp.second;
@@ -1149,6 +3918,17 @@ void CFlyRedisClient::HELLO(int nRESPVersion)
 
 bool CFlyRedisClient::HELLO_AUTH_SETNAME(int nRESPVersion, const std::string& strUserName, const std::string& strPassword, const std::string& strClientName)
 {
+    // The session which is connected later runs them in handshake
+    m_stHandshakeConfig.nRESPVersion = nRESPVersion;
+    if (!strUserName.empty() && !strPassword.empty())
+    {
+        m_stHandshakeConfig.strUserName = strUserName;
+        m_stHandshakeConfig.strPassword = strPassword;
+    }
+    if (!strClientName.empty())
+    {
+        m_stHandshakeConfig.strClientName = strClientName;
+    }
     bool bResult = true;
     for (auto& kvp : m_mapRedisSession)
     {
@@ -1195,69 +3975,57 @@ bool CFlyRedisClient::ACL_CAT(const std::string& strParam, std::vector<std::stri
 
 bool CFlyRedisClient::ACL_DELUSER(const std::string& strUserName, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("DELUSER");
-    m_vecRedisCmdParamList.emplace_back(strUserName);
+    static const CFlyRedisCmdName hCmdName("ACL", "DELUSER");
+    EncodeRedisCmd(hCmdName, strUserName);
     return RunRedisCmdOnOneLineResponseInt("", true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_DELUSER(const std::vector<std::string>& vecUserName, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("DELUSER");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecUserName.begin(), vecUserName.end());
+    static const CFlyRedisCmdName hCmdName("ACL", "DELUSER");
+    EncodeRedisCmd(hCmdName, vecUserName);
     return RunRedisCmdOnOneLineResponseInt("", true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_GENPASS(std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("GENPASS");
+    static const CFlyRedisCmdName hCmdName("ACL", "GENPASS");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseString("", false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_GENPASS(int nBits, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("GENPASS");
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nBits));
+    static const CFlyRedisCmdName hCmdName("ACL", "GENPASS");
+    EncodeRedisCmd(hCmdName, nBits);
     return RunRedisCmdOnOneLineResponseString("", false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_GETUSER(const std::string& strUserName, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("GETUSER");
-    m_vecRedisCmdParamList.emplace_back(strUserName);
+    static const CFlyRedisCmdName hCmdName("ACL", "GETUSER");
+    EncodeRedisCmd(hCmdName, strUserName);
     return RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_HELP(std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("HELP");
+    static const CFlyRedisCmdName hCmdName("ACL", "HELP");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_LIST(std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("LIST");
+    static const CFlyRedisCmdName hCmdName("ACL", "LIST");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_LOAD()
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("LOAD");
+    static const CFlyRedisCmdName hCmdName("ACL", "LOAD");
+    EncodeRedisCmd(hCmdName);
     std::string strResult;
     if (!RunRedisCmdOnOneLineResponseString("", true, strResult, __FUNCTION__))
     {
@@ -1268,17 +4036,15 @@ bool CFlyRedisClient::ACL_LOAD()
 
 bool CFlyRedisClient::ACL_LOG(std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("LOG");
+    static const CFlyRedisCmdName hCmdName("ACL", "LOG");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_SAVE()
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("SAVE");
+    static const CFlyRedisCmdName hCmdName("ACL", "SAVE");
+    EncodeRedisCmd(hCmdName);
     std::string strResult;
     if (!RunRedisCmdOnOneLineResponseString("", true, strResult, __FUNCTION__))
     {
@@ -1317,40 +4083,40 @@ bool CFlyRedisClient::ACL_SETUSER(const std::string& strUserName, const std::str
 
 bool CFlyRedisClient::ACL_USERS(std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("USERS");
+    static const CFlyRedisCmdName hCmdName("ACL", "USERS");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ACL_WHOAMI(std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ACL");
-    m_vecRedisCmdParamList.emplace_back("WHOAMI");
+    static const CFlyRedisCmdName hCmdName("ACL", "WHOAMI");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseString("", false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::FLUSHALL(std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("FLUSHALL");
+    static const CFlyRedisCmdName hCmdName("FLUSHALL");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseString("", false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LASTSAVE(int& nUTCTime)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LASTSAVE");
+    static const CFlyRedisCmdName hCmdName("LASTSAVE");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseInt("", false, nUTCTime, __FUNCTION__);
 }
 
 bool CFlyRedisClient::TIME(int& nUnixTime, int& nMicroSeconds)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("TIME");
-    std::vector<std::string> vecResult;
-    if (!RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__))
+    static const CFlyRedisCmdName hCmdName("TIME");
+    EncodeRedisCmd(hCmdName);
+    // Both fields are decoded from recv buff without temporary string
+    std::vector<long long> vecResult;
+    CFlyRedisContainerDecoder<std::vector<long long> > hContainerDecoder(vecResult);
+    if (!RunRedisCmdOnElementDecoder("", false, hContainerDecoder, __FUNCTION__))
     {
         return false;
     }
@@ -1358,33 +4124,39 @@ bool CFlyRedisClient::TIME(int& nUnixTime, int& nMicroSeconds)
     {
         return false;
     }
-    nUnixTime = atoi(vecResult[0].c_str());
-    nMicroSeconds = atoi(vecResult[0].c_str());
+    nUnixTime = static_cast<int>(vecResult[0]);
+    nMicroSeconds = static_cast<int>(vecResult[1]);
     return true;
 }
 
 bool CFlyRedisClient::ROLE(std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LASTSAVE");
+    static const CFlyRedisCmdName hCmdName("LASTSAVE");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::DBSIZE(int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("DBSIZE");
+    static const CFlyRedisCmdName hCmdName("DBSIZE");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseInt("", false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::KEYS(const std::string& strMatchPattern, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("KEYS");
-    m_vecRedisCmdParamList.emplace_back(strMatchPattern);
+    static const CFlyRedisCmdName hCmdName("KEYS");
+    EncodeRedisCmd(hCmdName, strMatchPattern);
     return RunRedisCmdOnOneLineResponseVector("", false, vecResult, __FUNCTION__);
 }
 
+bool CFlyRedisClient::KEYS(const std::string& strMatchPattern, const FlyRedisElementVisitor& fnVisitor)
+{
+    static const CFlyRedisCmdName hCmdName("KEYS");
+    EncodeRedisCmd(hCmdName, strMatchPattern);
+    return RunRedisCmdOnElementVisitor("", false, fnVisitor, __FUNCTION__);
+}
+
 bool CFlyRedisClient::SELECT(int nIndex)
 {
     if (m_bClusterFlag)
@@ -1392,37 +4164,30 @@ bool CFlyRedisClient::SELECT(int nIndex)
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "Cluster Not Support Command SELECT");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SELECT");
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nIndex));
+    static const CFlyRedisCmdName hCmdName("SELECT");
+    EncodeRedisCmd(hCmdName, nIndex);
     std::string strResult;
     return RunRedisCmdOnOneLineResponseString("", false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::APPEND(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("APPEND");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("APPEND");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::BITCOUNT(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITCOUNT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("BITCOUNT");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::BITCOUNT(const std::string& strKey, int nStart, int nEnd, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITCOUNT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nEnd));
+    static const CFlyRedisCmdName hCmdName("BITCOUNT");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nEnd);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
@@ -1433,11 +4198,8 @@ bool CFlyRedisClient::BITOP_AND(const std::string& strDestKey, const std::string
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITOP");
-    m_vecRedisCmdParamList.emplace_back("AND");
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.emplace_back(strSrcKey);
+    static const CFlyRedisCmdName hCmdName("BITOP");
+    EncodeRedisCmd(hCmdName, "AND", strDestKey, strSrcKey);
     return RunRedisCmdOnOneLineResponseInt(strDestKey, true, nResult, __FUNCTION__);
 }
 
@@ -1448,11 +4210,8 @@ bool CFlyRedisClient::BITOP_OR(const std::string& strDestKey, const std::string&
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITOP");
-    m_vecRedisCmdParamList.emplace_back("OR");
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.emplace_back(strSrcKey);
+    static const CFlyRedisCmdName hCmdName("BITOP");
+    EncodeRedisCmd(hCmdName, "OR", strDestKey, strSrcKey);
     return RunRedisCmdOnOneLineResponseInt(strDestKey, true, nResult, __FUNCTION__);
 }
 
@@ -1463,11 +4222,8 @@ bool CFlyRedisClient::BITOP_XOR(const std::string& strDestKey, const std::string
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITOP");
-    m_vecRedisCmdParamList.emplace_back("XOR");
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.emplace_back(strSrcKey);
+    static const CFlyRedisCmdName hCmdName("BITOP");
+    EncodeRedisCmd(hCmdName, "XOR", strDestKey, strSrcKey);
     return RunRedisCmdOnOneLineResponseInt(strDestKey, true, nResult, __FUNCTION__);
 }
 
@@ -1478,128 +4234,95 @@ bool CFlyRedisClient::BITOP_NOT(const std::string& strDestKey, const std::string
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITOP");
-    m_vecRedisCmdParamList.emplace_back("NOT");
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.emplace_back(strSrcKey);
+    static const CFlyRedisCmdName hCmdName("BITOP");
+    EncodeRedisCmd(hCmdName, "NOT", strDestKey, strSrcKey);
     return RunRedisCmdOnOneLineResponseInt(strDestKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::BITPOS(const std::string& strKey, int nBit, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITPOS");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nBit));
+    static const CFlyRedisCmdName hCmdName("BITPOS");
+    EncodeRedisCmd(hCmdName, strKey, nBit);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::BITPOS(const std::string& strKey, int nBit, int nStart, int nEnd, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BITPOS");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nBit));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nEnd));
+    static const CFlyRedisCmdName hCmdName("BITPOS");
+    EncodeRedisCmd(hCmdName, strKey, nBit, nStart, nEnd);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::DECR(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("DECR");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("DECR");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::DECRBY(const std::string& strKey, int nDecrement, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("DECRBY");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nDecrement));
+    static const CFlyRedisCmdName hCmdName("DECRBY");
+    EncodeRedisCmd(hCmdName, strKey, nDecrement);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::GET(const std::string& strKey, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("GET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("GET");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::GETBIT(const std::string& strKey, int nOffset, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("GETBIT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nOffset));
+    static const CFlyRedisCmdName hCmdName("GETBIT");
+    EncodeRedisCmd(hCmdName, strKey, nOffset);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::GETRANGE(const std::string& strKey, int nStart, int nEnd, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("GETRANGE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nEnd));
+    static const CFlyRedisCmdName hCmdName("GETRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nEnd);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::GETSET(const std::string& strKey, const std::string& strValue, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("GETSET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("GETSET");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::INCR(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("INCR");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("INCR");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::INCRBY(const std::string& strKey, int nIncrement, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("INCRBY");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nIncrement));
+    static const CFlyRedisCmdName hCmdName("INCRBY");
+    EncodeRedisCmd(hCmdName, strKey, nIncrement);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 
 bool CFlyRedisClient::INCRBYFLOAT(const std::string& strKey, double fIncrement, double& fResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("INCRBYFLOAT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(fIncrement));
+    static const CFlyRedisCmdName hCmdName("INCRBYFLOAT");
+    EncodeRedisCmd(hCmdName, strKey, fIncrement);
     return RunRedisCmdOnOneLineResponseDouble(strKey, true, fResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::MGET(const std::vector<std::string>& vecKey, std::vector<std::string>& vecResult)
 {
-    if (vecKey.empty())
-    {
-        return false;
-    }
-    if (m_bClusterFlag && !CFlyRedis::IsMultiKeyOnTheSameNode(vecKey))
+    if (!BuildMGETCmd(vecKey))
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("MGET");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
     if (!RunRedisCmdOnOneLineResponseVector(vecKey.front(), false, vecResult, __FUNCTION__))
     {
         return false;
@@ -1648,11 +4371,8 @@ bool CFlyRedisClient::MSETNX(const std::map<std::string, std::string>& mapKeyVal
 
 bool CFlyRedisClient::PSETEX(const std::string& strKey, int nTimeOutMS, const std::string& strValue, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PSETEX");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nTimeOutMS));
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("PSETEX");
+    EncodeRedisCmd(hCmdName, strKey, nTimeOutMS, strValue);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
@@ -1662,6 +4382,12 @@ bool CFlyRedisClient::VerifyRedisSessionList()
     {
         return true;
     }
+    // Broken session is closed by pool when it is returned
+    if (nullptr != m_pRedisSessionPool)
+    {
+        m_bHasBadRedisSession = false;
+        return true;
+    }
     std::vector<CFlyRedisSession*> vBadSession;
     PingEveryRedisNode(vBadSession);
     if (vBadSession.empty() && (int)m_mapRedisSession.size() == m_nRedisNodeCount)
@@ -1684,11 +4410,13 @@ bool CFlyRedisClient::VerifyRedisSessionList()
 
 bool CFlyRedisClient::SCRIPT_LOAD(const std::string& strScript, std::string& strResult)
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
+    std::vector<CFlyRedisSession*> vecRedisSession;
+    FetchEveryRedisSession(vecRedisSession);
     bool bResult = true;
     std::set<std::string> setSHA;
-    for (auto& kvp : m_mapRedisSession)
+    for (CFlyRedisSession* pRedisSession : vecRedisSession)
     {
-        CFlyRedisSession* pRedisSession = kvp.second;
         if (nullptr != pRedisSession)
         {
             if (!pRedisSession->SCRIPT_LOAD(strScript, strResult))
@@ -1708,10 +4436,12 @@ bool CFlyRedisClient::SCRIPT_LOAD(const std::string& strScript, std::string& str
 
 bool CFlyRedisClient::SCRIPT_FLUSH()
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
+    std::vector<CFlyRedisSession*> vecRedisSession;
+    FetchEveryRedisSession(vecRedisSession);
     bool bResult = true;
-    for (auto& kvp : m_mapRedisSession)
+    for (CFlyRedisSession* pRedisSession : vecRedisSession)
     {
-        CFlyRedisSession* pRedisSession = kvp.second;
         if (nullptr != pRedisSession)
         {
             if (!pRedisSession->SCRIPT_FLUSH())
@@ -1725,10 +4455,12 @@ bool CFlyRedisClient::SCRIPT_FLUSH()
 
 bool CFlyRedisClient::SCRIPT_EXISTS(const std::string& strSHA)
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
+    std::vector<CFlyRedisSession*> vecRedisSession;
+    FetchEveryRedisSession(vecRedisSession);
     bool bResult = true;
-    for (auto& kvp : m_mapRedisSession)
+    for (CFlyRedisSession* pRedisSession : vecRedisSession)
     {
-        CFlyRedisSession* pRedisSession = kvp.second;
         if (nullptr != pRedisSession)
         {
             if (!pRedisSession->SCRIPT_EXISTS(strSHA))
@@ -1753,11 +4485,8 @@ bool CFlyRedisClient::EVALSHA(const std::string& strSHA, const std::vector<std::
         return false;
     }
     const std::string& strKeySeed = vecKey.front();
-    m_vecRedisCmdParamList.emplace_back("EVALSHA");
-    m_vecRedisCmdParamList.emplace_back(strSHA);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(vecKey.size()));
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecArgv.begin(), vecArgv.end());
+    static const CFlyRedisCmdName hCmdName("EVALSHA");
+    EncodeRedisCmd(hCmdName, strSHA, vecKey.size(), vecKey, vecArgv);
     return RunRedisCmdOnOneLineResponseString(strKeySeed, true, strResult, __FUNCTION__);
 }
 
@@ -1797,11 +4526,8 @@ bool CFlyRedisClient::EVAL(const std::string& strScript, const std::vector<std::
         return false;
     }
     const std::string& strKeySeed = vecKey.front();
-    m_vecRedisCmdParamList.emplace_back("EVAL");
-    m_vecRedisCmdParamList.emplace_back(strScript);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(vecKey.size()));
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecArgv.begin(), vecArgv.end());
+    static const CFlyRedisCmdName hCmdName("EVAL");
+    EncodeRedisCmd(hCmdName, strScript, vecKey.size(), vecKey, vecArgv);
     return RunRedisCmdOnOneLineResponseString(strKeySeed, true, strResult, __FUNCTION__);
 }
 
@@ -1824,62 +4550,50 @@ bool CFlyRedisClient::EVAL(const std::string& strScript, const std::string& strK
 
 bool CFlyRedisClient::EXISTS(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("EXISTS");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("EXISTS");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::EXPIRE(const std::string& strKey, int nSeconds, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("EXPIRE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nSeconds));
+    static const CFlyRedisCmdName hCmdName("EXPIRE");
+    EncodeRedisCmd(hCmdName, strKey, nSeconds);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::EXPIREAT(const std::string& strKey, int nTimestamp, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("EXPIREAT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nTimestamp));
+    static const CFlyRedisCmdName hCmdName("EXPIREAT");
+    EncodeRedisCmd(hCmdName, strKey, nTimestamp);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PERSIST(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PERSIST");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("PERSIST");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PEXPIRE(const std::string& strKey, int nMS, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PEXPIRE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nMS));
+    static const CFlyRedisCmdName hCmdName("PEXPIRE");
+    EncodeRedisCmd(hCmdName, strKey, nMS);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PEXPIREAT(const std::string& strKey, int nMS, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PEXPIREAT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nMS));
+    static const CFlyRedisCmdName hCmdName("PEXPIREAT");
+    EncodeRedisCmd(hCmdName, strKey, nMS);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SET(const std::string& strKey, const std::string& strValue)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("SET");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     std::string strResult;
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__) && strResult.compare("OK") == 0;
 }
@@ -1978,33 +4692,29 @@ bool CFlyRedisClient::ZSCAN(const std::string& strKey, int nCursor, const std::s
 
 bool CFlyRedisClient::DEL(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("DEL");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("DEL");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::DUMP(const std::string& strKey, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("DUMP");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("DUMP");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::TTL(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("TTL");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("TTL");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PTTL(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PTTL");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("PTTL");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
@@ -2015,10 +4725,8 @@ bool CFlyRedisClient::RENAME(const std::string& strFromKey, const std::string& s
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("RENAME");
-    m_vecRedisCmdParamList.emplace_back(strFromKey);
-    m_vecRedisCmdParamList.emplace_back(strToKey);
+    static const CFlyRedisCmdName hCmdName("RENAME");
+    EncodeRedisCmd(hCmdName, strFromKey, strToKey);
     return RunRedisCmdOnOneLineResponseString(strFromKey, true, strResult, __FUNCTION__);
 }
 
@@ -2029,111 +4737,95 @@ bool CFlyRedisClient::RENAMENX(const std::string& strFromKey, const std::string&
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("RENAMENX");
-    m_vecRedisCmdParamList.emplace_back(strFromKey);
-    m_vecRedisCmdParamList.emplace_back(strToKey);
+    static const CFlyRedisCmdName hCmdName("RENAMENX");
+    EncodeRedisCmd(hCmdName, strFromKey, strToKey);
     return RunRedisCmdOnOneLineResponseString(strFromKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::TOUCH(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("TOUCH");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("TOUCH");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::TYPE(const std::string& strKey, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("TYPE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("TYPE");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::UNLINK(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("UNLINK");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("UNLINK");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SETEX(const std::string& strKey, int nTimeOutSeconds, const std::string& strValue, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SETEX");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nTimeOutSeconds));
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("SETEX");
+    EncodeRedisCmd(hCmdName, strKey, nTimeOutSeconds, strValue);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SETNX(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SETNX");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("SETNX");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SETRANGE(const std::string& strKey, int nOffset, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SETRANGE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nOffset));
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("SETRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nOffset, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::STRLEN(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("STRLEN");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("STRLEN");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HSET(const std::string& strKey, const std::string& strField, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HSET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("HSET");
+    EncodeRedisCmd(hCmdName, strKey, strField, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HSETNX(const std::string& strKey, const std::string& strField, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HSETNX");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("HSETNX");
+    EncodeRedisCmd(hCmdName, strKey, strField, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HSTRLEN(const std::string& strKey, const std::string& strField, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HSTRLEN");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
+    static const CFlyRedisCmdName hCmdName("HSTRLEN");
+    EncodeRedisCmd(hCmdName, strKey, strField);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HVALS(const std::string& strKey, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HVALS");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("HVALS");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
+bool CFlyRedisClient::HVALS(const std::string& strKey, const FlyRedisElementVisitor& fnVisitor)
+{
+    static const CFlyRedisCmdName hCmdName("HVALS");
+    EncodeRedisCmd(hCmdName, strKey);
+    return RunRedisCmdOnElementVisitor(strKey, false, fnVisitor, __FUNCTION__);
+}
+
 bool CFlyRedisClient::HMSET(const std::string& strKey, const std::map<std::string, std::string>& mapFieldValue, std::string& strResult)
 {
     ClearRedisCmdCache();
@@ -2149,11 +4841,8 @@ bool CFlyRedisClient::HMSET(const std::string& strKey, const std::map<std::strin
 
 bool CFlyRedisClient::HMSET(const std::string& strKey, const std::string& strField, const std::string& strValue, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HMSET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("HMSET");
+    EncodeRedisCmd(hCmdName, strKey, strField, strValue);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strResult, __FUNCTION__);
 }
 
@@ -2166,280 +4855,215 @@ bool CFlyRedisClient::HGETALL(const std::string& strKey, std::map<std::string, s
     return RunRedisCmdOnResponseKVP(strKey, false, mapFieldValue, __FUNCTION__);
 }
 
+bool CFlyRedisClient::HGETALL(const std::string& strKey, const FlyRedisKVPVisitor& fnVisitor)
+{
+    static const CFlyRedisCmdName hCmdName("HGETALL");
+    EncodeRedisCmd(hCmdName, strKey);
+    return RunRedisCmdOnKVPVisitor(strKey, false, fnVisitor, __FUNCTION__);
+}
+
 bool CFlyRedisClient::HDEL(const std::string& strKey, const std::string& strField, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HDEL");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
+    static const CFlyRedisCmdName hCmdName("HDEL");
+    EncodeRedisCmd(hCmdName, strKey, strField);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HEXISTS(const std::string& strKey, const std::string& strField, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HEXISTS");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
+    static const CFlyRedisCmdName hCmdName("HEXISTS");
+    EncodeRedisCmd(hCmdName, strKey, strField);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HGET(const std::string& strKey, const std::string& strField, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HGET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
+    static const CFlyRedisCmdName hCmdName("HGET");
+    EncodeRedisCmd(hCmdName, strKey, strField);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HMGET(const std::string& strKey, const std::string& strField, std::string& strValue)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HMGET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
+    static const CFlyRedisCmdName hCmdName("HMGET");
+    EncodeRedisCmd(hCmdName, strKey, strField);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strValue, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HMGET(const std::string& strKey, const std::vector<std::string>& vecField, std::vector<std::string>& vecOutput)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HMGET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecField.begin(), vecField.end());
+    static const CFlyRedisCmdName hCmdName("HMGET");
+    EncodeRedisCmd(hCmdName, strKey, vecField);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecOutput, __FUNCTION__) && vecOutput.size() == vecField.size();
 }
 
 bool CFlyRedisClient::HINCRBY(const std::string& strKey, const std::string& strField, int nIncVal, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HINCRBY");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nIncVal));
+    static const CFlyRedisCmdName hCmdName("HINCRBY");
+    EncodeRedisCmd(hCmdName, strKey, strField, nIncVal);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HINCRBYFLOAT(const std::string& strKey, const std::string& strField, double fIncVal, double& fResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HINCRBYFLOAT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strField);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(fIncVal));
+    static const CFlyRedisCmdName hCmdName("HINCRBYFLOAT");
+    EncodeRedisCmd(hCmdName, strKey, strField, fIncVal);
     return RunRedisCmdOnOneLineResponseDouble(strKey, true, fResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::HKEYS(const std::string& strKey, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HKEYS");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("HKEYS");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
+bool CFlyRedisClient::HKEYS(const std::string& strKey, const FlyRedisElementVisitor& fnVisitor)
+{
+    static const CFlyRedisCmdName hCmdName("HKEYS");
+    EncodeRedisCmd(hCmdName, strKey);
+    return RunRedisCmdOnElementVisitor(strKey, false, fnVisitor, __FUNCTION__);
+}
+
 bool CFlyRedisClient::HLEN(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("HLEN");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("HLEN");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZADD(const std::string& strKey, double fScore, const std::string& strMember, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZADD");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(fScore));
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("ZADD");
+    EncodeRedisCmd(hCmdName, strKey, fScore, strMember);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZADD(const std::string& strKey, unsigned long long nScore, const std::string& strMember, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZADD");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nScore));
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("ZADD");
+    EncodeRedisCmd(hCmdName, strKey, nScore, strMember);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZCARD(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZCARD");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("ZCARD");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZCOUNT(const std::string& strKey, const std::string& strMin, const std::string& strMax, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZCOUNT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strMin);
-    m_vecRedisCmdParamList.emplace_back(strMax);
+    static const CFlyRedisCmdName hCmdName("ZCOUNT");
+    EncodeRedisCmd(hCmdName, strKey, strMin, strMax);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZINCRBY(const std::string& strKey, double fIncrement, const std::string& strMember, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZINCRBY");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(fIncrement));
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("ZINCRBY");
+    EncodeRedisCmd(hCmdName, strKey, fIncrement, strMember);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZRANGE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStop));
+    static const CFlyRedisCmdName hCmdName("ZRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
+bool CFlyRedisClient::ZRANGE(const std::string& strKey, int nStart, int nStop, const FlyRedisElementVisitor& fnVisitor)
+{
+    static const CFlyRedisCmdName hCmdName("ZRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
+    return RunRedisCmdOnElementVisitor(strKey, false, fnVisitor, __FUNCTION__);
+}
+
 bool CFlyRedisClient::ZRANGEBYSCORE(const std::string& strKey, int nMin, int nMax, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZRANGEBYSCORE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nMin));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nMax));
+    static const CFlyRedisCmdName hCmdName("ZRANGEBYSCORE");
+    EncodeRedisCmd(hCmdName, strKey, nMin, nMax);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZRANGEBYSCORE(const std::string& strKey, const std::string& strMin, const std::string& strMax, std::vector<std::string>& vecResult)
-{
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZRANGEBYSCORE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strMin);
-    m_vecRedisCmdParamList.emplace_back(strMax);
+{
+    static const CFlyRedisCmdName hCmdName("ZRANGEBYSCORE");
+    EncodeRedisCmd(hCmdName, strKey, strMin, strMax);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZREVRANGEBYSCORE(const std::string& strKey, int nMin, int nMax, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZREVRANGEBYSCORE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nMin));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nMax));
+    static const CFlyRedisCmdName hCmdName("ZREVRANGEBYSCORE");
+    EncodeRedisCmd(hCmdName, strKey, nMin, nMax);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZRANK(const std::string& strKey, const std::string& strMember, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZRANK");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("ZRANK");
+    EncodeRedisCmd(hCmdName, strKey, strMember);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZREVRANGE_WITHSCORES(const std::string& strKey, int nStart, int nStop, std::vector<std::pair<std::string, double> >& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZREVRANGE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStop));
-    m_vecRedisCmdParamList.emplace_back("WITHSCORES");
-    std::vector< std::pair< std::string, std::string> > vecPairList;
-    if (!RunRedisCmdOnResponsePairList(strKey, false, vecPairList, __FUNCTION__))
-    {
-        return false;
-    }
-    for (auto& kvp : vecPairList)
-    {
-        const std::string& strMember = kvp.first;
-        double fScore = atof(kvp.second.c_str());
-        vecResult.emplace_back(strMember, fScore);
-    }
-    return true;
+    static const CFlyRedisCmdName hCmdName("ZREVRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop, "WITHSCORES");
+    CFlyRedisContainerDecoder<std::vector<std::pair<std::string, double> > > hContainerDecoder(vecResult);
+    return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZREMRANGEBYSCORE(const std::string& strKey, double fFromScore, double fToScore, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZREMRANGEBYSCORE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(fFromScore));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(fToScore));
+    static const CFlyRedisCmdName hCmdName("ZREMRANGEBYSCORE");
+    EncodeRedisCmd(hCmdName, strKey, fFromScore, fToScore);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZRANGE_WITHSCORES(const std::string& strKey, int nStart, int nStop, std::vector<std::pair<std::string, double> >& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZRANGE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStop));
-    m_vecRedisCmdParamList.emplace_back("WITHSCORES");
-    std::vector< std::pair< std::string, std::string> > vecPairList;
-    if (!RunRedisCmdOnResponsePairList(strKey, false, vecPairList, __FUNCTION__))
-    {
-        return false;
-    }
-    for (auto& kvp : vecPairList)
-    {
-        const std::string& strMember = kvp.first;
-        double fScore = atof(kvp.second.c_str());
-        vecResult.emplace_back(strMember, fScore);
-    }
-    return true;
+    static const CFlyRedisCmdName hCmdName("ZRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop, "WITHSCORES");
+    CFlyRedisContainerDecoder<std::vector<std::pair<std::string, double> > > hContainerDecoder(vecResult);
+    return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZREVRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZREVRANGE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStop));
+    static const CFlyRedisCmdName hCmdName("ZREVRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZSCORE(const std::string& strKey, const std::string& strMember, double& fResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZSCORE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("ZSCORE");
+    EncodeRedisCmd(hCmdName, strKey, strMember);
     return RunRedisCmdOnOneLineResponseDouble(strKey, false, fResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PFADD(const std::string& strKey, const std::string& strElement, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PFADD");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strElement);
+    static const CFlyRedisCmdName hCmdName("PFADD");
+    EncodeRedisCmd(hCmdName, strKey, strElement);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PFADD(const std::string& strKey, const std::vector<std::string>& vecElements, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PFADD");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecElements.begin(), vecElements.end());
+    static const CFlyRedisCmdName hCmdName("PFADD");
+    EncodeRedisCmd(hCmdName, strKey, vecElements);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PFCOUNT(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PFCOUNT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("PFCOUNT");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
@@ -2454,9 +5078,8 @@ bool CFlyRedisClient::PFCOUNT(const std::vector<std::string>& vecKey, int& nResu
         return false;
     }
     const std::string& strSeedKey = vecKey.front();
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PFCOUNT");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
+    static const CFlyRedisCmdName hCmdName("PFCOUNT");
+    EncodeRedisCmd(hCmdName, vecKey);
     return RunRedisCmdOnOneLineResponseInt(strSeedKey, false, nResult, __FUNCTION__);
 }
 
@@ -2471,9 +5094,8 @@ bool CFlyRedisClient::PFMERGE(const std::vector<std::string>& vecKey, int& nResu
         return false;
     }
     const std::string& strSeedKey = vecKey.front();
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PFCOUNT");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
+    static const CFlyRedisCmdName hCmdName("PFCOUNT");
+    EncodeRedisCmd(hCmdName, vecKey);
     return RunRedisCmdOnOneLineResponseInt(strSeedKey, true, nResult, __FUNCTION__);
 }
 
@@ -2483,160 +5105,127 @@ bool CFlyRedisClient::PFMERGE(const std::string& strKey1, const std::string& str
     {
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PFCOUNT");
-    m_vecRedisCmdParamList.emplace_back(strKey1);
-    m_vecRedisCmdParamList.emplace_back(strKey2);
+    static const CFlyRedisCmdName hCmdName("PFCOUNT");
+    EncodeRedisCmd(hCmdName, strKey1, strKey2);
     return RunRedisCmdOnOneLineResponseInt(strKey1, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::BLPOP(const std::string& strKey, int nTimeout, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BLPOP");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nTimeout));
+    static const CFlyRedisCmdName hCmdName("BLPOP");
+    EncodeRedisCmd(hCmdName, strKey, nTimeout);
     return RunRedisCmdOnOneLineResponseVector(strKey, true, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::BRPOP(const std::string& strKey, int nTimeout, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BRPOP");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nTimeout));
+    static const CFlyRedisCmdName hCmdName("BRPOP");
+    EncodeRedisCmd(hCmdName, strKey, nTimeout);
     return RunRedisCmdOnOneLineResponseVector(strKey, true, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::BRPOPLPUSH(const std::string& strSrcKey, const std::string& strDstKey, int nTimeout, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("BRPOPLPUSH");
-    m_vecRedisCmdParamList.emplace_back(strSrcKey);
-    m_vecRedisCmdParamList.emplace_back(strDstKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nTimeout));
+    static const CFlyRedisCmdName hCmdName("BRPOPLPUSH");
+    EncodeRedisCmd(hCmdName, strSrcKey, strDstKey, nTimeout);
     return RunRedisCmdOnOneLineResponseString(strSrcKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LINDEX(const std::string& strKey, int nIndex, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LINDEX");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nIndex));
+    static const CFlyRedisCmdName hCmdName("LINDEX");
+    EncodeRedisCmd(hCmdName, strKey, nIndex);
     return RunRedisCmdOnOneLineResponseString(strKey, false, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LINSERT_BEFORE(const std::string& strKey, const std::string& strPivot, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LINSERT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back("BEFORE");
-    m_vecRedisCmdParamList.emplace_back(strPivot);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("LINSERT");
+    EncodeRedisCmd(hCmdName, strKey, "BEFORE", strPivot, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LINSERT_AFTER(const std::string& strKey, const std::string& strPivot, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LINSERT");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back("AFTER");
-    m_vecRedisCmdParamList.emplace_back(strPivot);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("LINSERT");
+    EncodeRedisCmd(hCmdName, strKey, "AFTER", strPivot, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LLEN(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LLEN");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("LLEN");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LPOP(const std::string& strKey, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LPOP");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("LPOP");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ZREM(const std::string& strKey, const std::string& strMember, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("ZREM");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("ZREM");
+    EncodeRedisCmd(hCmdName, strKey, strMember);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LPUSH(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LPUSH");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("LPUSH");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LPUSHX(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LPUSHX");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("LPUSHX");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LRANGE");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStop));
+    static const CFlyRedisCmdName hCmdName("LRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
+bool CFlyRedisClient::LRANGE(const std::string& strKey, int nStart, int nStop, const FlyRedisElementVisitor& fnVisitor)
+{
+    static const CFlyRedisCmdName hCmdName("LRANGE");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
+    return RunRedisCmdOnElementVisitor(strKey, false, fnVisitor, __FUNCTION__);
+}
+
 bool CFlyRedisClient::LREM(const std::string& strKey, int nCount, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LREM");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nCount));
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("LREM");
+    EncodeRedisCmd(hCmdName, strKey, nCount, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LSET(const std::string& strKey, int nIndex, const std::string& strValue, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LSET");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nIndex));
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("LSET");
+    EncodeRedisCmd(hCmdName, strKey, nIndex, strValue);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::LTRIM(const std::string& strKey, int nStart, int nStop, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("LTRIM");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStart));
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nStop));
+    static const CFlyRedisCmdName hCmdName("LTRIM");
+    EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::RPOP(const std::string& strKey, std::string& strResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("RPOP");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("RPOP");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseString(strKey, true, strResult, __FUNCTION__);
 }
 
@@ -2647,45 +5236,36 @@ bool CFlyRedisClient::RPOPLPUSH(const std::string& strSrcKey, const std::string&
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("RPOPLPUSH");
-    m_vecRedisCmdParamList.emplace_back(strSrcKey);
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
+    static const CFlyRedisCmdName hCmdName("RPOPLPUSH");
+    EncodeRedisCmd(hCmdName, strSrcKey, strDestKey);
     return RunRedisCmdOnOneLineResponseVector(strSrcKey, true, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::RPUSH(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("RPUSH");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("RPUSH");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::RPUSHX(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("RPUSHX");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("RPUSHX");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SADD(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SADD");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("SADD");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SCARD(const std::string& strKey, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SCARD");
-    m_vecRedisCmdParamList.emplace_back(strKey);
+    static const CFlyRedisCmdName hCmdName("SCARD");
+    EncodeRedisCmd(hCmdName, strKey);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
@@ -2696,10 +5276,8 @@ bool CFlyRedisClient::SDIFF(const std::string& strFirstKey, const std::string& s
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SDIFF");
-    m_vecRedisCmdParamList.emplace_back(strFirstKey);
-    m_vecRedisCmdParamList.emplace_back(strSecondKey);
+    static const CFlyRedisCmdName hCmdName("SDIFF");
+    EncodeRedisCmd(hCmdName, strFirstKey, strSecondKey);
     return RunRedisCmdOnOneLineResponseVector(strFirstKey, false, vecResult, __FUNCTION__);
 }
 
@@ -2714,9 +5292,8 @@ bool CFlyRedisClient::SDIFF(const std::vector<std::string>& vecKey, std::vector<
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SDIFF");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
+    static const CFlyRedisCmdName hCmdName("SDIFF");
+    EncodeRedisCmd(hCmdName, vecKey);
     return RunRedisCmdOnOneLineResponseVector(vecKey.front(), false, vecResult, __FUNCTION__);
 }
 
@@ -2727,10 +5304,8 @@ bool CFlyRedisClient::SDIFFSTORE(const std::string& strDestKey, const std::vecto
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SDIFFSTORE");
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecSrcKey.begin(), vecSrcKey.end());
+    static const CFlyRedisCmdName hCmdName("SDIFFSTORE");
+    EncodeRedisCmd(hCmdName, strDestKey, vecSrcKey);
     return RunRedisCmdOnOneLineResponseInt(strDestKey, true, nResult, __FUNCTION__);
 }
 
@@ -2741,10 +5316,8 @@ bool CFlyRedisClient::SINTER(const std::string& strFirstKey, const std::string&
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SINTER");
-    m_vecRedisCmdParamList.emplace_back(strFirstKey);
-    m_vecRedisCmdParamList.emplace_back(strSecondKey);
+    static const CFlyRedisCmdName hCmdName("SINTER");
+    EncodeRedisCmd(hCmdName, strFirstKey, strSecondKey);
     return RunRedisCmdOnOneLineResponseVector(strFirstKey, false, vecResult, __FUNCTION__);
 }
 
@@ -2759,9 +5332,8 @@ bool CFlyRedisClient::SINTER(const std::vector<std::string>& vecKey, std::vector
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SINTER");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecKey.begin(), vecKey.end());
+    static const CFlyRedisCmdName hCmdName("SINTER");
+    EncodeRedisCmd(hCmdName, vecKey);
     return RunRedisCmdOnOneLineResponseVector(vecKey.front(), false, vecResult, __FUNCTION__);
 }
 
@@ -2772,28 +5344,22 @@ bool CFlyRedisClient::SINTERSTORE(const std::string& strDestKey, const std::vect
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SINTERSTORE");
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecSrcKey.begin(), vecSrcKey.end());
+    static const CFlyRedisCmdName hCmdName("SINTERSTORE");
+    EncodeRedisCmd(hCmdName, strDestKey, vecSrcKey);
     return RunRedisCmdOnOneLineResponseInt(strDestKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SISMEMBER(const std::string& strKey, const std::string& strMember, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SISMEMBER");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("SISMEMBER");
+    EncodeRedisCmd(hCmdName, strKey, strMember);
     return RunRedisCmdOnOneLineResponseInt(strKey, false, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SREM(const std::string& strKey, const std::string& strValue, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SREM");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(strValue);
+    static const CFlyRedisCmdName hCmdName("SREM");
+    EncodeRedisCmd(hCmdName, strKey, strValue);
     return RunRedisCmdOnOneLineResponseInt(strKey, true, nResult, __FUNCTION__);
 }
 
@@ -2808,9 +5374,8 @@ bool CFlyRedisClient::SUNION(const std::vector<std::string>& vecSrcKey, std::vec
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SUNION");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecSrcKey.begin(), vecSrcKey.end());
+    static const CFlyRedisCmdName hCmdName("SUNION");
+    EncodeRedisCmd(hCmdName, vecSrcKey);
     return RunRedisCmdOnOneLineResponseVector(vecSrcKey.front(), false, vecResult, __FUNCTION__);
 }
 
@@ -2821,19 +5386,15 @@ bool CFlyRedisClient::SUNIONSTORE(const std::string& strDestKey, const std::vect
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SUNIONSTORE");
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecSrcKey.begin(), vecSrcKey.end());
+    static const CFlyRedisCmdName hCmdName("SUNIONSTORE");
+    EncodeRedisCmd(hCmdName, strDestKey, vecSrcKey);
     return RunRedisCmdOnOneLineResponseInt(strDestKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PUBLISH(const std::string& strChannel, const std::string& strMsg, int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PUBLISH");
-    m_vecRedisCmdParamList.emplace_back(strChannel);
-    m_vecRedisCmdParamList.emplace_back(strMsg);
+    static const CFlyRedisCmdName hCmdName("PUBLISH");
+    EncodeRedisCmd(hCmdName, strChannel, strMsg);
     return RunRedisCmdOnOneLineResponseInt("", true, nResult, __FUNCTION__);
 }
 
@@ -2850,16 +5411,15 @@ bool CFlyRedisClient::UNSUBSCRIBE(const std::string& strChannel, std::vector<std
 
 bool CFlyRedisClient::UNSUBSCRIBE(std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("UNSUBSCRIBE");
+    static const CFlyRedisCmdName hCmdName("UNSUBSCRIBE");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseVector("", true, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::PUNSUBSCRIBE(const std::string& strPattern, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PUNSUBSCRIBE");
-    m_vecRedisCmdParamList.emplace_back(strPattern);
+    static const CFlyRedisCmdName hCmdName("PUNSUBSCRIBE");
+    EncodeRedisCmd(hCmdName, strPattern);
     return RunRedisCmdOnOneLineResponseVector("", true, vecResult, __FUNCTION__);
 }
 
@@ -2895,10 +5455,8 @@ bool CFlyRedisClient::PUBSUB_NUMSUB(const std::string& strChannel, int& nResult)
 
 bool CFlyRedisClient::PUBSUB_NUMSUB(const std::vector<std::string>& vecChannel, std::map<std::string, int>& mapResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PUBSUB");
-    m_vecRedisCmdParamList.emplace_back("NUMSUB");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecChannel.begin(), vecChannel.end());
+    static const CFlyRedisCmdName hCmdName("PUBSUB", "NUMSUB");
+    EncodeRedisCmd(hCmdName, vecChannel);
     std::map<std::string, std::string> mapKVP;
     if (!RunRedisCmdOnResponseKVP("", false, mapKVP, __FUNCTION__))
     {
@@ -2913,9 +5471,8 @@ bool CFlyRedisClient::PUBSUB_NUMSUB(const std::vector<std::string>& vecChannel,
 
 bool CFlyRedisClient::PUBSUB_NUMPAT(int& nResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PUBSUB");
-    m_vecRedisCmdParamList.emplace_back("NUMPAT");
+    static const CFlyRedisCmdName hCmdName("PUBSUB", "NUMPAT");
+    EncodeRedisCmd(hCmdName);
     return RunRedisCmdOnOneLineResponseInt("", false, nResult, __FUNCTION__);
 }
 
@@ -2938,9 +5495,8 @@ bool CFlyRedisClient::SUBSCRIBE(const std::string& strChannel, FlyRedisSubscribe
 
 bool CFlyRedisClient::SUBSCRIBE(const std::vector<std::string>& vecChannel, std::vector<FlyRedisSubscribeResponse>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SUBSCRIBE");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecChannel.begin(), vecChannel.end());
+    static const CFlyRedisCmdName hCmdName("SUBSCRIBE");
+    EncodeRedisCmd(hCmdName, vecChannel);
     return RunRedisCmdOnSubscribeCmd(vecResult, static_cast<int>(vecChannel.size()), __FUNCTION__);
 }
 
@@ -2963,9 +5519,8 @@ bool CFlyRedisClient::PSUBSCRIBE(const std::string& strPattern, FlyRedisSubscrib
 
 bool CFlyRedisClient::PSUBSCRIBE(const std::vector<std::string>& vecPattern, std::vector<FlyRedisSubscribeResponse>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("PSUBSCRIBE");
-    m_vecRedisCmdParamList.insert(m_vecRedisCmdParamList.end(), vecPattern.begin(), vecPattern.end());
+    static const CFlyRedisCmdName hCmdName("PSUBSCRIBE");
+    EncodeRedisCmd(hCmdName, vecPattern);
     return RunRedisCmdOnSubscribeCmd(vecResult, static_cast<int>(vecPattern.size()), __FUNCTION__);
 }
 
@@ -3005,33 +5560,180 @@ bool CFlyRedisClient::PollPSubscribeMsg(std::vector<FlyRedisPMessageResponse>& v
     return true;
 }
 
-bool CFlyRedisClient::SMEMBERS(const std::string& strKey, std::set<std::string>& setResult)
+bool CFlyRedisClient::RunRedisCmd(const std::string& strKey, bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, const FlyRedisReplyNode*& pReply)
 {
+    pReply = nullptr;
+    if (vecRedisCmdParamList.empty())
+    {
+        return false;
+    }
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
     ClearRedisCmdCache();
-    if (nullptr == m_pCurRedisSession)
+    m_vecRedisCmdParamList = vecRedisCmdParamList;
+    m_hReplyBuilder.Reset();
+    m_hReplyBuilder.SetReplyView(false);
+    bool bResult = DeliverRedisCmd(strKey, bIsWrite, true, vecRedisCmdParamList.front().c_str(), &m_hReplyBuilder);
+    pReply = m_hReplyBuilder.GetReply();
+    return bResult && nullptr != pReply;
+}
+
+bool CFlyRedisClient::RunRedisCmdOnReplyView(const std::string& strKey, bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, const FlyRedisReplyNode*& pReply)
+{
+    pReply = nullptr;
+    if (vecRedisCmdParamList.empty())
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "NoRedisSession When Run SMEMBERS");
         return false;
     }
-    m_vecRedisCmdParamList.emplace_back("SMEMBERS");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    bool bResult = false;
-    if (2 == m_pCurRedisSession->GetRESPVersion())
+    // Leased session may be used by other thread after it is returned, then the recv buff is overwritten
+    if (nullptr != m_pRedisSessionPool)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ReplyViewIsNotSupportedInPoolMode");
+        return false;
+    }
+    ClearRedisCmdCache();
+    m_vecRedisCmdParamList = vecRedisCmdParamList;
+    m_hReplyBuilder.Reset();
+    m_hReplyBuilder.SetReplyView(true);
+    bool bResult = DeliverRedisCmd(strKey, bIsWrite, true, vecRedisCmdParamList.front().c_str(), &m_hReplyBuilder);
+    pReply = m_hReplyBuilder.GetReply();
+    return bResult && nullptr != pReply;
+}
+
+bool CFlyRedisClient::ExecPipeline(const CFlyRedisPipeline& hPipeline, std::vector<FlyRedisPipelineResponse>& vecResponse)
+{
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
+    std::chrono::steady_clock::time_point tpBegin = std::chrono::steady_clock::now();
+    const std::vector<CFlyRedisPipeline::PipelineRedisCmd>& vecRedisCmd = hPipeline.GetRedisCmdList();
+    int nCmdCount = static_cast<int>(vecRedisCmd.size());
+    vecResponse.clear();
+    vecResponse.resize(nCmdCount);
+    if (m_bHasNewClusterTopology.load())
+    {
+        ApplyNewClusterTopology();
+    }
+    if (m_bHasBadRedisSession)
+    {
+        VerifyRedisSessionList();
+    }
+    // Group cmd by the redis node which owns its key slot, cmd order is kept in every batch
+    std::vector<RedisPipelineBatch> vecPipelineBatch;
+    for (int nIndex = 0; nIndex < nCmdCount; ++nIndex)
+    {
+        const CFlyRedisPipeline::PipelineRedisCmd& stRedisCmd = vecRedisCmd[nIndex];
+        if (!ResolveRedisSession(stRedisCmd.strKey, stRedisCmd.bIsWrite))
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "CurRedisSessionIsNull %s", __FUNCTION__);
+            m_bHasBadRedisSession = true;
+            RecordCmdStats(__FUNCTION__, false, tpBegin);
+            return false;
+        }
+        RedisPipelineBatch* pPipelineBatch = nullptr;
+        for (RedisPipelineBatch& stPipelineBatch : vecPipelineBatch)
+        {
+            if (stPipelineBatch.pRedisSession == m_pCurRedisSession)
+            {
+                pPipelineBatch = &stPipelineBatch;
+                break;
+            }
+        }
+        if (nullptr == pPipelineBatch)
+        {
+            vecPipelineBatch.emplace_back();
+            pPipelineBatch = &vecPipelineBatch.back();
+            pPipelineBatch->pRedisSession = m_pCurRedisSession;
+        }
+        pPipelineBatch->vecCmdIndex.emplace_back(nIndex);
+        CFlyRedis::AppendRedisCmdRequest(m_pCurRedisSession->GetRedisAddr(), stRedisCmd.vecRedisCmdParamList, pPipelineBatch->strRedisCmdRequest, stRedisCmd.bIsWrite);
+    }
+    // Send every batch before recv any response, then redis nodes run their batch at the same time
+    bool bResult = true;
+    for (RedisPipelineBatch& stPipelineBatch : vecPipelineBatch)
     {
-        std::vector<std::string> vecResult;
-        bResult = RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
-        for (auto& strValue : vecResult)
+        stPipelineBatch.bSendFlag = stPipelineBatch.pRedisSession->SendRedisRequest(stPipelineBatch.strRedisCmdRequest);
+        if (!stPipelineBatch.bSendFlag)
         {
-            setResult.emplace(strValue);
+            m_bHasBadRedisSession = true;
+            bResult = false;
         }
     }
-    else
+    // Response of the sent batch must be received, even if other batch failed
+    for (RedisPipelineBatch& stPipelineBatch : vecPipelineBatch)
+    {
+        size_t nRecvCount = 0;
+        while (stPipelineBatch.bSendFlag && nRecvCount < stPipelineBatch.vecCmdIndex.size()
+            && stPipelineBatch.pRedisSession->RecvPipelineResponse(vecResponse[stPipelineBatch.vecCmdIndex[nRecvCount]]))
+        {
+            ++nRecvCount;
+        }
+        if (nRecvCount == stPipelineBatch.vecCmdIndex.size())
+        {
+            continue;
+        }
+        // Session is broken by failed send or recv, its unread replies are dropped when it is reconnected, so the rest cmd of this batch fail
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ProcRedisRequestFailed %s, %s, %d cmd failed", __FUNCTION__, stPipelineBatch.pRedisSession->GetRedisAddr().c_str(), static_cast<int>(stPipelineBatch.vecCmdIndex.size() - nRecvCount));
+        m_bHasBadRedisSession = true;
+        bResult = false;
+        for (; nRecvCount < stPipelineBatch.vecCmdIndex.size(); ++nRecvCount)
+        {
+            FlyRedisPipelineResponse& stPipelineResponse = vecResponse[stPipelineBatch.vecCmdIndex[nRecvCount]];
+            stPipelineResponse.bResponseError = true;
+            stPipelineResponse.stRedisResponse.Reset();
+            stPipelineResponse.stRedisResponse.strRedisResponse = "ERR FlyRedis session of " + stPipelineBatch.pRedisSession->GetRedisAddr() + " is broken";
+        }
+    }
+    if (!m_bClusterFlag)
+    {
+        RecordCmdStats(__FUNCTION__, bResult, tpBegin);
+        return bResult;
+    }
+    // Cmd which got MOVED/ASK response is redirected one by one
+    for (int nIndex = 0; nIndex < nCmdCount; ++nIndex)
     {
-        bResult = RunRedisCmdOnOneLineResponseSet(strKey, false, setResult, __FUNCTION__);
+        FlyRedisPipelineResponse& stPipelineResponse = vecResponse[nIndex];
+        if (!stPipelineResponse.bResponseError)
+        {
+            continue;
+        }
+        bool bIsAsk = false;
+        int nSlot = 0;
+        std::string strRedisAddress;
+        if (!ParseRedirectResponse(stPipelineResponse.stRedisResponse.strRedisResponse, bIsAsk, nSlot, strRedisAddress))
+        {
+            continue;
+        }
+        // The cmd has been logged when it was sent first
+        CFlyRedis::BuildRedisCmdRequest(strRedisAddress, vecRedisCmd[nIndex].vecRedisCmdParamList, m_strRedisCmdRequest, false);
+        bool bRedirectResult = RedirectRedisCmd(stPipelineResponse.stRedisResponse.strRedisResponse, m_strRedisCmdRequest);
+        if (nullptr != m_pCurRedisSession && (bRedirectResult || m_pCurRedisSession->HasResponseError()))
+        {
+            stPipelineResponse.bResponseError = m_pCurRedisSession->HasResponseError();
+            stPipelineResponse.stRedisResponse.Reset();
+            m_pCurRedisSession->SwapRedisResponse(stPipelineResponse.stRedisResponse);
+        }
+        else
+        {
+            m_bHasBadRedisSession = true;
+            bResult = false;
+        }
     }
+    RecordCmdStats(__FUNCTION__, bResult, tpBegin);
     return bResult;
 }
 
+bool CFlyRedisClient::SMEMBERS(const std::string& strKey, std::set<std::string>& setResult)
+{
+    static const CFlyRedisCmdName hCmdName("SMEMBERS");
+    EncodeRedisCmd(hCmdName, strKey);
+    return RunRedisCmdOnOneLineResponseSet(strKey, false, setResult, __FUNCTION__);
+}
+
+bool CFlyRedisClient::SMEMBERS(const std::string& strKey, const FlyRedisElementVisitor& fnVisitor)
+{
+    static const CFlyRedisCmdName hCmdName("SMEMBERS");
+    EncodeRedisCmd(hCmdName, strKey);
+    return RunRedisCmdOnElementVisitor(strKey, false, fnVisitor, __FUNCTION__);
+}
+
 bool CFlyRedisClient::SMOVE(const std::string& strSrcKey, const std::string& strDestKey, const std::string& strMember, int& nResult)
 {
     if (m_bClusterFlag && CFlyRedis::KeyHashSlot(strSrcKey) != CFlyRedis::KeyHashSlot(strDestKey))
@@ -3039,64 +5741,48 @@ bool CFlyRedisClient::SMOVE(const std::string& strSrcKey, const std::string& str
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
         return false;
     }
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SMOVE");
-    m_vecRedisCmdParamList.emplace_back(strSrcKey);
-    m_vecRedisCmdParamList.emplace_back(strDestKey);
-    m_vecRedisCmdParamList.emplace_back(strMember);
+    static const CFlyRedisCmdName hCmdName("SMOVE");
+    EncodeRedisCmd(hCmdName, strSrcKey, strDestKey, strMember);
     return RunRedisCmdOnOneLineResponseInt(strSrcKey, true, nResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SPOP(const std::string& strKey, int nCount, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SPOP");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nCount));
+    static const CFlyRedisCmdName hCmdName("SPOP");
+    EncodeRedisCmd(hCmdName, strKey, nCount);
     return RunRedisCmdOnOneLineResponseVector(strKey, true, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::SRANDMEMBER(const std::string& strKey, int nCount, std::vector<std::string>& vecResult)
 {
-    ClearRedisCmdCache();
-    m_vecRedisCmdParamList.emplace_back("SRANDMEMBER");
-    m_vecRedisCmdParamList.emplace_back(strKey);
-    m_vecRedisCmdParamList.emplace_back(std::to_string(nCount));
+    static const CFlyRedisCmdName hCmdName("SRANDMEMBER");
+    EncodeRedisCmd(hCmdName, strKey, nCount);
     return RunRedisCmdOnOneLineResponseVector(strKey, false, vecResult, __FUNCTION__);
 }
 
 bool CFlyRedisClient::ResolveRedisSession(const std::string& strKey, bool bIsWrite)
 {
-    if (!m_bClusterFlag || strKey.empty())
+    if (nullptr != m_pRedisSessionPool)
     {
-        return m_pCurRedisSession != nullptr;
+        int nSlot = (m_bClusterFlag && !strKey.empty()) ? CFlyRedis::KeyHashSlot(strKey) : -1;
+        m_pCurRedisSession = LeasePoolRedisSession(m_pRedisSessionPool->ResolveRedisNode(nSlot, bIsWrite));
+        return (nullptr != m_pCurRedisSession);
     }
-    int nSlot = CFlyRedis::KeyHashSlot(strKey);
-    if (nullptr != m_pCurRedisSession && m_pCurRedisSession->AcceptHashSlot(nSlot, bIsWrite, m_nFlyRedisReadWriteType))
+    if (!m_bClusterFlag || strKey.empty())
     {
-        return true;
+        return m_pCurRedisSession != nullptr;
     }
-    m_pCurRedisSession = nullptr;
-    for (auto& kvp : m_mapRedisSession)
+    const RedisSlotOwner& stRedisSlotOwner = m_vecRedisSlotOwner[CFlyRedis::KeyHashSlot(strKey)];
+    m_pCurRedisSession = stRedisSlotOwner.pMasterSession;
+    if (FlyRedisReadWriteType::ReadOnSlaveWriteOnMaster == m_nFlyRedisReadWriteType && !bIsWrite)
     {
-        CFlyRedisSession* pRedisSession = kvp.second;
-        if (nullptr != pRedisSession && pRedisSession->AcceptHashSlot(nSlot, bIsWrite, m_nFlyRedisReadWriteType))
+        if (nullptr != stRedisSlotOwner.pSlaveSession)
         {
-            m_pCurRedisSession = pRedisSession;
-            break;
+            m_pCurRedisSession = stRedisSlotOwner.pSlaveSession;
         }
-    }
-    if (nullptr == m_pCurRedisSession && m_nFlyRedisReadWriteType == FlyRedisReadWriteType::ReadOnSlaveWriteOnMaster && !bIsWrite)
-    {
-        CFlyRedis::Logger(FlyRedisLogLevel::Warning, "SlaveFailedSoRedirToMaster %s", strKey.c_str());
-        for (auto& kvp : m_mapRedisSession)
+        else
         {
-            CFlyRedisSession* pRedisSession = kvp.second;
-            if (nullptr != pRedisSession && pRedisSession->AcceptHashSlot(nSlot, true, m_nFlyRedisReadWriteType))
-            {
-                m_pCurRedisSession = pRedisSession;
-                break;
-            }
+            CFlyRedis::Logger(FlyRedisLogLevel::Warning, "SlaveFailedSoRedirToMaster %s", strKey.c_str());
         }
     }
     return (nullptr != m_pCurRedisSession);
@@ -3109,86 +5795,290 @@ bool CFlyRedisClient::ConnectToEveryRedisNode()
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CurRedisSessionIsNull");
         return false;
     }
-    std::vector<std::string> vecClusterNodes;
-    if (!m_pCurRedisSession->CLUSTER_NODES(vecClusterNodes))
+    std::shared_ptr<FlyRedisClusterTopology> pClusterTopology = std::make_shared<FlyRedisClusterTopology>();
+    if (!m_pCurRedisSession->FetchClusterTopology(*pClusterTopology))
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "FetchClusterTopologyFailed %s", m_pCurRedisSession->GetRedisAddr().c_str());
+        return false;
+    }
+    return ApplyClusterTopology(pClusterTopology);
+}
+
+bool CFlyRedisClient::ApplyClusterTopology(const std::shared_ptr<const FlyRedisClusterTopology>& pClusterTopology)
+{
+    const FlyRedisClusterTopology& stClusterTopology = *pClusterTopology;
+    int nTopologyNodeCount = static_cast<int>(stClusterTopology.vecRedisAddress.size());
+    std::vector<CFlyRedisSession*> vecRedisSession(nTopologyNodeCount, nullptr);
+    std::vector<int> vecNewNodeIndex;
+    std::vector<std::string> vecNewRedisAddress;
+    std::vector<bool> vecNewReadOnlyFlag;
+    bool bResult = true;
+    m_nRedisNodeCount = 0;
+    for (int nIndex = 0; nIndex < nTopologyNodeCount; ++nIndex)
+    {
+        const std::string& strRedisAddress = stClusterTopology.vecRedisAddress[nIndex];
+        bool bIsMaster = stClusterTopology.vecMasterFlag[nIndex];
+        // If read and write on master only, there is no session for slave
+        if (!bIsMaster && FlyRedisReadWriteType::ReadWriteOnMaster == m_nFlyRedisReadWriteType)
+        {
+            continue;
+        }
+        ++m_nRedisNodeCount;
+        // Existing session is kept
+        auto itFind = m_mapRedisSession.find(strRedisAddress);
+        if (itFind != m_mapRedisSession.end())
+        {
+            // A master may become slave after failover
+            if (!bIsMaster)
+            {
+                itFind->second->READONLY();
+            }
+            vecRedisSession[nIndex] = itFind->second;
+        }
+        else
+        {
+            vecNewNodeIndex.emplace_back(nIndex);
+            vecNewRedisAddress.emplace_back(strRedisAddress);
+            vecNewReadOnlyFlag.emplace_back(!bIsMaster);
+        }
+    }
+    // Every missing session is connected at the same time, READONLY of slave is sent by handshake
+    std::vector<CFlyRedisSession*> vecNewRedisSession;
+    ConnectRedisSessionList(m_boostIOContext, GetRedisSessionConfig(), vecNewRedisAddress, vecNewReadOnlyFlag, vecNewRedisSession);
+    for (size_t nNewIndex = 0; nNewIndex < vecNewRedisSession.size(); ++nNewIndex)
+    {
+        CFlyRedisSession* pRedisSession = vecNewRedisSession[nNewIndex];
+        int nIndex = vecNewNodeIndex[nNewIndex];
+        if (nullptr == pRedisSession)
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "CreateRedisSessionFailed %s", vecNewRedisAddress[nNewIndex].c_str());
+            bResult = false;
+            continue;
+        }
+        m_mapRedisSession.emplace(pRedisSession->GetRedisAddr(), pRedisSession);
+        AttachNodeStats(pRedisSession);
+        vecRedisSession[nIndex] = pRedisSession;
+    }
+    // Destroy the session which is not in topology
+    std::set<CFlyRedisSession*> setTopologySession(vecRedisSession.begin(), vecRedisSession.end());
+    std::vector<CFlyRedisSession*> vecObsoleteSession;
+    for (auto& kvp : m_mapRedisSession)
+    {
+        if (setTopologySession.find(kvp.second) == setTopologySession.end())
+        {
+            vecObsoleteSession.emplace_back(kvp.second);
+        }
+    }
+    for (CFlyRedisSession* pRedisSession : vecObsoleteSession)
+    {
+        DestroyRedisSession(pRedisSession);
+    }
+    for (int nSlot = 0; nSlot < FLY_REDIS_CLUSTER_SLOT_COUNT; ++nSlot)
+    {
+        RedisSlotOwner& stRedisSlotOwner = m_vecRedisSlotOwner[nSlot];
+        int nMasterIndex = stClusterTopology.vecSlotMaster[nSlot];
+        int nSlaveIndex = stClusterTopology.vecSlotSlave[nSlot];
+        stRedisSlotOwner.pMasterSession = (nMasterIndex >= 0) ? vecRedisSession[nMasterIndex] : nullptr;
+        stRedisSlotOwner.pSlaveSession = (nSlaveIndex >= 0) ? vecRedisSession[nSlaveIndex] : nullptr;
+    }
+    if (nullptr == m_pCurRedisSession && !m_mapRedisSession.empty())
+    {
+        m_pCurRedisSession = m_mapRedisSession.begin()->second;
+    }
+    m_pClusterTopology = pClusterTopology;
+    return bResult;
+}
+
+void CFlyRedisClient::ApplyNewClusterTopology()
+{
+    m_bHasNewClusterTopology.store(false);
+    std::shared_ptr<const FlyRedisClusterTopology> pClusterTopology = std::atomic_load(&m_pNewClusterTopology);
+    if (nullptr != pClusterTopology && pClusterTopology != m_pClusterTopology)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Notice, "ApplyNewClusterTopology, RedisNodeCount %d", static_cast<int>(pClusterTopology->vecRedisAddress.size()));
+        ApplyClusterTopology(pClusterTopology);
+    }
+}
+
+void CFlyRedisClient::StartClusterTopologyRefresh()
+{
+    if (m_nClusterTopologyRefreshMS <= 0 || m_hClusterTopologyRefreshThread.joinable())
+    {
+        return;
+    }
+    m_bStopClusterTopologyRefresh = false;
+    m_bClusterTopologyRefreshNow = false;
+    // Refresh thread only needs AUTH, it keeps RESP2 and has no client name
+    RedisSessionConfig stRedisSessionConfig = GetRedisSessionConfig();
+    stRedisSessionConfig.stHandshakeConfig = FlyRedisHandshakeConfig();
+    stRedisSessionConfig.stHandshakeConfig.strUserName = m_stHandshakeConfig.strUserName;
+    stRedisSessionConfig.stHandshakeConfig.strPassword = m_stHandshakeConfig.strPassword;
+    std::vector<std::string> vecRedisAddressSeed(m_setRedisAddressSeed.begin(), m_setRedisAddressSeed.end());
+    m_hClusterTopologyRefreshThread = std::thread(&CFlyRedisClient::RunClusterTopologyRefresh, this, stRedisSessionConfig, vecRedisAddressSeed, m_pClusterTopology);
+}
+
+void CFlyRedisClient::StopClusterTopologyRefresh()
+{
+    if (!m_hClusterTopologyRefreshThread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lockRefresh(m_mutexClusterTopologyRefresh);
+        m_bStopClusterTopologyRefresh = true;
+    }
+    m_cvClusterTopologyRefresh.notify_all();
+    m_hClusterTopologyRefreshThread.join();
+}
+
+void CFlyRedisClient::NotifyClusterTopologyRefresh()
+{
+    if (!m_hClusterTopologyRefreshThread.joinable())
+    {
+        return;
+    }
     {
-        return false;
+        std::lock_guard<std::mutex> lockRefresh(m_mutexClusterTopologyRefresh);
+        m_bClusterTopologyRefreshNow = true;
     }
-    bool bResult = true;
-    std::map<std::string, RedisClusterNodesLine> mapRedisClusterNodesLine;
-    for (const std::string& strNodeLine : vecClusterNodes)
+    m_cvClusterTopologyRefresh.notify_all();
+}
+
+void CFlyRedisClient::RunClusterTopologyRefresh(RedisSessionConfig stRedisSessionConfig, std::vector<std::string> vecRedisAddressSeed, std::shared_ptr<const FlyRedisClusterTopology> pClusterTopology)
+{
+    // Refresh thread has its own session, the session of client is never touched here
+    boost::asio::io_context boostIOContext;
+    CFlyRedisSession* pRedisSession = nullptr;
+    while (true)
     {
-        if (strNodeLine.empty())
-        {
-            continue;
-        }
-        RedisClusterNodesLine stRedisClusterNodesLine;
-        if (!stRedisClusterNodesLine.ParseNodeLine(strNodeLine))
-        {
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "NodeLineInvalid %s", strNodeLine.c_str());
-            bResult = false;
-            break;
-        }
-        if (!mapRedisClusterNodesLine.emplace(stRedisClusterNodesLine.strNodeId, stRedisClusterNodesLine).second)
         {
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedisNodeIdReduplicated %s", strNodeLine.c_str());
-            bResult = false;
-            break;
+            std::unique_lock<std::mutex> lockRefresh(m_mutexClusterTopologyRefresh);
+            m_cvClusterTopologyRefresh.wait_for(lockRefresh, std::chrono::milliseconds(m_nClusterTopologyRefreshMS), [this]() { return m_bStopClusterTopologyRefresh || m_bClusterTopologyRefreshNow; });
+            if (m_bStopClusterTopologyRefresh)
+            {
+                break;
+            }
+            m_bClusterTopologyRefreshNow = false;
         }
-    }
-    if (!bResult)
-    {
-        return false;
-    }
-    m_nRedisNodeCount = static_cast<int>(mapRedisClusterNodesLine.size());
-    for (auto& kvp : mapRedisClusterNodesLine)
-    {
-        RedisClusterNodesLine& refRedisNode = kvp.second;
-        // Refresh min max slot first
-        if (!refRedisNode.bIsMaster)
+        std::shared_ptr<FlyRedisClusterTopology> pNewClusterTopology = std::make_shared<FlyRedisClusterTopology>();
+        bool bFetchResult = (nullptr != pRedisSession && pRedisSession->FetchClusterTopology(*pNewClusterTopology));
+        if (!bFetchResult)
         {
-            // If read and write on master only, we should destroy redis session
-            if (FlyRedisReadWriteType::ReadWriteOnMaster == m_nFlyRedisReadWriteType)
+            // Reconnect to master of last topology, or the seed address
+            delete pRedisSession;
+            pRedisSession = nullptr;
+            std::vector<std::string> vecRedisAddress;
+            if (nullptr != pClusterTopology)
             {
-                DestroyRedisSession(refRedisNode.strNodeIPPort);
-                continue;
+                for (size_t nIndex = 0; nIndex < pClusterTopology->vecRedisAddress.size(); ++nIndex)
+                {
+                    if (pClusterTopology->vecMasterFlag[nIndex])
+                    {
+                        vecRedisAddress.emplace_back(pClusterTopology->vecRedisAddress[nIndex]);
+                    }
+                }
             }
-            auto itFindMaster = mapRedisClusterNodesLine.find(refRedisNode.strMasterNodeId);
-            if (itFindMaster == mapRedisClusterNodesLine.end())
+            vecRedisAddress.insert(vecRedisAddress.end(), vecRedisAddressSeed.begin(), vecRedisAddressSeed.end());
+            for (const std::string& strRedisAddress : vecRedisAddress)
             {
-                CFlyRedis::Logger(FlyRedisLogLevel::Error, "SlaveHasNoMaster %s", kvp.first.c_str());
-                bResult = false;
-                break;
+                pRedisSession = ConnectRedisSession(boostIOContext, stRedisSessionConfig, strRedisAddress);
+                if (nullptr == pRedisSession)
+                {
+                    continue;
+                }
+                bFetchResult = pRedisSession->FetchClusterTopology(*pNewClusterTopology);
+                if (bFetchResult)
+                {
+                    break;
+                }
+                delete pRedisSession;
+                pRedisSession = nullptr;
             }
-            const RedisClusterNodesLine& refMasterNode = itFindMaster->second;
-            refRedisNode.nMinSlot = refMasterNode.nMinSlot;
-            refRedisNode.nMaxSlot = refMasterNode.nMaxSlot;
         }
-        if (!ConnectToOneClusterNode(refRedisNode))
+        if (!bFetchResult)
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RefreshClusterTopologyFailed");
+            continue;
+        }
+        if (nullptr != pClusterTopology && *pClusterTopology == *pNewClusterTopology)
         {
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "ConnectToClusterNodesLineFailed %s-%s", kvp.first.c_str(), refRedisNode.strNodeIPPort.c_str());
-            bResult = false;
             continue;
         }
+        pClusterTopology = pNewClusterTopology;
+        std::atomic_store(&m_pNewClusterTopology, pClusterTopology);
+        m_bHasNewClusterTopology.store(true);
     }
-    return bResult;
+    delete pRedisSession;
 }
 
-bool CFlyRedisClient::ConnectToOneClusterNode(const RedisClusterNodesLine& stRedisNode)
+CFlyRedisClient::RedisSessionConfig CFlyRedisClient::GetRedisSessionConfig() const
 {
-    CFlyRedisSession* pRedisSession = CreateRedisSession(stRedisNode.strNodeIPPort);
-    if (nullptr == pRedisSession)
+    RedisSessionConfig stRedisSessionConfig;
+    stRedisSessionConfig.stHandshakeConfig = m_stHandshakeConfig;
+    stRedisSessionConfig.nReadTimeoutMS = m_nReadTimeoutMS;
+#ifdef FLY_REDIS_ENABLE_TLS
+    stRedisSessionConfig.bUseTLSFlag = m_bUseTLSFlag;
+#endif // FLY_REDIS_ENABLE_TLS
+    return stRedisSessionConfig;
+}
+
+CFlyRedisSession* CFlyRedisClient::ConnectRedisSession(boost::asio::io_context& boostIOContext, const RedisSessionConfig& stRedisSessionConfig, const std::string& strRedisAddress)
+{
+    std::vector<CFlyRedisSession*> vecRedisSession;
+    ConnectRedisSessionList(boostIOContext, stRedisSessionConfig, std::vector<std::string>(1, strRedisAddress), std::vector<bool>(1, false), vecRedisSession);
+    return vecRedisSession.front();
+}
+
+void CFlyRedisClient::ConnectRedisSessionList(boost::asio::io_context& boostIOContext, const RedisSessionConfig& stRedisSessionConfig, const std::vector<std::string>& vecRedisAddress, const std::vector<bool>& vecReadOnlyFlag, std::vector<CFlyRedisSession*>& vecRedisSession)
+{
+    const FlyRedisHandshakeConfig& stHandshakeConfig = stRedisSessionConfig.stHandshakeConfig;
+    vecRedisSession.clear();
+    for (const std::string& strRedisAddress : vecRedisAddress)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "CreateRedisSessionFailed %s", stRedisNode.strNodeIPPort.c_str());
+#ifdef FLY_REDIS_ENABLE_TLS
+        CFlyRedisSession* pRedisSession = new CFlyRedisSession(boostIOContext, stRedisSessionConfig.bUseTLSFlag, m_boostTLSContext);
+#else
+        CFlyRedisSession* pRedisSession = new CFlyRedisSession(boostIOContext);
+#endif // FLY_REDIS_ENABLE_TLS
+        pRedisSession->SetRedisAddress(strRedisAddress);
+        pRedisSession->SetReadTimeoutMS(stRedisSessionConfig.nReadTimeoutMS);
+        pRedisSession->StartAsyncConnect();
+        vecRedisSession.emplace_back(pRedisSession);
+    }
+    // Run io context until every session is connected or failed, so the cost is the slowest one
+    auto fnIsConnecting = [&vecRedisSession]() {
+        for (CFlyRedisSession* pRedisSession : vecRedisSession)
+        {
+            if (pRedisSession->IsConnecting())
+            {
+                return true;
+            }
+        }
         return false;
+    };
+    boostIOContext.restart();
+    while (fnIsConnecting() && boostIOContext.run_one() > 0)
+    {
+    }
+    // Send handshake to every connected session before any response is received
+    for (size_t nIndex = 0; nIndex < vecRedisSession.size(); ++nIndex)
+    {
+        CFlyRedisSession*& pRedisSession = vecRedisSession[nIndex];
+        if (!pRedisSession->IsConnected() || !pRedisSession->SendHandshake(stHandshakeConfig, vecReadOnlyFlag[nIndex]))
+        {
+            delete pRedisSession;
+            pRedisSession = nullptr;
+        }
     }
-    pRedisSession->SetSelfSlotRange(stRedisNode.nMinSlot, stRedisNode.nMaxSlot);
-    pRedisSession->SetMasterNodeFlag(stRedisNode.bIsMaster);
-    if (!stRedisNode.bIsMaster && FlyRedisReadWriteType::ReadOnSlaveWriteOnMaster == m_nFlyRedisReadWriteType)
+    for (size_t nIndex = 0; nIndex < vecRedisSession.size(); ++nIndex)
     {
-        pRedisSession->READONLY();
+        CFlyRedisSession*& pRedisSession = vecRedisSession[nIndex];
+        if (nullptr != pRedisSession && !pRedisSession->RecvHandshake(stHandshakeConfig, vecReadOnlyFlag[nIndex]))
+        {
+            delete pRedisSession;
+            pRedisSession = nullptr;
+        }
     }
-    return true;
 }
 
 CFlyRedisSession* CFlyRedisClient::CreateRedisSession(const std::string& strRedisAddress)
@@ -3199,32 +6089,13 @@ CFlyRedisSession* CFlyRedisClient::CreateRedisSession(const std::string& strRedi
         m_pCurRedisSession = itFind->second;
         return m_pCurRedisSession;
     }
-#ifdef FLY_REDIS_ENABLE_TLS
-    CFlyRedisSession* pRedisSession = new CFlyRedisSession(m_boostIOContext, m_bUseTLSFlag, m_boostTLSContext);
-#else
-    CFlyRedisSession* pRedisSession = new CFlyRedisSession(m_boostIOContext);
-#endif // FLY_REDIS_ENABLE_TLS
-    pRedisSession->SetRedisAddress(strRedisAddress);
-    pRedisSession->SetReadTimeoutSeconds(m_nReadTimeoutSeconds);
-    if (!pRedisSession->Connect())
-    {
-        delete pRedisSession;
-        pRedisSession = nullptr;
-        return nullptr;
-    }
-    if (!m_strRedisPasswod.empty() && !pRedisSession->AUTH(m_strRedisPasswod))
-    {
-        delete pRedisSession;
-        pRedisSession = nullptr;
-        return nullptr;
-    }
-    if (!pRedisSession->ResolveServerVersion())
+    CFlyRedisSession* pRedisSession = ConnectRedisSession(m_boostIOContext, GetRedisSessionConfig(), strRedisAddress);
+    if (nullptr == pRedisSession)
     {
-        delete pRedisSession;
-        pRedisSession = nullptr;
         return nullptr;
     }
     m_mapRedisSession.emplace(strRedisAddress, pRedisSession);
+    AttachNodeStats(pRedisSession);
     m_pCurRedisSession = pRedisSession;
     return pRedisSession;
 }
@@ -3237,6 +6108,17 @@ void CFlyRedisClient::DestroyRedisSession(CFlyRedisSession* pRedisSession)
     }
     if (nullptr != pRedisSession)
     {
+        for (RedisSlotOwner& stRedisSlotOwner : m_vecRedisSlotOwner)
+        {
+            if (stRedisSlotOwner.pMasterSession == pRedisSession)
+            {
+                stRedisSlotOwner.pMasterSession = nullptr;
+            }
+            if (stRedisSlotOwner.pSlaveSession == pRedisSession)
+            {
+                stRedisSlotOwner.pSlaveSession = nullptr;
+            }
+        }
         CFlyRedis::Logger(FlyRedisLogLevel::Debug, "DestroyRedisSession %s", pRedisSession->GetRedisAddr().c_str());
         m_mapRedisSession.erase(pRedisSession->GetRedisAddr());
         delete pRedisSession;
@@ -3253,12 +6135,75 @@ void CFlyRedisClient::DestroyRedisSession(const std::string& strIPPort)
     }
 }
 
+void CFlyRedisClient::AttachNodeStats(CFlyRedisSession* pRedisSession)
+{
+    auto itFind = m_mapNodeStats.find(pRedisSession->GetRedisAddr());
+    if (itFind == m_mapNodeStats.end())
+    {
+        itFind = m_mapNodeStats.emplace(pRedisSession->GetRedisAddr(), FlyRedisNodeStats()).first;
+    }
+    else
+    {
+        ++itFind->second.nReconnectCount;
+    }
+    ++itFind->second.nConnectCount;
+    pRedisSession->SetNodeStats(&itFind->second);
+}
+
+void CFlyRedisClient::RecordCmdStats(const char* pszCmdName, bool bResult, const std::chrono::steady_clock::time_point& tpBegin)
+{
+    // Cmd name is assigned into the reused string, so the lookup does not allocate
+    m_strStatsCmdName.assign(pszCmdName);
+    auto itFind = m_mapCmdStats.find(m_strStatsCmdName);
+    if (itFind == m_mapCmdStats.end())
+    {
+        itFind = m_mapCmdStats.emplace(m_strStatsCmdName, FlyRedisCmdStats()).first;
+    }
+    FlyRedisCmdStats& stCmdStats = itFind->second;
+    ++stCmdStats.nCmdCount;
+    if (!bResult)
+    {
+        ++stCmdStats.nFailedCount;
+    }
+    stCmdStats.hLatency.RecordSince(tpBegin);
+}
+
+void CFlyRedisClient::GetStatsSnapshot(FlyRedisStatsSnapshot& stStatsSnapshot) const
+{
+    stStatsSnapshot.mapNodeStats = m_mapNodeStats;
+    stStatsSnapshot.mapCmdStats = m_mapCmdStats;
+    // Pool session is connected by the pool, it is not attached to this client
+    if (nullptr != m_pRedisSessionPool)
+    {
+        m_pRedisSessionPool->FetchNodeConnectStats(stStatsSnapshot.mapNodeStats);
+    }
+}
+
+void CFlyRedisClient::ResetStats()
+{
+    for (auto& kvp : m_mapNodeStats)
+    {
+        kvp.second = FlyRedisNodeStats();
+    }
+    m_mapCmdStats.clear();
+}
+
 void CFlyRedisClient::PingEveryRedisNode(std::vector<CFlyRedisSession*>& vecDeadRedisSession)
 {
     for (auto& kvp : m_mapRedisSession)
     {
         CFlyRedisSession* pRedisSession = kvp.second;
-        if (nullptr != pRedisSession && !pRedisSession->PING())
+        if (nullptr == pRedisSession)
+        {
+            continue;
+        }
+        // Broken session may have unread reply, PING on it could read a stale reply, so it is reconnected without PING
+        if (pRedisSession->IsBroken())
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisNode %s SessionBroken", pRedisSession->GetRedisAddr().c_str());
+            vecDeadRedisSession.emplace_back(pRedisSession);
+        }
+        else if (!pRedisSession->PING())
         {
             CFlyRedis::Logger(FlyRedisLogLevel::Warning, "RedisNode %s PingFailed", pRedisSession->GetRedisAddr().c_str());
             vecDeadRedisSession.emplace_back(pRedisSession);
@@ -3266,8 +6211,66 @@ void CFlyRedisClient::PingEveryRedisNode(std::vector<CFlyRedisSession*>& vecDead
     }
 }
 
-bool CFlyRedisClient::DeliverRedisCmd(const std::string& strKey, bool bIsWrite, bool bRunRecvCmd, const char* pszCaller)
+CFlyRedisSession* CFlyRedisClient::LeasePoolRedisSession(const std::string& strRedisAddress)
+{
+    for (CFlyRedisSession* pRedisSession : m_vecPoolRedisSession)
+    {
+        if (pRedisSession->GetRedisAddr() == strRedisAddress)
+        {
+            return pRedisSession;
+        }
+    }
+    CFlyRedisSession* pRedisSession = m_pRedisSessionPool->LeaseRedisSession(strRedisAddress);
+    if (nullptr != pRedisSession)
+    {
+        // Leased session is used by this client only until it is returned, so it records into stats of this client
+        pRedisSession->SetNodeStats(&m_mapNodeStats[strRedisAddress]);
+        m_vecPoolRedisSession.emplace_back(pRedisSession);
+    }
+    return pRedisSession;
+}
+
+void CFlyRedisClient::ReturnPoolRedisSession()
+{
+    if (nullptr == m_pRedisSessionPool)
+    {
+        return;
+    }
+    for (CFlyRedisSession* pRedisSession : m_vecPoolRedisSession)
+    {
+        pRedisSession->SetNodeStats(nullptr);
+        m_pRedisSessionPool->ReturnRedisSession(pRedisSession);
+    }
+    m_vecPoolRedisSession.clear();
+    m_pCurRedisSession = nullptr;
+}
+
+void CFlyRedisClient::FetchEveryRedisSession(std::vector<CFlyRedisSession*>& vecRedisSession)
+{
+    if (nullptr == m_pRedisSessionPool)
+    {
+        vecRedisSession.reserve(m_mapRedisSession.size());
+        for (auto& kvp : m_mapRedisSession)
+        {
+            vecRedisSession.emplace_back(kvp.second);
+        }
+        return;
+    }
+    std::vector<std::string> vecRedisNodeList;
+    m_pRedisSessionPool->FetchRedisNodeList(vecRedisNodeList);
+    for (auto& strRedisAddress : vecRedisNodeList)
+    {
+        vecRedisSession.emplace_back(LeasePoolRedisSession(strRedisAddress));
+    }
+}
+
+bool CFlyRedisClient::DeliverRedisCmd(const std::string& strKey, bool bIsWrite, bool bRunRecvCmd, const char* pszCaller, CFlyRedisReplyBuilder* pReplyBuilder)
 {
+    std::chrono::steady_clock::time_point tpBegin = std::chrono::steady_clock::now();
+    if (m_bHasNewClusterTopology.load())
+    {
+        ApplyNewClusterTopology();
+    }
     if (m_bHasBadRedisSession)
     {
         VerifyRedisSessionList();
@@ -3275,30 +6278,176 @@ bool CFlyRedisClient::DeliverRedisCmd(const std::string& strKey, bool bIsWrite,
     if (!ResolveRedisSession(strKey, bIsWrite))
     {
         m_bHasBadRedisSession = true;
+        RecordCmdStats(pszCaller, false, tpBegin);
         return false;
     }
     if (nullptr == m_pCurRedisSession)
     {
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "CurRedisSessionIsNull %s", pszCaller);
         m_bHasBadRedisSession = true;
+        RecordCmdStats(pszCaller, false, tpBegin);
         return false;
     }
-    // Only write log for write cmd
-    CFlyRedis::BuildRedisCmdRequest(m_pCurRedisSession->GetRedisAddr(), m_vecRedisCmdParamList, m_strRedisCmdRequest, bIsWrite);
+    // Cmd which is encoded by EncodeRedisCmd has no param list, its request is ready. Only write log for write cmd
+    if (!m_vecRedisCmdParamList.empty())
+    {
+        CFlyRedis::BuildRedisCmdRequest(m_pCurRedisSession->GetRedisAddr(), m_vecRedisCmdParamList, m_strRedisCmdRequest, bIsWrite);
+    }
+    else if (bIsWrite)
+    {
+        CFlyRedis::LogRedisCmdRequest(m_pCurRedisSession->GetRedisAddr(), m_strRedisCmdRequest, &m_vecRedisCmdGatherParam);
+    }
     if (!bRunRecvCmd)
     {
-        m_pCurRedisSession->TrySendRedisRequest(m_strRedisCmdRequest);
+        m_pCurRedisSession->TrySendRedisRequest(m_strRedisCmdRequest, &m_vecRedisCmdGatherParam);
+        RecordCmdStats(pszCaller, true, tpBegin);
         return true;
     }
-    if (!m_pCurRedisSession->ProcRedisRequest(m_strRedisCmdRequest))
+    if (!ProcRedisRequest(m_pCurRedisSession, m_strRedisCmdRequest, pReplyBuilder, &m_vecRedisCmdGatherParam))
     {
+        // Slot has been moved to other redis node, follow it without refreshing every redis node
+        bool bResponseError = (nullptr != pReplyBuilder) ? pReplyBuilder->HasResponseError() : m_pCurRedisSession->HasResponseError();
+        const std::string& strResponseErrorMsg = (nullptr != pReplyBuilder) ? pReplyBuilder->GetLastResponseErrorMsg() : m_pCurRedisSession->GetLastResponseErrorMsg();
+        if (m_bClusterFlag && bResponseError && RedirectRedisCmd(strResponseErrorMsg, m_strRedisCmdRequest, pReplyBuilder, &m_vecRedisCmdGatherParam))
+        {
+            RecordCmdStats(pszCaller, true, tpBegin);
+            return true;
+        }
         CFlyRedis::Logger(FlyRedisLogLevel::Error, "ProcRedisRequestFailed %s", pszCaller);
         m_bHasBadRedisSession = true;
+        RecordCmdStats(pszCaller, false, tpBegin);
         return false;
     }
+    RecordCmdStats(pszCaller, true, tpBegin);
     return true;
 }
 
+bool CFlyRedisClient::ParseRedirectResponse(const std::string& strResponse, bool& bIsAsk, int& nSlot, std::string& strRedisAddress) const
+{
+    std::vector<std::string> vecField = CFlyRedis::SplitString(strResponse, ' ');
+    if (vecField.size() != 3)
+    {
+        return false;
+    }
+    if (0 == vecField[0].compare("MOVED"))
+    {
+        bIsAsk = false;
+    }
+    else if (0 == vecField[0].compare("ASK"))
+    {
+        bIsAsk = true;
+    }
+    else
+    {
+        return false;
+    }
+    nSlot = atoi(vecField[1].c_str());
+    strRedisAddress = vecField[2];
+    return nSlot >= 0 && nSlot < FLY_REDIS_CLUSTER_SLOT_COUNT && !strRedisAddress.empty();
+}
+
+bool CFlyRedisClient::RedirectRedisCmd(const std::string& strRedirectResponse, const std::string& strRedisCmdRequest, CFlyRedisReplyBuilder* pReplyBuilder, const std::vector<FlyRedisGatherParam>* pVecGatherParam)
+{
+    std::string strResponse = strRedirectResponse;
+    // Limit the redirect count, slot maybe moved again while the request is being redirected
+    for (int nRedirectCount = 0; nRedirectCount < 5; ++nRedirectCount)
+    {
+        bool bIsAsk = false;
+        int nSlot = 0;
+        std::string strRedisAddress;
+        if (!ParseRedirectResponse(strResponse, bIsAsk, nSlot, strRedisAddress))
+        {
+            return false;
+        }
+        CFlyRedisSession* pRedisSession = nullptr;
+        auto itFind = m_mapRedisSession.find(strRedisAddress);
+        if (nullptr != m_pRedisSessionPool)
+        {
+            pRedisSession = LeasePoolRedisSession(strRedisAddress);
+            if (nullptr == pRedisSession)
+            {
+                m_pCurRedisSession = nullptr;
+                return false;
+            }
+        }
+        else if (itFind != m_mapRedisSession.end())
+        {
+            pRedisSession = itFind->second;
+        }
+        else
+        {
+            pRedisSession = CreateRedisSession(strRedisAddress);
+            if (nullptr == pRedisSession)
+            {
+                CFlyRedis::Logger(FlyRedisLogLevel::Error, "CreateRedisSessionFailed %s", strRedisAddress.c_str());
+                m_pCurRedisSession = nullptr;
+                return false;
+            }
+            ++m_nRedisNodeCount;
+        }
+        // Broken session may have unread reply, it is not used until it is reconnected
+        if (pRedisSession->IsBroken())
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "RedirectToBrokenSession %s", strRedisAddress.c_str());
+            m_bHasBadRedisSession = true;
+            m_pCurRedisSession = nullptr;
+            return false;
+        }
+        m_pCurRedisSession = pRedisSession;
+        if (bIsAsk)
+        {
+            // Slot is being migrated, only this request is sent to the importing node
+            if (!pRedisSession->ASKING())
+            {
+                return false;
+            }
+        }
+        else
+        {
+            CFlyRedis::Logger(FlyRedisLogLevel::Notice, "RedisSlotMoved %d %s", nSlot, strRedisAddress.c_str());
+            if (nullptr != m_pRedisSessionPool)
+            {
+                m_pRedisSessionPool->MoveRedisSlot(nSlot, strRedisAddress);
+            }
+            else
+            {
+                RedisSlotOwner& stRedisSlotOwner = m_vecRedisSlotOwner[nSlot];
+                stRedisSlotOwner.pMasterSession = pRedisSession;
+                stRedisSlotOwner.pSlaveSession = nullptr;
+                NotifyClusterTopologyRefresh();
+            }
+        }
+        if (ProcRedisRequest(pRedisSession, strRedisCmdRequest, pReplyBuilder, pVecGatherParam))
+        {
+            return true;
+        }
+        if (nullptr != pReplyBuilder)
+        {
+            if (!pReplyBuilder->HasResponseError())
+            {
+                return false;
+            }
+            strResponse = pReplyBuilder->GetLastResponseErrorMsg();
+            continue;
+        }
+        if (!pRedisSession->HasResponseError())
+        {
+            return false;
+        }
+        strResponse = pRedisSession->GetLastResponseErrorMsg();
+    }
+    return false;
+}
+
+bool CFlyRedisClient::ProcRedisRequest(CFlyRedisSession* pRedisSession, const std::string& strRedisCmdRequest, CFlyRedisReplyBuilder* pReplyBuilder, const std::vector<FlyRedisGatherParam>* pVecGatherParam)
+{
+    if (nullptr != pReplyBuilder)
+    {
+        return pRedisSession->ProcRedisRequest(strRedisCmdRequest, *pReplyBuilder, pVecGatherParam);
+    }
+    return pRedisSession->ProcRedisRequest(strRedisCmdRequest, pVecGatherParam);
+}
+
 bool CFlyRedisClient::RunRedisCmdOnOneLineResponseInt(const std::string& strKey, bool bIsWrite, int& nResult, const char* pszCaller)
 {
     std::string strResult;
@@ -3306,7 +6455,13 @@ bool CFlyRedisClient::RunRedisCmdOnOneLineResponseInt(const std::string& strKey,
     {
         return false;
     }
-    nResult = atoi(strResult.c_str());
+    long long nValue = 0;
+    if (!CFlyRedisNumberCodec::DecodeInt(strResult.data(), strResult.data() + strResult.length(), nValue))
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ResponseIsNotInt %s, %s", pszCaller, strResult.c_str());
+        return false;
+    }
+    nResult = static_cast<int>(nValue);
     return true;
 }
 
@@ -3317,12 +6472,14 @@ bool CFlyRedisClient::RunRedisCmdOnOneLineResponseDouble(const std::string& strK
     {
         return false;
     }
-    fResult = atof(strResult.c_str());
+    fResult = 0.0;
+    CFlyRedisNumberCodec::DecodeDouble(strResult.data(), strResult.data() + strResult.length(), fResult);
     return true;
 }
 
 bool CFlyRedisClient::RunRedisCmdOnOneLineResponseString(const std::string& strKey, bool bIsWrite, std::string& strResult, const char* pszCaller)
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
     if (!DeliverRedisCmd(strKey, bIsWrite, true, pszCaller))
     {
         return false;
@@ -3337,6 +6494,7 @@ bool CFlyRedisClient::RunRedisCmdOnOneLineResponseString(const std::string& strK
 
 bool CFlyRedisClient::RunRedisCmdOnOneLineResponseVector(const std::string& strKey, bool bIsWrite, std::vector<std::string>& vecResult, const char* pszCaller)
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
     if (!DeliverRedisCmd(strKey, bIsWrite, true, pszCaller))
     {
         return false;
@@ -3351,12 +6509,22 @@ bool CFlyRedisClient::RunRedisCmdOnOneLineResponseVector(const std::string& strK
 
 bool CFlyRedisClient::RunRedisCmdOnOneLineResponseSet(const std::string& strKey, bool bIsWrite, std::set<std::string>& setResult, const char* pszCaller)
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
     if (!DeliverRedisCmd(strKey, bIsWrite, true, pszCaller))
     {
         return false;
     }
     if (nullptr != m_pCurRedisSession)
     {
+        // RESP2 has no set type, the set is sent as array
+        if (2 == m_pCurRedisSession->GetRESPVersion())
+        {
+            for (auto& strValue : m_pCurRedisSession->GetRedisResponseVector())
+            {
+                setResult.emplace(strValue);
+            }
+            return true;
+        }
         setResult.swap(m_pCurRedisSession->GetRedisResponseSet());
         return true;
     }
@@ -3365,6 +6533,7 @@ bool CFlyRedisClient::RunRedisCmdOnOneLineResponseSet(const std::string& strKey,
 
 bool CFlyRedisClient::RunRedisCmdOnResponseKVP(const std::string& strKey, bool bIsWrite, std::map<std::string, std::string>& mapResult, const char* pszCaller)
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
     if (!DeliverRedisCmd(strKey, bIsWrite, true, pszCaller))
     {
         return false;
@@ -3402,32 +6571,60 @@ bool CFlyRedisClient::RunRedisCmdOnResponseKVP(const std::string& strKey, bool b
     return bResult;
 }
 
-bool CFlyRedisClient::RunRedisCmdOnResponsePairList(const std::string& strKey, bool bIsWrite, std::vector< std::pair<std::string, std::string> >& vecResult, const char* pszCaller)
+bool CFlyRedisClient::RunRedisCmdOnElementVisitor(const std::string& strKey, bool bIsWrite, const FlyRedisElementVisitor& fnVisitor, const char* pszCaller, const FlyRedisElementCountVisitor& fnElementCountVisitor)
 {
-    if (!DeliverRedisCmd(strKey, bIsWrite, true, pszCaller))
-    {
-        return false;
-    }
-    const std::vector<std::string>& vecRedisResponse = m_pCurRedisSession->GetRedisResponseVector();
-    int nLineCount = (int)vecRedisResponse.size();
-    if (nLineCount % 2 != 0)
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
+    m_hReplyBuilder.Reset();
+    m_hReplyBuilder.SetReplyView(false);
+    m_hReplyBuilder.SetElementVisitor(fnVisitor, fnElementCountVisitor);
+    bool bResult = DeliverRedisCmd(strKey, bIsWrite, true, pszCaller, &m_hReplyBuilder);
+    m_hReplyBuilder.SetElementVisitor(nullptr);
+    return bResult;
+}
+
+bool CFlyRedisClient::RunRedisCmdOnKVPVisitor(const std::string& strKey, bool bIsWrite, const FlyRedisKVPVisitor& fnVisitor, const char* pszCaller)
+{
+    // RESP3 replies a map, RESP2 replies an array of field and value, both are visited as field and value in turn.
+    // Field is copied, recv buff may be moved before its value is parsed
+    bool bExpectValue = false;
+    std::string strField;
+    bool bResult = RunRedisCmdOnElementVisitor(strKey, bIsWrite, [&](const boost::string_view& strElement) {
+        if (!bExpectValue)
+        {
+            strField.assign(strElement.data(), strElement.size());
+        }
+        else
+        {
+            fnVisitor(strField, strElement);
+        }
+        bExpectValue = !bExpectValue;
+    }, pszCaller);
+    if (bResult && bExpectValue)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ResponseLineCountIsNotEven %d", nLineCount);
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "ResponseLineCountIsNotEven %s", pszCaller);
         return false;
     }
-    int nKeyIndex = 0;
-    int nValueIndex = 1;
-    for (; nKeyIndex < nLineCount && nValueIndex < nLineCount; nKeyIndex += 2, nValueIndex += 2)
-    {
-        const std::string& strField = vecRedisResponse[nKeyIndex];
-        const std::string& strValue = vecRedisResponse[nValueIndex];
-        vecResult.emplace_back(strField, strValue);
+    return bResult;
+}
+
+bool CFlyRedisClient::RunRedisCmdOnElementDecoder(const std::string& strKey, bool bIsWrite, CFlyRedisElementDecoder& hElementDecoder, const char* pszCaller)
+{
+    bool bResult = RunRedisCmdOnElementVisitor(strKey, bIsWrite, [&hElementDecoder](const boost::string_view& strElement) {
+        hElementDecoder.OnElement(strElement);
+    }, pszCaller, [&hElementDecoder](int nElementCount) {
+        hElementDecoder.OnElementCount(nElementCount);
+    });
+    if (bResult && !hElementDecoder.IsDecodeSuccess())
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "DecodeReplyElementFailed %s", pszCaller);
+        return false;
     }
-    return true;
+    return bResult;
 }
 
 bool CFlyRedisClient::RunRedisCmdOnScanCmd(const std::string& strKey, int& nResultCursor, std::vector<std::string>& vecResult, const char* pszCaller)
 {
+    PoolRedisSessionGuard hPoolRedisSessionGuard(*this);
     if (!DeliverRedisCmd(strKey, false, true, pszCaller))
     {
         return false;
@@ -3441,7 +6638,10 @@ bool CFlyRedisClient::RunRedisCmdOnScanCmd(const std::string& strKey, int& nResu
     {
         return false;
     }
-    nResultCursor = atoi(vecRedisResponse.front().c_str());
+    const std::string& strCursor = vecRedisResponse.front();
+    unsigned long long nCursor = 0;
+    CFlyRedisNumberCodec::DecodeUInt(strCursor.data(), strCursor.data() + strCursor.length(), nCursor);
+    nResultCursor = static_cast<int>(nCursor);
     vecRedisResponse.erase(vecRedisResponse.begin());
     vecResult.swap(vecRedisResponse);
     return true;
@@ -3449,6 +6649,12 @@ bool CFlyRedisClient::RunRedisCmdOnScanCmd(const std::string& strKey, int& nResu
 
 bool CFlyRedisClient::RunRedisCmdOnSubscribeCmd(std::vector<FlyRedisSubscribeResponse>& vecResult, int nChannelCount, const char* pszCaller)
 {
+    // Subscribed session can not be shared
+    if (nullptr != m_pRedisSessionPool)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SubscribeIsNotSupportedByPool %s", pszCaller);
+        return false;
+    }
     if (!DeliverRedisCmd("", false, false, pszCaller))
     {
         return false;
@@ -3477,6 +6683,23 @@ void CFlyRedisClient::ClearRedisCmdCache()
 {
     m_vecRedisCmdParamList.clear();
     m_strRedisCmdRequest.clear();
+    m_vecRedisCmdGatherParam.clear();
+}
+
+bool CFlyRedisClient::BuildMGETCmd(const std::vector<std::string>& vecKey)
+{
+    if (vecKey.empty())
+    {
+        return false;
+    }
+    if (m_bClusterFlag && !CFlyRedis::IsMultiKeyOnTheSameNode(vecKey))
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "CROSSSLOT Keys in request don't hash to the same slot");
+        return false;
+    }
+    static const CFlyRedisCmdName hCmdName("MGET");
+    EncodeRedisCmd(hCmdName, vecKey);
+    return true;
 }
 
 bool CFlyRedisClient::BuildFlyRedisSubscribeResponse(const std::vector<std::string>& vecInput, std::vector<FlyRedisSubscribeResponse>& vecResult) const
@@ -3517,12 +6740,203 @@ bool CFlyRedisClient::BuildFlyRedisPMessageResponse(const std::vector<std::strin
 }
 // End of RedisClient
 //////////////////////////////////////////////////////////////////////////
+// Begin of AsyncLogger
+CFlyRedisAsyncLogger::CFlyRedisAsyncLogger(size_t nRecordCount)
+    :m_nPushPos(0),
+    m_bRunning(false)
+{
+    size_t nRoundCount = 2;
+    while (nRoundCount < nRecordCount)
+    {
+        nRoundCount <<= 1;
+    }
+    m_pRecord.reset(new LogRecord[nRoundCount]);
+    m_nRecordMask = nRoundCount - 1;
+    for (size_t nPos = 0; nPos < nRoundCount; ++nPos)
+    {
+        m_pRecord[nPos].nSeq.store(nPos, std::memory_order_relaxed);
+    }
+}
+
+CFlyRedisAsyncLogger::~CFlyRedisAsyncLogger()
+{
+    Stop();
+}
+
+void CFlyRedisAsyncLogger::Start()
+{
+    if (m_bRunning.exchange(true))
+    {
+        return;
+    }
+    m_hThread = std::thread(&CFlyRedisAsyncLogger::Run, this);
+}
+
+void CFlyRedisAsyncLogger::Stop()
+{
+    if (!m_bRunning.exchange(false))
+    {
+        return;
+    }
+    if (m_hThread.joinable())
+    {
+        m_hThread.join();
+    }
+}
+
+bool CFlyRedisAsyncLogger::Push(FlyRedisLogLevel nLevel, const char* pszMsgFormat, va_list vaList)
+{
+    size_t nPos = 0;
+    LogRecord* pRecord = ClaimRecord(nPos);
+    if (nullptr == pRecord)
+    {
+        return false;
+    }
+    pRecord->nLevel = nLevel;
+    pRecord->bRedisCmdRequest = false;
+#ifdef WIN32
+    _vsnprintf_s(pRecord->szContent, _TRUNCATE, pszMsgFormat, vaList);
+#else
+    vsnprintf(pRecord->szContent, sizeof(pRecord->szContent), pszMsgFormat, vaList);
+#endif
+    pRecord->nSeq.store(nPos + 1, std::memory_order_release);
+    return true;
+}
+
+bool CFlyRedisAsyncLogger::PushRedisCmdRequest(const std::string& strRedisAddress, const boost::string_view& strRedisCmdRequest)
+{
+    size_t nLen = strRedisAddress.length() + 1 + strRedisCmdRequest.size();
+    if (nLen > sizeof(LogRecord::szContent))
+    {
+        return false;
+    }
+    size_t nPos = 0;
+    LogRecord* pRecord = ClaimRecord(nPos);
+    if (nullptr == pRecord)
+    {
+        return false;
+    }
+    pRecord->nLevel = FlyRedisLogLevel::Command;
+    pRecord->bRedisCmdRequest = true;
+    pRecord->nLen = nLen;
+    memcpy(pRecord->szContent, strRedisAddress.c_str(), strRedisAddress.length() + 1);
+    memcpy(pRecord->szContent + strRedisAddress.length() + 1, strRedisCmdRequest.data(), strRedisCmdRequest.size());
+    pRecord->nSeq.store(nPos + 1, std::memory_order_release);
+    return true;
+}
+
+CFlyRedisAsyncLogger::LogRecord* CFlyRedisAsyncLogger::ClaimRecord(size_t& nPos)
+{
+    // Claim the record at push pos by CAS, the pos is taken by another producer if CAS failed
+    nPos = m_nPushPos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        LogRecord* pRecord = &m_pRecord[nPos & m_nRecordMask];
+        size_t nSeq = pRecord->nSeq.load(std::memory_order_acquire);
+        if (nSeq == nPos)
+        {
+            if (m_nPushPos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+            {
+                return pRecord;
+            }
+        }
+        else if (nSeq < nPos)
+        {
+            // The record of last round has not been popped, the ring is full, log written inline now would jump ahead of it
+            if (!m_bRunning.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            std::this_thread::yield();
+            nPos = m_nPushPos.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            nPos = m_nPushPos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void CFlyRedisAsyncLogger::Run()
+{
+    while (m_bRunning.load(std::memory_order_acquire))
+    {
+        if (!Pop())
+        {
+            // Producer does not signal the background thread, so it polls when the ring is empty
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // Record which is pushed before Stop is handled too, every writer has finished its record before Stop
+    while (Pop())
+    {
+    }
+}
+
+bool CFlyRedisAsyncLogger::Pop()
+{
+    LogRecord& stRecord = m_pRecord[m_nPopPos & m_nRecordMask];
+    if (stRecord.nSeq.load(std::memory_order_acquire) != m_nPopPos + 1)
+    {
+        return false;
+    }
+    if (stRecord.bRedisCmdRequest)
+    {
+        m_strRedisAddress.assign(stRecord.szContent);
+        size_t nRequestPos = m_strRedisAddress.length() + 1;
+        CFlyRedis::LogRedisCmdRequest(m_strRedisAddress, boost::string_view(stRecord.szContent + nRequestPos, stRecord.nLen - nRequestPos));
+    }
+    else
+    {
+        CFlyRedis::CallLoggerHandler(stRecord.nLevel, stRecord.szContent);
+    }
+    // Free the record for the next round
+    stRecord.nSeq.store(m_nPopPos + m_nRecordMask + 1, std::memory_order_release);
+    ++m_nPopPos;
+    return true;
+}
+
+// End of AsyncLogger
+//////////////////////////////////////////////////////////////////////////
 // Begin of FlyRedis
 std::function<void(const char*)> CFlyRedis::ms_pfnLoggerDebug = nullptr;
 std::function<void(const char*)> CFlyRedis::ms_pfnLoggerNotice = nullptr;
 std::function<void(const char*)> CFlyRedis::ms_pfnLoggerWarning = nullptr;
 std::function<void(const char*)> CFlyRedis::ms_pfnLoggerError = nullptr;
 std::function<void(const char*)> CFlyRedis::ms_pfnLoggerPersistence = nullptr;
+std::atomic<unsigned int> CFlyRedis::ms_nLoggerLevelMask(0);
+std::atomic<CFlyRedisAsyncLogger*> CFlyRedis::ms_pAsyncLogger(nullptr);
+std::atomic<int> CFlyRedis::ms_nAsyncLoggerWriterCount(0);
+
+// It is destroyed before logger handlers, so records are handled before exit
+static struct FlyRedisAsyncLoggerExitGuard
+{
+    ~FlyRedisAsyncLoggerExitGuard()
+    {
+        CFlyRedis::StopAsyncLogger();
+    }
+} s_stAsyncLoggerExitGuard;
+
+CFlyRedis::AsyncLoggerGuard::AsyncLoggerGuard()
+{
+    // Writer count is not touched if there is no async logger
+    if (nullptr == ms_pAsyncLogger.load())
+    {
+        return;
+    }
+    // Count is added before the logger is loaded again, so StopAsyncLogger either waits for it or it sees nullptr
+    ++ms_nAsyncLoggerWriterCount;
+    bHeld = true;
+    pAsyncLogger = ms_pAsyncLogger.load();
+}
+
+CFlyRedis::AsyncLoggerGuard::~AsyncLoggerGuard()
+{
+    if (bHeld)
+    {
+        --ms_nAsyncLoggerWriterCount;
+    }
+}
 
 void CFlyRedis::SetLoggerHandler(FlyRedisLogLevel nLogLevel, std::function<void(const char*)> pfnLoggerHandler)
 {
@@ -3544,49 +6958,101 @@ void CFlyRedis::SetLoggerHandler(FlyRedisLogLevel nLogLevel, std::function<void(
         ms_pfnLoggerPersistence = pfnLoggerHandler;
         break;
     default:
-        break;
+        return;
+    }
+    unsigned int nLevelBit = 1u << static_cast<int>(nLogLevel);
+    if (nullptr != pfnLoggerHandler)
+    {
+        ms_nLoggerLevelMask.fetch_or(nLevelBit);
+    }
+    else
+    {
+        ms_nLoggerLevelMask.fetch_and(~nLevelBit);
+    }
+}
+
+void CFlyRedis::StartAsyncLogger(size_t nRecordCount)
+{
+    StopAsyncLogger();
+    CFlyRedisAsyncLogger* pAsyncLogger = new CFlyRedisAsyncLogger(nRecordCount);
+    pAsyncLogger->Start();
+    ms_pAsyncLogger.store(pAsyncLogger);
+}
+
+void CFlyRedis::StopAsyncLogger()
+{
+    // New writer can not get it after it is taken, and the writer which holds it finishes its record first
+    CFlyRedisAsyncLogger* pAsyncLogger = ms_pAsyncLogger.exchange(nullptr);
+    if (nullptr == pAsyncLogger)
+    {
+        return;
+    }
+    while (ms_nAsyncLoggerWriterCount.load() > 0)
+    {
+        std::this_thread::yield();
     }
+    pAsyncLogger->Stop();
+    delete pAsyncLogger;
 }
 
-std::function<void(const char*)> CFlyRedis::GetLoggerHandler(FlyRedisLogLevel nLogLevel)
+const std::function<void(const char*)>& CFlyRedis::GetLoggerHandler(FlyRedisLogLevel nLogLevel)
 {
-    std::function<void(const char*)> pfnResult = nullptr;
+    static const std::function<void(const char*)> pfnNullLoggerHandler = nullptr;
     switch (nLogLevel)
     {
     case FlyRedisLogLevel::Debug:
-        pfnResult = ms_pfnLoggerDebug;
-        break;
+        return ms_pfnLoggerDebug;
     case FlyRedisLogLevel::Notice:
-        pfnResult = ms_pfnLoggerNotice;
-        break;
+        return ms_pfnLoggerNotice;
     case FlyRedisLogLevel::Warning:
-        pfnResult = ms_pfnLoggerWarning;
-        break;
+        return ms_pfnLoggerWarning;
     case FlyRedisLogLevel::Error:
-        pfnResult = ms_pfnLoggerError;
-        break;
+        return ms_pfnLoggerError;
     case FlyRedisLogLevel::Command:
-        pfnResult = ms_pfnLoggerPersistence;
-        break;
+        return ms_pfnLoggerPersistence;
     }
-    return pfnResult;
+    return pfnNullLoggerHandler;
 }
 
 void CFlyRedis::Logger(FlyRedisLogLevel nLevel, const char* pszMsgFormat, ...)
 {
-    auto pfnLoggerHandler = GetLoggerHandler(nLevel);
-    if (nullptr != pfnLoggerHandler)
+    // Nothing is formatted if there is no handler of this level
+    if (!IsLoggerEnabled(nLevel))
+    {
+        return;
+    }
+    va_list vaList;
     {
-        char buffLogContent[4096] = { 0 };
-        va_list vaList;
-        va_start(vaList, pszMsgFormat);
+        AsyncLoggerGuard stAsyncLoggerGuard;
+        if (nullptr != stAsyncLoggerGuard.pAsyncLogger && !stAsyncLoggerGuard.pAsyncLogger->IsBackgroundThread())
+        {
+            va_start(vaList, pszMsgFormat);
+            bool bPushed = stAsyncLoggerGuard.pAsyncLogger->Push(nLevel, pszMsgFormat, vaList);
+            va_end(vaList);
+            if (bPushed)
+            {
+                return;
+            }
+        }
+    }
+    char buffLogContent[4096];
+    va_start(vaList, pszMsgFormat);
+    // Log which is longer than the buff is truncated, such as write cmd with huge value
 #ifdef WIN32
-        vsprintf_s(buffLogContent, pszMsgFormat, vaList);
+    _vsnprintf_s(buffLogContent, _TRUNCATE, pszMsgFormat, vaList);
 #else
-        vsprintf(buffLogContent, pszMsgFormat, vaList);
+    vsnprintf(buffLogContent, sizeof(buffLogContent), pszMsgFormat, vaList);
 #endif
-        va_end(vaList);
-        pfnLoggerHandler(buffLogContent);
+    va_end(vaList);
+    CallLoggerHandler(nLevel, buffLogContent);
+}
+
+void CFlyRedis::CallLoggerHandler(FlyRedisLogLevel nLevel, const char* pszLogContent)
+{
+    const std::function<void(const char*)>& pfnLoggerHandler = GetLoggerHandler(nLevel);
+    if (nullptr != pfnLoggerHandler)
+    {
+        pfnLoggerHandler(pszLogContent);
     }
 }
 
@@ -3726,104 +7192,238 @@ std::vector<std::string> CFlyRedis::SplitString(const std::string& strInput, cha
     {
         return vecResult;
     }
-    std::string strToken;
-    for (char chValue : strInput)
+    // Every token is copied at once, the token after the last delim is kept even if it is empty
+    const char* pEnd = strInput.data() + strInput.length();
+    const char* pToken = strInput.data();
+    while (true)
     {
-        if (chValue != chDelim)
+        const char* pDelim = FindDelim(pToken, pEnd, chDelim);
+        vecResult.emplace_back(pToken, pDelim);
+        if (pDelim == pEnd)
         {
-            strToken.append(1, chValue);
+            break;
         }
-        else
+        pToken = pDelim + 1;
+    }
+    return vecResult;
+}
+
+#ifdef FLY_REDIS_SIMD_SSE2
+// Index of the lowest set bit, nMask should not be 0
+static inline int FlyRedisFirstSetBit(unsigned int nMask)
+{
+#ifdef _MSC_VER
+    unsigned long nIndex = 0;
+    _BitScanForward(&nIndex, nMask);
+    return static_cast<int>(nIndex);
+#else
+    return __builtin_ctz(nMask);
+#endif // _MSC_VER
+}
+#endif // FLY_REDIS_SIMD_SSE2
+
+const char* CFlyRedis::FindDelim(const char* pBegin, const char* pEnd, char chDelim)
+{
+    return FindDelim(pBegin, pEnd, chDelim, chDelim);
+}
+
+const char* CFlyRedis::FindDelim(const char* pBegin, const char* pEnd, char chDelim, char chOtherDelim)
+{
+    const char* pCur = pBegin;
+#ifdef FLY_REDIS_SIMD_AVX2
+    const __m256i hDelim256 = _mm256_set1_epi8(chDelim);
+    const __m256i hOtherDelim256 = _mm256_set1_epi8(chOtherDelim);
+    for (; pEnd - pCur >= 32; pCur += 32)
+    {
+        __m256i hBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pCur));
+        unsigned int nMask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(hBlock, hDelim256), _mm256_cmpeq_epi8(hBlock, hOtherDelim256))));
+        if (0 != nMask)
         {
-            vecResult.emplace_back(strToken);
-            strToken.clear();
+            return pCur + FlyRedisFirstSetBit(nMask);
         }
     }
-    if (!strToken.empty())
+#endif // FLY_REDIS_SIMD_AVX2
+#ifdef FLY_REDIS_SIMD_SSE2
+    const __m128i hDelim128 = _mm_set1_epi8(chDelim);
+    const __m128i hOtherDelim128 = _mm_set1_epi8(chOtherDelim);
+    for (; pEnd - pCur >= 16; pCur += 16)
     {
-        vecResult.emplace_back(strToken);
+        __m128i hBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCur));
+        unsigned int nMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(hBlock, hDelim128), _mm_cmpeq_epi8(hBlock, hOtherDelim128))));
+        if (0 != nMask)
+        {
+            return pCur + FlyRedisFirstSetBit(nMask);
+        }
     }
-    if (strInput.back() == chDelim)
+#endif // FLY_REDIS_SIMD_SSE2
+    // Tail which is shorter than one block, or the whole buff without SIMD
+    for (; pCur < pEnd; ++pCur)
     {
-        vecResult.emplace_back("");
+        if (chDelim == *pCur || chOtherDelim == *pCur)
+        {
+            return pCur;
+        }
+    }
+    return pEnd;
+}
+
+void CFlyRedis::ParseInfoResponse(const std::string& strInfoResponse, std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo)
+{
+    // Every line is "# Section" or "key:value", it ends with CRLF
+    const char* pEnd = strInfoResponse.data() + strInfoResponse.length();
+    const char* pLine = strInfoResponse.data();
+    std::map<std::string, std::string>* pCurSection = nullptr;
+    while (pLine < pEnd)
+    {
+        const char* pLineEnd = FindDelim(pLine, pEnd, '\n');
+        const char* pNextLine = (pLineEnd == pEnd) ? pEnd : pLineEnd + 1;
+        if (pLineEnd > pLine && '\r' == pLineEnd[-1])
+        {
+            --pLineEnd;
+        }
+        if (pLineEnd > pLine)
+        {
+            if ('#' == pLine[0])
+            {
+                pCurSection = &mapSectionInfo[std::string(pLine, pLineEnd)];
+            }
+            else
+            {
+                const char* pColon = FindDelim(pLine, pLineEnd, ':');
+                if (pColon != pLineEnd)
+                {
+                    // Field before any section, such as CLUSTER INFO, is kept in the empty section
+                    if (nullptr == pCurSection)
+                    {
+                        pCurSection = &mapSectionInfo[std::string()];
+                    }
+                    pCurSection->emplace(std::string(pLine, pColon), std::string(pColon + 1, pLineEnd));
+                }
+            }
+        }
+        pLine = pNextLine;
     }
-    return vecResult;
 }
 
 void CFlyRedis::BuildRedisCmdRequest(const std::string& strRedisAddress, const std::vector<std::string>& vecRedisCmdParamList, std::string& strRedisCmdRequest, bool bIsWriteCmd)
 {
-    std::string strCmdLog;
     strRedisCmdRequest.clear();
+    AppendRedisCmdRequest(strRedisAddress, vecRedisCmdParamList, strRedisCmdRequest, bIsWriteCmd);
+}
+
+void CFlyRedis::AppendRedisCmdRequest(const std::string& strRedisAddress, const std::vector<std::string>& vecRedisCmdParamList, std::string& strRedisCmdRequest, bool bIsWriteCmd)
+{
+    size_t nRequestPos = strRedisCmdRequest.length();
     strRedisCmdRequest.append("*").append(std::to_string((int)vecRedisCmdParamList.size())).append("\r\n");
     for (const std::string& strParam : vecRedisCmdParamList)
     {
         strRedisCmdRequest.append("$").append(std::to_string((int)strParam.length())).append("\r\n");
         strRedisCmdRequest.append(strParam).append("\r\n");
-        if (!bIsWriteCmd)
-        {
-            continue;
-        }
-        if (strCmdLog.length() < 4096)
+    }
+    if (bIsWriteCmd)
+    {
+        LogRedisCmdRequest(strRedisAddress, boost::string_view(strRedisCmdRequest.data() + nRequestPos, strRedisCmdRequest.length() - nRequestPos));
+    }
+}
+
+void CFlyRedis::LogRedisCmdRequest(const std::string& strRedisAddress, const boost::string_view& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam)
+{
+    if (!IsLoggerEnabled(FlyRedisLogLevel::Command))
+    {
+        return;
+    }
+    // Request is copied into async logger, it is converted into cmd log by the background thread.
+    // Otherwise cmd log is built here and pushed by Logger, so it is still in order
+    {
+        AsyncLoggerGuard stAsyncLoggerGuard;
+        if (nullptr != stAsyncLoggerGuard.pAsyncLogger && !stAsyncLoggerGuard.pAsyncLogger->IsBackgroundThread() && (nullptr == pVecGatherParam || pVecGatherParam->empty())
+            && stAsyncLoggerGuard.pAsyncLogger->PushRedisCmdRequest(strRedisAddress, strRedisCmdRequest))
         {
-            strCmdLog.append(strParam).append(" ");
+            return;
         }
-        else
+    }
+    // Request is "*N\r\n" and N params of "$Len\r\nParam\r\n", it is built by FlyRedis so it is well formed.
+    // Gather param is not in the request, it is inserted at its offset
+    std::string strCmdLog;
+    size_t nGatherIndex = 0;
+    const char* pEnd = strRedisCmdRequest.data() + strRedisCmdRequest.length();
+    const char* pCur = FindDelim(strRedisCmdRequest.data(), pEnd, '\n');
+    while (pCur < pEnd && pCur + 1 < pEnd && '$' == pCur[1])
+    {
+        const char* pLenEnd = FindDelim(pCur + 2, pEnd, '\r');
+        size_t nParamLen = strtoul(pCur + 2, nullptr, 10);
+        const char* pParam = pLenEnd + 2;
+        if (strCmdLog.length() >= 4096)
         {
             CFlyRedis::Logger(FlyRedisLogLevel::Command, "RedisCmd,%s,%s", strRedisAddress.c_str(), strCmdLog.c_str());
             strCmdLog.clear();
-            strCmdLog.append(strParam).append(" ");
         }
+        if (nullptr != pVecGatherParam && nGatherIndex < pVecGatherParam->size() && (*pVecGatherParam)[nGatherIndex].nOffset == static_cast<size_t>(pParam - strRedisCmdRequest.data()))
+        {
+            const boost::string_view& strParam = (*pVecGatherParam)[nGatherIndex++].strParam;
+            strCmdLog.append(strParam.data(), strParam.size()).append(" ");
+            pCur = pParam + 1;
+            continue;
+        }
+        if (pParam + nParamLen > pEnd)
+        {
+            break;
+        }
+        strCmdLog.append(pParam, nParamLen).append(" ");
+        pCur = pParam + nParamLen + 1;
     }
-    if (bIsWriteCmd && !strCmdLog.empty())
+    if (!strCmdLog.empty())
     {
         CFlyRedis::Logger(FlyRedisLogLevel::Command, "RedisCmd,%s,%s", strRedisAddress.c_str(), strCmdLog.c_str());
     }
 }
 
-// End of FlyRedis
-//////////////////////////////////////////////////////////////////////////
-// Define Struct RedisClusterNodesLine
-CFlyRedisClient::RedisClusterNodesLine::RedisClusterNodesLine()
-{
-
-}
-
-bool CFlyRedisClient::RedisClusterNodesLine::ParseNodeLine(const std::string& strNodeLine)
+#ifdef FLY_REDIS_ENABLE_TLS
+bool CFlyRedis::LoadTLSContext(boost::asio::ssl::context& boostTLSContext, const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert, const std::string& strTLSCACertDir)
 {
-    bIsMaster = (strNodeLine.find("master") != std::string::npos);
-    std::vector<std::string> vecNodeField = CFlyRedis::SplitString(strNodeLine, ' ');
-    if ((bIsMaster && vecNodeField.size() != 9) || (!bIsMaster && vecNodeField.size() != 8))
+    boost::system::error_code boostErrorCode;
+    boostTLSContext.set_options(boost::asio::ssl::context::no_sslv2 | boost::asio::ssl::context::no_sslv3, boostErrorCode);
+    if (boostErrorCode)
     {
-        CFlyRedis::Logger(FlyRedisLogLevel::Error, "NodeFieldInvalid %s", strNodeLine.c_str());
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL set_options failed: %s", boostErrorCode.message().c_str());
         return false;
     }
-    strNodeId = vecNodeField[0];
-    strNodeIPPort = vecNodeField[1];
-    size_t nPos = strNodeIPPort.find('@');
-    if (nPos != std::string::npos)
+    boostTLSContext.set_verify_mode(boost::asio::ssl::verify_peer, boostErrorCode);
+    if (boostErrorCode)
     {
-        strNodeIPPort.erase(nPos, strNodeIPPort.length());
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL set_verify_mode failed: %s", boostErrorCode.message().c_str());
+        return false;
     }
-    if (bIsMaster)
+    boostTLSContext.load_verify_file(strTLSCACert.c_str(), boostErrorCode);
+    if (boostErrorCode)
     {
-        const std::string& strSlotRange = vecNodeField[8];
-        std::vector<std::string> vecIntField = CFlyRedis::SplitString(strSlotRange, '-');
-        if (vecIntField.size() != 2)
-        {
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "InvalidFieldLen %s Slot %s", strNodeIPPort.c_str(), strSlotRange.c_str());
-            return false;
-        }
-        nMinSlot = atoi(vecIntField[0].c_str());
-        nMaxSlot = atoi(vecIntField[1].c_str());
-        if (nMinSlot > nMaxSlot)
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL load_verify_file failed: %s", boostErrorCode.message().c_str());
+        return false;
+    }
+    if (!strTLSCACertDir.empty())
+    {
+        boostTLSContext.add_verify_path(strTLSCACertDir.c_str(), boostErrorCode);
+        if (boostErrorCode)
         {
-            CFlyRedis::Logger(FlyRedisLogLevel::Error, "InvalidSlotValue %s Slot %s", strNodeIPPort.c_str(), strSlotRange.c_str());
+            CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL add_verify_path failed: %s", boostErrorCode.message().c_str());
             return false;
         }
     }
-    else
+    boostTLSContext.use_certificate_chain_file(strTLSCert.c_str(), boostErrorCode);
+    if (boostErrorCode)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL use_certificate_chain_file failed: %s", boostErrorCode.message().c_str());
+        return false;
+    }
+    boostTLSContext.use_private_key_file(strTLSKey.c_str(), boost::asio::ssl::context_base::file_format::pem, boostErrorCode);
+    if (boostErrorCode)
     {
-        strMasterNodeId = vecNodeField[3];
+        CFlyRedis::Logger(FlyRedisLogLevel::Error, "SSL use_private_key_file failed: %s", boostErrorCode.message().c_str());
+        return false;
     }
     return true;
 }
+#endif // FLY_REDIS_ENABLE_TLS
+
+// End of FlyRedis
+//////////////////////////////////////////////////////////////////////////
@@ -24,16 +24,51 @@
 #ifndef _FLYREDIS_H_
 #define _FLYREDIS_H_
 
+#ifdef FLY_REDIS_ENABLE_COROUTINE
+// awaitable.hpp of boost 1.74 uses std::exchange without including utility
+#include <utility>
+#endif // FLY_REDIS_ENABLE_COROUTINE
 #include "boost/asio.hpp"
+#include "boost/utility/string_view.hpp"
+#ifdef FLY_REDIS_ENABLE_COROUTINE
+#include "boost/asio/awaitable.hpp"
+#include "boost/asio/use_awaitable.hpp"
+#include "boost/asio/redirect_error.hpp"
+#endif // FLY_REDIS_ENABLE_COROUTINE
 #ifdef FLY_REDIS_ENABLE_TLS
 #include "boost/asio/ssl.hpp"
 #endif // FLY_REDIS_ENABLE_TLS
 #include <functional>
+#include <type_traits>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <cstdarg>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <deque>
 #include <string>
 #include <vector>
 #include <set>
 #include <map>
 
+// Param which is not shorter than it is referenced by the request instead of copied, see FlyRedisGatherParam
+#define FLY_REDIS_GATHER_PARAM_LEN (16 * 1024)
+
+//////////////////////////////////////////////////////////////////////////
+// Define GatherParam, large param which is not copied into the request buff, it is inserted at nOffset of the buff by gathered write.
+// The param should be valid until the request is sent
+struct FlyRedisGatherParam
+{
+    size_t nOffset = 0;
+    boost::string_view strParam;
+};
+
 //////////////////////////////////////////////////////////////////////////
 class CFlyRedisNetStream
 {
@@ -55,44 +90,93 @@ public:
         return m_strRedisAddress;
     }
 
-    inline void SetReadTimeoutSeconds(int nSeconds)
+    inline void SetReadTimeoutMS(int nMS)
+    {
+        m_nReadTimeoutMS = nMS;
+    }
+
+    inline int GetReadTimeoutMS() const
     {
-        m_nReadTimeoutSeconds = nSeconds;
+        return m_nReadTimeoutMS;
     }
 
+    // Resolve and connect until it is done or the read timeout is reached
     bool Connect();
 
-    bool ReadByLength(int nExpectedLen);
+    // Resolve and connect in async mode, the caller runs io context until IsConnecting returns false
+    void StartAsyncConnect();
+
+    inline bool IsConnecting() const
+    {
+        return m_bConnecting;
+    }
+
+    inline bool IsConnected() const
+    {
+        return m_bConnected;
+    }
+
+    // Return true if the last read waited until its deadline
+    inline bool IsReadTimeout() const
+    {
+        return m_bReadTimeout;
+    }
+
+    // Called once when the async connect is done, it is used by the caller which does not run io context by itself
+    inline void SetConnectHandler(const std::function<void(bool)>& fnConnectHandler)
+    {
+        m_fnConnectHandler = fnConnectHandler;
+    }
+
+    // Keep reading until Close, fnReadHandler is called after data is appended into recv buff, or with false if read failed
+    void StartAsyncReadLoop(const std::function<void(bool)>& fnReadHandler);
+
+    // Write in async mode, buffWrite should be valid until fnWriteHandler is called
+    void AsyncWrite(const char* buffWrite, size_t nBuffLen, const std::function<void(bool)>& fnWriteHandler);
+
+    // Close socket, the pending async operation is aborted
+    void Close();
+
+    // Wait until recv buff has nExpectedLen bytes, return false if the deadline is reached before
+    bool ReadByLength(int nExpectedLen, const std::chrono::steady_clock::time_point& tpDeadline);
 
     bool ReadByTime(int nBlockMS);
 
     inline int GlobalRecvBuffLen() const
     {
-        return static_cast<int>(m_strGlobalRecvBuff.length());
+        return static_cast<int>(m_strGlobalRecvBuff.length() - m_nRecvBuffReadPos);
     }
 
     bool Write(const char* buffWrite, size_t nBuffLen);
 
-    inline bool PickFirstChar(char& chHead)
+    // Gathered write, param of vecGatherParam is sent at its offset of strBuff, so it is not copied
+    bool Write(const std::string& strBuff, const std::vector<FlyRedisGatherParam>& vecGatherParam);
+
+    // Unconsumed data of recv buff, it is valid until next read
+    inline const char* GlobalRecvBuffData() const
     {
-        if (m_strGlobalRecvBuff.length() >= 1)
-        {
-            chHead = m_strGlobalRecvBuff[0];
-            m_strGlobalRecvBuff.erase(m_strGlobalRecvBuff.begin());
-            return true;
-        }
-        return false;
+        return m_strGlobalRecvBuff.c_str() + m_nRecvBuffReadPos;
     }
 
-    inline bool ConsumeRecvBuff(std::string& strDstBuff, int nLen)
+    inline void SkipRecvBuff(size_t nLen)
     {
-        if (nLen > (int)m_strGlobalRecvBuff.size())
+        m_nRecvBuffReadPos += nLen;
+        if (m_nRecvBuffReadPos > m_strGlobalRecvBuff.length())
         {
-            return false;
+            m_nRecvBuffReadPos = m_strGlobalRecvBuff.length();
         }
-        strDstBuff.append(m_strGlobalRecvBuff.c_str(), nLen);
-        m_strGlobalRecvBuff.erase(m_strGlobalRecvBuff.begin(), m_strGlobalRecvBuff.begin() + nLen);
-        return true;
+    }
+
+    // Consumed data is not dropped while recv buff is pinned, so the offset of data in it is stable.
+    // It is unpinned by the next Write
+    inline void PinRecvBuff()
+    {
+        m_bRecvBuffPinned = true;
+    }
+
+    inline const std::string& GetRecvBuff() const
+    {
+        return m_strGlobalRecvBuff;
     }
 
     inline const std::string& GetLocalIP() const
@@ -101,22 +185,58 @@ public:
     }
 
 private:
-    bool ConnectAsTLS(boost::asio::ip::tcp::resolver::results_type& boostEndPoints);
+    void HandleResolve(const boost::system::error_code& boostErrorCode, const boost::asio::ip::tcp::resolver::results_type& boostEndPoints);
+
+    void HandleConnect(const boost::system::error_code& boostErrorCode);
+
+#ifdef FLY_REDIS_ENABLE_TLS
+    void HandleTLSHandshake(const boost::system::error_code& boostErrorCode);
+#endif // FLY_REDIS_ENABLE_TLS
+
+    void HandleConnectTimeout(const boost::system::error_code& boostErrorCode, unsigned int nReadTimerSeq);
 
-    bool ConnectAsTCP(boost::asio::ip::tcp::resolver::results_type& boostEndPoints);
+    void FinishConnect(bool bConnected);
 
     void HandleRead(const boost::system::error_code& boostErrorCode, size_t nBytesTransferred);
 
     void StartAsyncRead();
 
+    void HandleReadTimeout(const boost::system::error_code& boostErrorCode, unsigned int nReadTimerSeq);
+
+    // Run io context until recv buff has nExpectedLen bytes, or the read timer expired
+    void WaitRecvBuff(int nExpectedLen, const std::chrono::steady_clock::time_point& tpDeadline);
+
+    // Append received data, compact the consumed head of recv buff only when it is worth to do
+    void AppendRecvBuff(const char* buffRecv, size_t nBuffLen);
+
 private:
     // RedisAddress, format: host:port
     std::string m_strRedisAddress;
-    int m_nReadTimeoutSeconds = 5;
+    int m_nReadTimeoutMS = 5000;
+    // Recv buff, data before m_nRecvBuffReadPos has been consumed
     std::string m_strGlobalRecvBuff;
-    char m_caThisbuffRecv[512] = { 0 };
+    size_t m_nRecvBuffReadPos = 0;
+    bool m_bRecvBuffPinned = false;
+    char m_caThisbuffRecv[16 * 1024] = { 0 };
     bool m_bInAsyncRead = false;
+    // Set when the socket read failed, there is no need to wait for more data
+    bool m_bReadError = false;
     boost::asio::io_context& m_boostIOContext;
+    // Deadline of the waiting read, handler of an old wait is ignored by its seq
+    boost::asio::steady_timer m_boostReadTimer;
+    unsigned int m_nReadTimerSeq = 0;
+    bool m_bReadTimeout = false;
+    // Async connect state, m_boostReadTimer is the deadline of connect too
+    boost::asio::ip::tcp::resolver m_boostResolver;
+    bool m_bConnecting = false;
+    bool m_bConnected = false;
+    bool m_bConnectTimeout = false;
+    std::function<void(bool)> m_fnConnectHandler;
+    std::function<void(bool)> m_fnReadHandler;
+    // Every asio handler holds it weakly, the handler which runs after this stream is destroyed is dropped
+    std::shared_ptr<bool> m_pAliveToken = std::make_shared<bool>(true);
+    // Buffer sequence of gathered write, it keeps its capacity for the next write
+    std::vector<boost::asio::const_buffer> m_vecGatherBuff;
 #ifdef FLY_REDIS_ENABLE_TLS
     bool m_bUseTLSFlag = false;
     boost::asio::ssl::stream<boost::asio::ip::tcp::socket> m_boostTLSSocketStream;
@@ -127,217 +247,1617 @@ private:
 };
 
 //////////////////////////////////////////////////////////////////////////
-// ReadWriteType, Default type is ReadWriteOnMaster
-enum class FlyRedisReadWriteType : int
+// ReadWriteType, Default type is ReadWriteOnMaster
+enum class FlyRedisReadWriteType : int
+{
+    ReadWriteOnMaster = 1,  // Default
+    ReadOnSlaveWriteOnMaster = 2,
+};
+
+// Slot count of redis cluster
+#define FLY_REDIS_CLUSTER_SLOT_COUNT 16384
+
+enum class FlyRedisClusterDetectType : int
+{
+    AutoDetect = 1,         // Default
+    EnableCluster = 2,
+    DisableCluster = 3,
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define RESP handler, it receives every value while the reply is being parsed
+class CFlyRedisRESPHandler
+{
+public:
+    virtual ~CFlyRedisRESPHandler()
+    {
+    }
+
+    // Scalar value, chType is the RESP type char, pData is nullptr if it is a null value
+    virtual void OnRESPValue(char chType, const char* pData, size_t nLen) = 0;
+
+    // Aggregate value, nCount is the element count, for map and attribute it is the KVP count
+    virtual void OnRESPAggregateBegin(char chType, int nCount) = 0;
+    virtual void OnRESPAggregateEnd(char chType) = 0;
+};
+
+enum class FlyRedisRESPParseResult : int
+{
+    Complete = 1,
+    NeedMoreData = 2,
+    ProtocolError = 3,
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define RESP parser, it is resumable, the parse state is kept when the reply is not complete
+class CFlyRedisRESPParser
+{
+public:
+    CFlyRedisRESPParser();
+
+    // Reset parse state
+    void Reset();
+
+    // Parse one reply from buff, nConsumed is the length of buff which has been parsed and can be dropped
+    FlyRedisRESPParseResult Parse(const char* pBuff, size_t nBuffLen, size_t& nConsumed, CFlyRedisRESPHandler& hHandler);
+
+    // Min length of unconsumed buff to continue parsing, valid after Parse return NeedMoreData
+    inline int GetExpectedLen() const
+    {
+        return m_nExpectedLen;
+    }
+
+    // RESP type char of the top level reply, '_' if it is a null value, valid after Parse return Complete
+    inline char GetReplyTypeChar() const
+    {
+        return m_chReplyType;
+    }
+
+    // Skip the format prefix of VerbatimString, such as "txt:", so only the text is kept. Value of other type is not changed
+    static void SkipVerbatimFormat(char chType, const char*& pData, size_t& nLen);
+
+private:
+    // Return true if the top level reply is complete
+    bool FinishValue(CFlyRedisRESPHandler& hHandler);
+
+    static bool ParseLength(const char* pBegin, const char* pEnd, int& nLength);
+
+private:
+    struct AggregateFrame
+    {
+        char chType;
+        int nRemainCount;
+    };
+    std::vector<AggregateFrame> m_vecAggregateFrame;
+    // Type and length of the bulk string whose header has been parsed, -1 means no pending bulk
+    char m_chPendingBulkType = 0;
+    int m_nPendingBulkLen = -1;
+    int m_nExpectedLen = 1;
+    char m_chReplyType = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisSession, Describe TCP session to one redis server node.
+struct FlyRedisResponse
+{
+    FlyRedisResponse()
+    {
+    }
+
+    inline void Reset()
+    {
+        strRedisResponse.clear();
+        vecRedisResponse.clear();
+        mapRedisResponse.clear();
+        setRedisResponse.clear();
+    }
+
+    inline void Swap(FlyRedisResponse& stOther)
+    {
+        strRedisResponse.swap(stOther.strRedisResponse);
+        vecRedisResponse.swap(stOther.vecRedisResponse);
+        mapRedisResponse.swap(stOther.mapRedisResponse);
+        setRedisResponse.swap(stOther.setRedisResponse);
+    }
+
+    std::string strRedisResponse;
+    std::vector<std::string> vecRedisResponse;
+    std::map<std::string, std::string> mapRedisResponse;
+    std::set<std::string> setRedisResponse;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisPipelineResponse, response of one cmd in pipeline
+struct FlyRedisPipelineResponse
+{
+    // true if redis server replied an error, the error msg is in stRedisResponse.strRedisResponse
+    bool bResponseError = false;
+    FlyRedisResponse stRedisResponse;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisResponseBuilder, fill RESP value into FlyRedisResponse
+class CFlyRedisResponseBuilder : public CFlyRedisRESPHandler
+{
+public:
+    CFlyRedisResponseBuilder(FlyRedisResponse& stRedisResponse, const std::string& strRedisAddress);
+
+    inline void Reset()
+    {
+        m_bRedisResponseError = false;
+        m_vecAggregateType.clear();
+        m_vecExpectMapValue.clear();
+    }
+
+    inline bool HasResponseError() const
+    {
+        return m_bRedisResponseError;
+    }
+
+    inline const std::string& GetLastResponseErrorMsg() const
+    {
+        return m_strLastResponseErrorMsg;
+    }
+
+    virtual void OnRESPValue(char chType, const char* pData, size_t nLen) override;
+    virtual void OnRESPAggregateBegin(char chType, int nCount) override;
+    virtual void OnRESPAggregateEnd(char chType) override;
+
+private:
+    // A value of current aggregate has been filled into strRedisResponse
+    void FinishElement();
+
+private:
+    FlyRedisResponse& m_stRedisResponse;
+    const std::string& m_strRedisAddress;
+    bool m_bRedisResponseError = false;
+    std::string m_strLastResponseErrorMsg;
+    // Type of aggregate which is being built, and the pending map key
+    std::vector<char> m_vecAggregateType;
+    std::vector<bool> m_vecExpectMapValue;
+    std::string m_strMapKey;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisReplyType, type of node in reply tree
+enum class FlyRedisReplyType : int
+{
+    Status = 1, // Simple Strings
+    Error = 2, // Errors and BlobError
+    Int = 3,
+    Double = 4,
+    Bool = 5,
+    BigNumber = 6,
+    Bulk = 7, // Bulk Strings and VerbatimString
+    Null = 8, // Null, and null Bulk Strings or Array of RESP2
+    Array = 9,
+    Map = 10,
+    Set = 11,
+    Push = 12,
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisReplyNode, one value of reply tree, the node and its payload are allocated from CFlyRedisReplyArena
+struct FlyRedisReplyNode
+{
+    inline std::string GetString() const
+    {
+        return std::string(pData, nLen);
+    }
+
+    inline boost::string_view GetStringView() const
+    {
+        return boost::string_view(pData, nLen);
+    }
+
+    inline bool IsAggregate() const
+    {
+        return FlyRedisReplyType::Array == nType || FlyRedisReplyType::Map == nType || FlyRedisReplyType::Set == nType || FlyRedisReplyType::Push == nType;
+    }
+
+    // Map has nCount KVP, key and value are adjacent elements
+    inline int GetElementCount() const
+    {
+        return (FlyRedisReplyType::Map == nType) ? nCount * 2 : nCount;
+    }
+
+    inline const FlyRedisReplyNode& GetElement(int nIndex) const
+    {
+        return pElement[nIndex];
+    }
+
+    FlyRedisReplyType nType = FlyRedisReplyType::Null;
+    // Text of scalar value as it is in RESP, it is end with '\0' unless it is a reply view
+    const char* pData = "";
+    size_t nLen = 0;
+    // Value of Int and Bool
+    long long nInt = 0;
+    double fDouble = 0.0;
+    // Element of aggregate
+    int nCount = 0;
+    FlyRedisReplyNode* pElement = nullptr;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define ReplyArena, bump allocator of reply tree, every allocation is dropped by Reset at once
+class CFlyRedisReplyArena
+{
+public:
+    explicit CFlyRedisReplyArena(size_t nBlockLen);
+
+    // Allocate nLen bytes aligned by nAlign, nAlign should be power of 2
+    void* Allocate(size_t nLen, size_t nAlign);
+
+    // Copy string into arena, it is end with '\0'
+    const char* CopyString(const char* pData, size_t nLen);
+
+    // Drop every allocation, block is kept for next reply, except the one which is larger than block len
+    void Reset();
+
+    inline size_t GetAllocatedLen() const
+    {
+        return m_nAllocatedLen;
+    }
+
+private:
+    struct ArenaBlock
+    {
+        std::unique_ptr<char[]> pData;
+        size_t nLen;
+    };
+    std::vector<ArenaBlock> m_vecArenaBlock;
+    size_t m_nBlockLen;
+    size_t m_nBlockIndex = 0;
+    size_t m_nBlockOffset = 0;
+    size_t m_nAllocatedLen = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define NumberCodec, encode and decode integer and double of RESP without temporary string.
+// Double is encoded in text which is decoded back to exactly the same value, such as "0.1" instead of "0.100000".
+// It is the fewest fraction digits in decimal form, so it may be longer than the exponent form, such as "0.00000063"
+class CFlyRedisNumberCodec
+{
+public:
+    // Encode into pBuff without terminator, pBuff should have 32 bytes at least, return the length
+    static size_t EncodeInt(char* pBuff, long long nValue);
+    static size_t EncodeUInt(char* pBuff, unsigned long long nValue);
+    static size_t EncodeDouble(char* pBuff, double fValue);
+
+    static std::string DoubleToString(double fValue);
+
+    // Decode the whole text of [pBegin, pEnd), return false if it is not a number or out of range
+    static bool DecodeInt(const char* pBegin, const char* pEnd, long long& nValue);
+    static bool DecodeUInt(const char* pBegin, const char* pEnd, unsigned long long& nValue);
+    static bool DecodeDouble(const char* pBegin, const char* pEnd, double& fValue);
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define visitor of reply element, the string view is valid only in the visitor
+using FlyRedisElementVisitor = std::function<void(const boost::string_view& strElement)>;
+using FlyRedisKVPVisitor = std::function<void(const boost::string_view& strField, const boost::string_view& strValue)>;
+// Element count of top level aggregate, it is read from the length header before any element is parsed.
+// If the first element is nested aggregate, it is visited again with the count of flattened element
+using FlyRedisElementCountVisitor = std::function<void(int nElementCount)>;
+
+//////////////////////////////////////////////////////////////////////////
+// Decode reply element into value of caller container, null element is decoded as default value
+inline bool FlyRedisDecodeElement(const boost::string_view& strElement, std::string& strValue)
+{
+    strValue.assign(strElement.data(), strElement.size());
+    return true;
+}
+
+template <typename TValue>
+inline typename std::enable_if<std::is_integral<TValue>::value && std::is_signed<TValue>::value, bool>::type FlyRedisDecodeElement(const boost::string_view& strElement, TValue& nValue)
+{
+    nValue = 0;
+    if (strElement.empty())
+    {
+        return true;
+    }
+    long long nResult = 0;
+    if (!CFlyRedisNumberCodec::DecodeInt(strElement.data(), strElement.data() + strElement.size(), nResult)
+        || nResult < static_cast<long long>(std::numeric_limits<TValue>::min())
+        || nResult > static_cast<long long>(std::numeric_limits<TValue>::max()))
+    {
+        return false;
+    }
+    nValue = static_cast<TValue>(nResult);
+    return true;
+}
+
+template <typename TValue>
+inline typename std::enable_if<std::is_integral<TValue>::value && !std::is_signed<TValue>::value, bool>::type FlyRedisDecodeElement(const boost::string_view& strElement, TValue& nValue)
+{
+    nValue = 0;
+    if (strElement.empty())
+    {
+        return true;
+    }
+    unsigned long long nResult = 0;
+    if (!CFlyRedisNumberCodec::DecodeUInt(strElement.data(), strElement.data() + strElement.size(), nResult)
+        || nResult > static_cast<unsigned long long>(std::numeric_limits<TValue>::max()))
+    {
+        return false;
+    }
+    nValue = static_cast<TValue>(nResult);
+    return true;
+}
+
+template <typename TValue>
+inline typename std::enable_if<std::is_floating_point<TValue>::value, bool>::type FlyRedisDecodeElement(const boost::string_view& strElement, TValue& fValue)
+{
+    fValue = 0;
+    if (strElement.empty())
+    {
+        return true;
+    }
+    double fResult = 0.0;
+    if (!CFlyRedisNumberCodec::DecodeDouble(strElement.data(), strElement.data() + strElement.size(), fResult))
+    {
+        return false;
+    }
+    fValue = static_cast<TValue>(fResult);
+    return true;
+}
+
+// Reserve container by element count, container without reserve, such as std::set, is skipped
+template <typename TContainer>
+inline auto FlyRedisReserveContainer(TContainer& hContainer, size_t nCount, int) -> decltype(hContainer.reserve(nCount), void())
+{
+    hContainer.reserve(hContainer.size() + nCount);
+}
+
+template <typename TContainer>
+inline void FlyRedisReserveContainer(TContainer& /*hContainer*/, size_t /*nCount*/, long)
+{
+}
+
+template <typename TValue>
+struct FlyRedisPairTraits
+{
+    static const bool bIsPair = false;
+};
+
+template <typename TFirst, typename TSecond>
+struct FlyRedisPairTraits<std::pair<TFirst, TSecond> >
+{
+    static const bool bIsPair = true;
+    // Key of std::map is const, it is decoded into mutable value then moved into container
+    using FirstType = typename std::remove_const<TFirst>::type;
+    using SecondType = TSecond;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define ElementDecoder, element of top level aggregate is decoded while it is parsed
+class CFlyRedisElementDecoder
+{
+public:
+    virtual ~CFlyRedisElementDecoder() = default;
+    virtual void OnElementCount(int nElementCount) = 0;
+    virtual void OnElement(const boost::string_view& strElement) = 0;
+    virtual bool IsDecodeSuccess() const = 0;
+};
+
+// Decode element into caller container by insert at end, such as std::vector<int64_t>, std::unordered_set
+template <typename TContainer, bool bIsPair = FlyRedisPairTraits<typename TContainer::value_type>::bIsPair>
+class CFlyRedisContainerDecoder : public CFlyRedisElementDecoder
+{
+public:
+    explicit CFlyRedisContainerDecoder(TContainer& hContainer)
+        :m_hContainer(hContainer)
+    {
+        m_hContainer.clear();
+    }
+
+    virtual void OnElementCount(int nElementCount) override
+    {
+        FlyRedisReserveContainer(m_hContainer, nElementCount, 0);
+    }
+
+    virtual void OnElement(const boost::string_view& strElement) override
+    {
+        typename TContainer::value_type hValue;
+        if (!FlyRedisDecodeElement(strElement, hValue))
+        {
+            m_bDecodeError = true;
+            return;
+        }
+        m_hContainer.insert(m_hContainer.end(), std::move(hValue));
+    }
+
+    virtual bool IsDecodeSuccess() const override
+    {
+        return !m_bDecodeError;
+    }
+
+private:
+    TContainer& m_hContainer;
+    bool m_bDecodeError = false;
+};
+
+// Decode two elements in turn into std::pair, such as field and value of HGETALL, member and score of WITHSCORES.
+// It fits std::map, std::unordered_map and std::vector<std::pair<>>
+template <typename TContainer>
+class CFlyRedisContainerDecoder<TContainer, true> : public CFlyRedisElementDecoder
+{
+public:
+    explicit CFlyRedisContainerDecoder(TContainer& hContainer)
+        :m_hContainer(hContainer)
+    {
+        m_hContainer.clear();
+    }
+
+    // Count is of flattened element, RESP2 array, RESP3 map and RESP3 nested pair all count field and value as two elements
+    virtual void OnElementCount(int nElementCount) override
+    {
+        FlyRedisReserveContainer(m_hContainer, nElementCount / 2, 0);
+    }
+
+    virtual void OnElement(const boost::string_view& strElement) override
+    {
+        if (!m_bExpectSecond)
+        {
+            m_bDecodeError = m_bDecodeError || !FlyRedisDecodeElement(strElement, m_hFirst);
+            m_bExpectSecond = true;
+            return;
+        }
+        typename FlyRedisPairTraits<typename TContainer::value_type>::SecondType hSecond;
+        m_bDecodeError = m_bDecodeError || !FlyRedisDecodeElement(strElement, hSecond);
+        m_bExpectSecond = false;
+        if (!m_bDecodeError)
+        {
+            // Duplicate field is not inserted into map, it is taken as decode error
+            size_t nSize = m_hContainer.size();
+            m_hContainer.insert(m_hContainer.end(), typename TContainer::value_type(std::move(m_hFirst), std::move(hSecond)));
+            m_bDecodeError = (m_hContainer.size() == nSize);
+        }
+    }
+
+    virtual bool IsDecodeSuccess() const override
+    {
+        return !m_bDecodeError && !m_bExpectSecond;
+    }
+
+private:
+    TContainer& m_hContainer;
+    typename FlyRedisPairTraits<typename TContainer::value_type>::FirstType m_hFirst;
+    bool m_bExpectSecond = false;
+    bool m_bDecodeError = false;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define ReplyBuilder, build typed reply tree which keeps nested aggregate, such as EXEC, XREAD and CLUSTER SLOTS.
+// Reset should be called before every reply, it releases the tree of the last reply. Attribute of RESP3 is dropped
+class CFlyRedisReplyBuilder : public CFlyRedisRESPHandler
+{
+public:
+    CFlyRedisReplyBuilder();
+
+    void Reset();
+
+    // In reply view mode, string of node points into recv buff instead of being copied into arena
+    inline void SetReplyView(bool bReplyView)
+    {
+        m_bReplyView = bReplyView;
+    }
+
+    inline bool IsReplyView() const
+    {
+        return m_bReplyView;
+    }
+
+    // In visit mode, every element of the top level aggregate is passed to fnElementVisitor while it is parsed, and it is not kept in the tree.
+    // Nested aggregate of element is flattened, such as member and score of RESP3 WITHSCORES, nullptr means visit mode is disabled
+    inline void SetElementVisitor(const FlyRedisElementVisitor& fnElementVisitor, const FlyRedisElementCountVisitor& fnElementCountVisitor = nullptr)
+    {
+        m_fnElementVisitor = fnElementVisitor;
+        m_fnElementCountVisitor = fnElementCountVisitor;
+    }
+
+    // Recv buff which is parsed in reply view mode, it should be pinned until the reply is dropped.
+    // ResolveReplyView points string of node into it when the reply is complete
+    inline void BindRecvBuff(const std::string* pRecvBuff)
+    {
+        m_pRecvBuff = pRecvBuff;
+    }
+    void ResolveReplyView();
+
+    // Root node of the reply, nullptr if no reply has been parsed
+    inline const FlyRedisReplyNode* GetReply() const
+    {
+        return m_pReply;
+    }
+
+    // True if the root node is an error, error in aggregate is kept as element
+    inline bool HasResponseError() const
+    {
+        return m_bRedisResponseError;
+    }
+
+    inline const std::string& GetLastResponseErrorMsg() const
+    {
+        return m_strLastResponseErrorMsg;
+    }
+
+    inline const CFlyRedisReplyArena& GetReplyArena() const
+    {
+        return m_hReplyArena;
+    }
+
+    virtual void OnRESPValue(char chType, const char* pData, size_t nLen) override;
+    virtual void OnRESPAggregateBegin(char chType, int nCount) override;
+    virtual void OnRESPAggregateEnd(char chType) override;
+
+private:
+    // Node of root or the next element of current aggregate
+    FlyRedisReplyNode* NextReplyNode();
+
+private:
+    struct AggregateFrame
+    {
+        FlyRedisReplyNode* pNode;
+        int nFilledCount;
+    };
+    CFlyRedisReplyArena m_hReplyArena;
+    FlyRedisReplyNode* m_pReply = nullptr;
+    std::vector<AggregateFrame> m_vecAggregateFrame;
+    // Depth of aggregate which is being dropped, such as attribute
+    int m_nDropDepth = 0;
+    // Depth of nested aggregate which is flattened in visit mode
+    int m_nFlattenDepth = 0;
+    bool m_bRedisResponseError = false;
+    std::string m_strLastResponseErrorMsg;
+    // Node of reply view and offset of its string in recv buff, recv buff may be reallocated until the reply is complete
+    bool m_bReplyView = false;
+    const std::string* m_pRecvBuff = nullptr;
+    std::vector<std::pair<FlyRedisReplyNode*, size_t> > m_vecReplyViewOffset;
+    FlyRedisElementVisitor m_fnElementVisitor;
+    FlyRedisElementCountVisitor m_fnElementCountVisitor;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisClusterTopology, slot owner of redis cluster, it is parsed from CLUSTER SHARDS or CLUSTER SLOTS
+struct FlyRedisClusterTopology
+{
+    FlyRedisClusterTopology()
+        :vecSlotMaster(FLY_REDIS_CLUSTER_SLOT_COUNT, -1),
+        vecSlotSlave(FLY_REDIS_CLUSTER_SLOT_COUNT, -1)
+    {
+    }
+
+    // Return index of the redis node, it is added if not exists
+    int AddRedisNode(const std::string& strRedisAddress, bool bIsMaster);
+
+    inline bool operator==(const FlyRedisClusterTopology& stOther) const
+    {
+        return vecRedisAddress == stOther.vecRedisAddress && vecMasterFlag == stOther.vecMasterFlag
+            && vecSlotMaster == stOther.vecSlotMaster && vecSlotSlave == stOther.vecSlotSlave;
+    }
+
+    // Redis node address, ip:port
+    std::vector<std::string> vecRedisAddress;
+    std::vector<bool> vecMasterFlag;
+    // Index: slot, Value: index of vecRedisAddress, -1 means the slot has no owner
+    std::vector<int> vecSlotMaster;
+    std::vector<int> vecSlotSlave;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisClusterTopologyBuilder, fill reply of CLUSTER SHARDS or CLUSTER SLOTS into FlyRedisClusterTopology
+class CFlyRedisClusterTopologyBuilder : public CFlyRedisRESPHandler
+{
+public:
+    CFlyRedisClusterTopologyBuilder(FlyRedisClusterTopology& stClusterTopology, const std::string& strRedisAddress, bool bIsShardsReply);
+
+    inline bool HasResponseError() const
+    {
+        return m_bRedisResponseError;
+    }
+
+    virtual void OnRESPValue(char chType, const char* pData, size_t nLen) override;
+    virtual void OnRESPAggregateBegin(char chType, int nCount) override;
+    virtual void OnRESPAggregateEnd(char chType) override;
+
+private:
+    // Node of current slot range or shard has been parsed
+    void FinishRedisNode(bool bIsMaster);
+
+    // Slot range or shard has been parsed, fill slot owner of it
+    void FinishSlotRange();
+
+private:
+    FlyRedisClusterTopology& m_stClusterTopology;
+    // Host of the queried node, it is used when the node endpoint is unknown
+    std::string m_strDefaultHost;
+    bool m_bIsShardsReply = false;
+    bool m_bRedisResponseError = false;
+    // Index of current element in every aggregate level
+    std::vector<int> m_vecElementIndex;
+    // Slot value of current slot range or shard, as: min, max, min, max...
+    std::vector<int> m_vecSlotValue;
+    int m_nMasterIndex = -1;
+    int m_nSlaveIndex = -1;
+    // Field of current node
+    std::string m_strMapKey;
+    std::string m_strNodeKey;
+    std::string m_strNodeHost;
+    std::string m_strNodeIP;
+    std::string m_strNodePort;
+    bool m_bNodeIsMaster = false;
+    bool m_bNodeIsOnline = true;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisHandshakeConfig, cmd of it are sent in one round trip after a session is connected
+struct FlyRedisHandshakeConfig
+{
+    // AUTH is sent if strPassword is not empty, strUserName is used by ACL of Redis 6.*
+    std::string strUserName;
+    std::string strPassword;
+    // HELLO is sent if nRESPVersion is greater than 0, it is ignored by the server before Redis 6.*
+    int nRESPVersion = 0;
+    // CLIENT SETNAME is sent if strClientName is not empty
+    std::string strClientName;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Every power of two of latency is split into 2^FLY_REDIS_LATENCY_SUB_BUCKET_BITS buckets, so the error of percentile is less than 1/16.
+// Latency which is not less than 2^FLY_REDIS_LATENCY_MAX_BITS microseconds, about 17 minutes, is recorded into the last bucket
+#define FLY_REDIS_LATENCY_SUB_BUCKET_BITS 4
+#define FLY_REDIS_LATENCY_MAX_BITS 30
+#define FLY_REDIS_LATENCY_BUCKET_COUNT ((FLY_REDIS_LATENCY_MAX_BITS - FLY_REDIS_LATENCY_SUB_BUCKET_BITS + 1) << FLY_REDIS_LATENCY_SUB_BUCKET_BITS)
+
+//////////////////////////////////////////////////////////////////////////
+// Define CFlyRedisLatencyHistogram, HDR style histogram of latency in microseconds.
+// Record is one bucket index calculation without allocation, so it is always on
+class CFlyRedisLatencyHistogram
+{
+public:
+    CFlyRedisLatencyHistogram();
+
+    void Record(unsigned long long nLatencyUS);
+
+    inline void RecordSince(const std::chrono::steady_clock::time_point& tpBegin)
+    {
+        Record(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tpBegin).count()));
+    }
+
+    // Add every record of hOther into this histogram
+    void Merge(const CFlyRedisLatencyHistogram& hOther);
+
+    void Reset();
+
+    inline unsigned long long GetCount() const
+    {
+        return m_nCount;
+    }
+
+    inline unsigned long long GetMaxUS() const
+    {
+        return m_nMaxUS;
+    }
+
+    inline unsigned long long GetMeanUS() const
+    {
+        return (m_nCount > 0) ? m_nSumUS / m_nCount : 0;
+    }
+
+    // Latency of fPercentile, such as 50, 99 and 99.9, it is the upper bound of its bucket and not greater than max. Return 0 if it is empty
+    unsigned long long GetPercentileUS(double fPercentile) const;
+
+private:
+    static int GetBucketIndex(unsigned long long nLatencyUS);
+    static unsigned long long GetBucketUpperBound(int nBucketIndex);
+
+private:
+    unsigned long long m_nBucketCount[FLY_REDIS_LATENCY_BUCKET_COUNT];
+    unsigned long long m_nCount = 0;
+    unsigned long long m_nSumUS = 0;
+    unsigned long long m_nMaxUS = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisNodeStats, stats of one redis node, it is owned by CFlyRedisClient and kept when the session is reconnected
+struct FlyRedisNodeStats
+{
+    inline unsigned long long GetReplyCount(FlyRedisReplyType nReplyType) const
+    {
+        return nReplyCount[static_cast<int>(nReplyType)];
+    }
+
+    unsigned long long nBytesSent = 0;
+    unsigned long long nBytesReceived = 0;
+    // Index: FlyRedisReplyType of the top level reply, error reply is counted by FlyRedisReplyType::Error
+    unsigned long long nReplyCount[static_cast<int>(FlyRedisReplyType::Push) + 1] = { 0 };
+    // Full reply was not received before read timeout
+    unsigned long long nTimeoutCount = 0;
+    // Read or write failed, or the reply is not valid RESP, the session is broken then
+    unsigned long long nNetworkErrorCount = 0;
+    unsigned long long nConnectCount = 0;
+    // Session is connected again after the first session of this node was destroyed
+    unsigned long long nReconnectCount = 0;
+    // From request written to full reply received, pipeline is not included
+    CFlyRedisLatencyHistogram hLatency;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisCmdStats, stats of one cmd name, latency includes MOVED/ASK redirect
+struct FlyRedisCmdStats
+{
+    unsigned long long nCmdCount = 0;
+    unsigned long long nFailedCount = 0;
+    CFlyRedisLatencyHistogram hLatency;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisStatsSnapshot, copy of stats of one CFlyRedisClient
+struct FlyRedisStatsSnapshot
+{
+    // Key: redis address, ip:port
+    std::map<std::string, FlyRedisNodeStats> mapNodeStats;
+    // Key: cmd name, such as SET, or ExecPipeline for the whole pipeline
+    std::map<std::string, FlyRedisCmdStats> mapCmdStats;
+};
+
+class CFlyRedisSession
+{
+public:
+    // Constructor
+#ifdef FLY_REDIS_ENABLE_TLS
+    CFlyRedisSession(boost::asio::io_context& boostIOContext, bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext);
+#else
+    CFlyRedisSession(boost::asio::io_context& boostIOContext);
+#endif // FLY_REDIS_ENABLE_TLS
+
+    // Destructor
+    ~CFlyRedisSession();
+
+    // Set redis address
+    void SetRedisAddress(const std::string& strAddress);
+
+    // Set read timeout, a full reply should be received in it
+    inline void SetReadTimeoutMS(int nMS)
+    {
+        m_hNetStream.SetReadTimeoutMS(nMS);
+    }
+
+    // Get redis address
+    const std::string& GetRedisAddr() const;
+
+    // Connect to redis node
+    bool Connect();
+
+    // Connect in async mode, the caller runs io context until IsConnecting returns false
+    void StartAsyncConnect();
+    bool IsConnecting() const;
+    bool IsConnected() const;
+
+    // Handshake is split into send and recv, so many sessions can send it before any response is received.
+    // It runs AUTH, HELLO, CLIENT SETNAME, READONLY by config, then resolves server version and cluster flag by INFO
+    bool SendHandshake(const FlyRedisHandshakeConfig& stHandshakeConfig, bool bReadOnly);
+    bool RecvHandshake(const FlyRedisHandshakeConfig& stHandshakeConfig, bool bReadOnly);
+
+    // Process redis cmd request, large param of pVecGatherParam is sent by gathered write
+    bool ProcRedisRequest(const std::string& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam = nullptr);
+
+    // Process redis cmd request, the response is parsed by hHandler
+    bool ProcRedisRequest(const std::string& strRedisCmdRequest, CFlyRedisRESPHandler& hHandler);
+
+    // Process redis cmd request, the response is built into reply tree of hReplyBuilder.
+    // Reply view of hReplyBuilder points into recv buff, it is valid until the next request of this session
+    bool ProcRedisRequest(const std::string& strRedisCmdRequest, CFlyRedisReplyBuilder& hReplyBuilder, const std::vector<FlyRedisGatherParam>* pVecGatherParam = nullptr);
+
+    // Send redis cmd request without waiting the response, the request may contain more than one cmd
+    bool SendRedisRequest(const std::string& strRedisCmdRequest);
+
+    // Recv response of one cmd which has been sent by SendRedisRequest, return false if network failed
+    bool RecvPipelineResponse(FlyRedisPipelineResponse& stPipelineResponse);
+
+    // Try send/recv redis response
+    bool TrySendRedisRequest(const std::string& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam = nullptr);
+    bool TryRecvRedisResponse(int nBlockMS);
+
+    // Get RESP Version
+    inline int GetRESPVersion() const
+    {
+        return m_nRESPVersion;
+    }
+
+    // Return cluster enabled flag which is resolved by handshake
+    inline bool GetHandshakeClusterEnabledFlag() const
+    {
+        return m_bClusterEnabled;
+    }
+
+    // Fetch cluster topology, use CLUSTER SHARDS for Redis 7.*, else use CLUSTER SLOTS
+    bool FetchClusterTopology(FlyRedisClusterTopology& stClusterTopology);
+
+    inline void ResetRedisResponse()
+    {
+        m_stRedisResponse.Reset();
+    }
+
+    inline std::string& GetRedisResponseString()
+    {
+        return m_stRedisResponse.strRedisResponse;
+    }
+
+    inline std::vector<std::string>& GetRedisResponseVector()
+    {
+        return m_stRedisResponse.vecRedisResponse;
+    }
+
+    inline std::set<std::string>& GetRedisResponseSet()
+    {
+        return m_stRedisResponse.setRedisResponse;
+    }
+
+    inline std::map<std::string, std::string>& GetRedisResponseMap()
+    {
+        return m_stRedisResponse.mapRedisResponse;
+    }
+
+    inline void SwapRedisResponse(FlyRedisResponse& stRedisResponse)
+    {
+        m_stRedisResponse.Swap(stRedisResponse);
+    }
+
+    // Return true if read or write failed, the stream may have unread data, so it should not be used any more
+    inline bool IsBroken() const
+    {
+        return m_bBroken;
+    }
+
+    // Return true if last response is an error
+    inline bool HasResponseError() const
+    {
+        return m_hResponseBuilder.HasResponseError();
+    }
+
+    inline const std::string& GetLastResponseErrorMsg() const
+    {
+        return m_hResponseBuilder.GetLastResponseErrorMsg();
+    }
+
+    inline const char* GetLastResponseErrorMsgCStr() const
+    {
+        return m_hResponseBuilder.GetLastResponseErrorMsg().c_str();
+    }
+
+    std::string GetLastFullResponseString() const;
+
+    inline const std::string& GetLocalIP() const
+    {
+        return m_hNetStream.GetLocalIP();
+    }
+
+    // Traffic of this session is recorded into pNodeStats which is owned by the client, nullptr means it is not recorded
+    inline void SetNodeStats(FlyRedisNodeStats* pNodeStats)
+    {
+        m_pNodeStats = pNodeStats;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// Begin of RedisCmd
+    bool AUTH(const std::string& strPassword);
+    bool PING();
+    bool READONLY();
+    bool ASKING();
+    bool INFO(const std::string& strSection, std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo);
+    bool CLUSTER_NODES(std::vector<std::string>& vecResult);
+    bool CLUSTER_SLOTS(FlyRedisClusterTopology& stClusterTopology);
+    bool CLUSTER_SHARDS(FlyRedisClusterTopology& stClusterTopology);
+    bool SCRIPT_LOAD(const std::string& strScript, std::string& strResult);
+    bool SCRIPT_FLUSH();
+    bool SCRIPT_EXISTS(const std::string& strSHA);
+    bool HELLO(int nVersion);
+    bool HELLO_AUTH_SETNAME(int nVersion, const std::string& strUserName, const std::string& strPassword, const std::string& strClientName);
+    /// End of RedisCmd
+    //////////////////////////////////////////////////////////////////////////
+
+private:
+    // Recv redis response
+    bool RecvRedisResponse();
+    bool RecvRedisResponse(CFlyRedisRESPHandler& hHandler);
+
+    // Write request, it is gathered write if pVecGatherParam is not empty
+    bool WriteRedisRequest(const std::string& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam);
+
+    // Record latency of the request which was written at tpBegin and its full reply has been received
+    void RecordLatency(const std::chrono::steady_clock::time_point& tpBegin);
+
+    // Return true if RedisServer Support this cmd
+    bool VerifyRedisServerVersion6(const char* pszCmdName) const;
+
+    std::string GetServerInfoSectionField(const std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo, const std::string& strSection, const std::string& strField);
+
+private:
+    //////////////////////////////////////////////////////////////////////////
+    // Network data member
+    CFlyRedisNetStream m_hNetStream;
+    CFlyRedisRESPParser m_hRESPParser;
+    //////////////////////////////////////////////////////////////////////////
+    std::string m_strRedisVersion;
+    bool m_bClusterEnabled = false;
+    bool m_bBroken = false;
+    // Resp Version, default version was RESP2, if the server was greater than V6.0, it will be switched to RESP3
+    int m_nRESPVersion = 2;
+    //////////////////////////////////////////////////////////////////////////
+    // Last Response of this redis session
+    FlyRedisResponse m_stRedisResponse;
+    CFlyRedisResponseBuilder m_hResponseBuilder;
+    //////////////////////////////////////////////////////////////////////////
+    FlyRedisNodeStats* m_pNodeStats = nullptr;
+};
+//////////////////////////////////////////////////////////////////////////
+using FlyRedisSubscribeResponse = struct FlyRedisSubscribeResponse;
+struct FlyRedisSubscribeResponse
+{
+    std::string strCmd;
+    std::string strChannel;
+    std::string strMsg;
+};
+using FlyRedisPMessageResponse = struct FlyRedisPMessageResponse;
+struct FlyRedisPMessageResponse
+{
+    std::string strCmd;
+    std::string strPattern;
+    std::string strChannel;
+    std::string strMsg;
+};
+//////////////////////////////////////////////////////////////////////////
+// Define FlyRedisPipeline, queue redis cmd and run them in one batch by CFlyRedisClient::ExecPipeline
+class CFlyRedisPipeline
+{
+public:
+    struct PipelineRedisCmd
+    {
+        std::string strKey;
+        bool bIsWrite = false;
+        std::vector<std::string> vecRedisCmdParamList;
+    };
+
+    // Constructor
+    CFlyRedisPipeline();
+
+    // Destructor
+    ~CFlyRedisPipeline();
+
+    // Queue one redis cmd, strKey is used to choose redis node in cluster mode, it is empty for keyless cmd
+    void AppendRedisCmd(const std::string& strKey, bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList);
+
+    inline const std::vector<PipelineRedisCmd>& GetRedisCmdList() const
+    {
+        return m_vecPipelineRedisCmd;
+    }
+
+    inline int GetRedisCmdCount() const
+    {
+        return static_cast<int>(m_vecPipelineRedisCmd.size());
+    }
+
+    // Clear every queued cmd
+    void Clear();
+
+    //////////////////////////////////////////////////////////////////////////
+    /// Begin of RedisCmd
+    void DEL(const std::string& strKey);
+    void EXPIRE(const std::string& strKey, int nSeconds);
+    void PEXPIRE(const std::string& strKey, int nMS);
+    void GET(const std::string& strKey);
+    void SET(const std::string& strKey, const std::string& strValue);
+    void INCRBY(const std::string& strKey, int nIncrement);
+    void HDEL(const std::string& strKey, const std::string& strField);
+    void HGET(const std::string& strKey, const std::string& strField);
+    void HSET(const std::string& strKey, const std::string& strField, const std::string& strValue);
+    void HINCRBY(const std::string& strKey, const std::string& strField, int nIncVal);
+    /// End of RedisCmd
+    //////////////////////////////////////////////////////////////////////////
+
+private:
+    std::vector<PipelineRedisCmd> m_vecPipelineRedisCmd;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define RedisSessionPool, share cluster topology and lend session of every redis node to CFlyRedisClient of many threads
+class CFlyRedisSessionPool
+{
+public:
+    // Constructor
+    CFlyRedisSessionPool();
+
+    // Destructor
+    ~CFlyRedisSessionPool();
+
+    // Set redis config, they should be called before Open
+    void SetRedisConfig(const std::string& strHost, int nPort, const std::string& strPassword);
+    void SetReadTimeoutMS(int nMS);
+    void SetRedisReadWriteType(FlyRedisReadWriteType nFlyRedisReadWriteType);
+    void SetRedisClusterDetectType(FlyRedisClusterDetectType nFlyRedisClusterDetectType);
+    void SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName);
+    bool SetTLSContext(const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert, const std::string& strTLSCACertDir);
+
+    // Open creates nMinSessionCount sessions of every node, a node has no more than nMaxSessionCount sessions, include the leased ones
+    void SetSessionCountPerNode(int nMinSessionCount, int nMaxSessionCount);
+
+    // Open this pool
+    bool Open();
+
+    // Close this pool, the leased session is closed when it is returned
+    void Close();
+
+    // Get ClusterFlag
+    inline bool GetClusterFlag() const
+    {
+        return m_bClusterFlag;
+    }
+
+    // Return address of the redis node which owns nSlot, nSlot less than 0 means the node used by Open
+    std::string ResolveRedisNode(int nSlot, bool bIsWrite);
+
+    // Lease a session of the redis node, wait if the node has max session and none of them is idle.
+    // Return nullptr if connect failed or no session is returned in read timeout
+    CFlyRedisSession* LeaseRedisSession(const std::string& strRedisAddress);
+
+    // Return the leased session, it is closed if it is broken
+    void ReturnRedisSession(CFlyRedisSession* pRedisSession);
+
+    // Slot has been moved to strRedisAddress, it is found by MOVED response
+    void MoveRedisSlot(int nSlot, const std::string& strRedisAddress);
+
+    // Session count of every node, include the leased ones
+    int GetRedisSessionCount();
+
+    // Fetch address of every node in pool
+    void FetchRedisNodeList(std::vector<std::string>& vecRedisNodeList);
+
+    // Fill connect and reconnect count of every node connected by this pool, other fields are not changed
+    void FetchNodeConnectStats(std::map<std::string, FlyRedisNodeStats>& mapNodeStats);
+
+private:
+    // Pooled session has its own io context, so it is run only by the thread which leases it
+    struct PoolRedisSession
+    {
+#ifdef FLY_REDIS_ENABLE_TLS
+        PoolRedisSession(bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext)
+            :hRedisSession(boostIOContext, bUseTLSFlag, boostTLSContext)
+        {
+        }
+#else
+        PoolRedisSession()
+            :hRedisSession(boostIOContext)
+        {
+        }
+#endif // FLY_REDIS_ENABLE_TLS
+        boost::asio::io_context boostIOContext;
+        CFlyRedisSession hRedisSession;
+    };
+
+    // Define session list of one redis node
+    struct RedisNodePool
+    {
+        bool bReadOnly = false;
+        // Idle and leased session count
+        int nSessionCount = 0;
+        std::vector<PoolRedisSession*> vecIdleSession;
+    };
+
+    // Define connect count of one redis node, session created after a broken session was destroyed is a reconnect
+    struct NodeConnectStats
+    {
+        unsigned long long nConnectCount = 0;
+        unsigned long long nReconnectCount = 0;
+        int nBrokenSessionCount = 0;
+    };
+
+    // Create a connected session, return nullptr if failed
+    PoolRedisSession* CreatePoolRedisSession(const std::string& strRedisAddress, bool bReadOnly);
+
+    // Create min session of every node, every node is connected by its own thread
+    void WarmUpRedisNode();
+
+private:
+#ifdef FLY_REDIS_ENABLE_TLS
+    bool m_bUseTLSFlag = false;
+    boost::asio::ssl::context m_boostTLSContext{ boost::asio::ssl::context::sslv23_client };
+#endif // FLY_REDIS_ENABLE_TLS
+    int m_nReadTimeoutMS = 5000;
+    std::set<std::string> m_setRedisAddressSeed;
+    FlyRedisHandshakeConfig m_stHandshakeConfig;
+    FlyRedisClusterDetectType m_nFlyRedisClusterDetectType = FlyRedisClusterDetectType::AutoDetect;
+    FlyRedisReadWriteType m_nFlyRedisReadWriteType = FlyRedisReadWriteType::ReadWriteOnMaster;
+    int m_nMinSessionCount = 1;
+    int m_nMaxSessionCount = 8;
+    bool m_bClusterFlag = false;
+    //////////////////////////////////////////////////////////////////////////
+    // Data below is protected by m_mutexPool
+    std::mutex m_mutexPool;
+    // Notified when a session is returned
+    std::condition_variable m_cvPool;
+    // Address of the node used by Open
+    std::string m_strRedisAddress;
+    FlyRedisClusterTopology m_stClusterTopology;
+    // Key: redis address, ip:port
+    std::map<std::string, RedisNodePool> m_mapRedisNodePool;
+    // Key: leased session
+    std::map<CFlyRedisSession*, PoolRedisSession*> m_mapLeasedRedisSession;
+    // Key: redis address, it is kept by Close
+    std::map<std::string, NodeConnectStats> m_mapNodeConnectStats;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define RedisMultiplexSession, cmd of many threads are queued and sent on one session by its IO thread, the response is matched in FIFO order.
+// It connects to one redis node, MOVED and ASK response is returned as error response
+class CFlyRedisMultiplexSession
+{
+public:
+    // Constructor
+    CFlyRedisMultiplexSession();
+
+    // Destructor
+    ~CFlyRedisMultiplexSession();
+
+    // Set redis config, they should be called before Open
+    void SetRedisConfig(const std::string& strHost, int nPort, const std::string& strPassword);
+    void SetReadTimeoutMS(int nMS);
+    void SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName);
+    bool SetTLSContext(const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert, const std::string& strTLSCACertDir);
+
+    // Connect to redis node and start IO thread
+    bool Open();
+
+    // Stop IO thread after every queued cmd is done, it should be called after every thread stops running cmd
+    void Close();
+
+    // Run one cmd, it can be called by any thread, and it is sent with cmd of other threads in one write
+    bool RunRedisCmd(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, FlyRedisPipelineResponse& stPipelineResponse);
+
+    // Run every cmd of hPipeline in order, strKey of cmd is not used
+    bool ExecPipeline(const CFlyRedisPipeline& hPipeline, std::vector<FlyRedisPipelineResponse>& vecResponse);
+
+private:
+    // Define queued cmd, it is owned by the thread which runs it, and is linked by lock free queue
+    struct MultiplexRedisCmd
+    {
+        std::string strRedisCmdRequest;
+        FlyRedisPipelineResponse stPipelineResponse;
+        std::promise<bool> promiseResult;
+        MultiplexRedisCmd* pNext = nullptr;
+    };
+
+    // Push cmd into lock free queue, wake up IO thread if the queue was empty
+    void SubmitRedisCmd(MultiplexRedisCmd* pRedisCmd);
+
+    // Take every submitted cmd, the list is in submitted order
+    MultiplexRedisCmd* TakeSubmittedRedisCmd();
+
+    // Write cmd list in one request, the sent cmd is appended into dequeSentRedisCmd
+    void SendRedisCmdList(MultiplexRedisCmd* pRedisCmdList, std::deque<MultiplexRedisCmd*>& dequeSentRedisCmd);
+
+    // Set result of cmd, the cmd should not be touched after it
+    void FinishRedisCmd(MultiplexRedisCmd* pRedisCmd, bool bResult);
+
+    // Create a connected session, return nullptr if failed
+    CFlyRedisSession* CreateRedisSession();
+
+    void RunIOThread();
+
+private:
+#ifdef FLY_REDIS_ENABLE_TLS
+    bool m_bUseTLSFlag = false;
+    boost::asio::ssl::context m_boostTLSContext{ boost::asio::ssl::context::sslv23_client };
+#endif // FLY_REDIS_ENABLE_TLS
+    boost::asio::io_context m_boostIOContext;
+    std::string m_strRedisAddress;
+    int m_nReadTimeoutMS = 5000;
+    FlyRedisHandshakeConfig m_stHandshakeConfig;
+    // Session is used by IO thread only after Open
+    CFlyRedisSession* m_pRedisSession = nullptr;
+    std::string m_strRedisCmdRequest;
+    std::thread m_hIOThread;
+    std::atomic<bool> m_bRunning;
+    // Head of lock free queue, the latest submitted cmd is the head
+    std::atomic<MultiplexRedisCmd*> m_pSubmittedRedisCmd;
+    // IO thread waits on it when there is no cmd
+    std::mutex m_mutexIOThread;
+    std::condition_variable m_cvIOThread;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Define RedisAsyncSession, run cmd in async mode on the io context of caller, many cmd are in flight on one connection.
+// It is not thread safe, it should be used in the thread which runs the io context.
+// Close it and let the io context run the aborted handlers before it is destroyed
+// The async function takes asio completion token, such as a callback, boost::asio::use_future, the error code is set if network failed
+class CFlyRedisAsyncSession
+{
+public:
+    // Constructor
+#ifdef FLY_REDIS_ENABLE_TLS
+    CFlyRedisAsyncSession(boost::asio::io_context& boostIOContext, bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext);
+#else
+    explicit CFlyRedisAsyncSession(boost::asio::io_context& boostIOContext);
+#endif // FLY_REDIS_ENABLE_TLS
+
+    // Destructor, every pending cmd gets operation_aborted, the session can be deleted in handler or with pending handler
+    ~CFlyRedisAsyncSession();
+
+    // Set redis config, they should be called before AsyncOpen, read timeout is the timeout of connect
+    void SetRedisConfig(const std::string& strHost, int nPort, const std::string& strPassword);
+    void SetReadTimeoutMS(int nMS);
+    void SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName);
+
+    // Connect and run AUTH, HELLO, CLIENT SETNAME by handshake config, cmd can be queued before it is done
+    template <typename CompletionToken>
+    BOOST_ASIO_INITFN_RESULT_TYPE(CompletionToken, void(boost::system::error_code)) AsyncOpen(CompletionToken&& token)
+    {
+        return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code)>(InitiateOpen(this), token);
+    }
+
+    // Run one cmd, the response is passed to the handler in the order of cmd
+    template <typename CompletionToken>
+    BOOST_ASIO_INITFN_RESULT_TYPE(CompletionToken, void(boost::system::error_code, FlyRedisPipelineResponse)) AsyncRunRedisCmd(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, CompletionToken&& token)
+    {
+        return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, FlyRedisPipelineResponse)>(InitiateRunRedisCmd(this), token, bIsWrite, vecRedisCmdParamList);
+    }
+
+    // Run every cmd of hPipeline, strKey of cmd is not used
+    template <typename CompletionToken>
+    BOOST_ASIO_INITFN_RESULT_TYPE(CompletionToken, void(boost::system::error_code, std::vector<FlyRedisPipelineResponse>)) AsyncExecPipeline(const CFlyRedisPipeline& hPipeline, CompletionToken&& token)
+    {
+        return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, std::vector<FlyRedisPipelineResponse>)>(InitiateExecPipeline(this), token, hPipeline);
+    }
+
+    // Close connection, every pending cmd gets operation_aborted
+    void Close();
+
+    inline bool IsOpen() const
+    {
+        return m_bOpen;
+    }
+
+    // Cmd which has been queued but its response is not received
+    inline int GetPendingRedisCmdCount() const
+    {
+        return static_cast<int>(m_dequeRedisCmdHandler.size());
+    }
+
+private:
+    using FlyRedisAsyncOpenHandler = std::function<void(const boost::system::error_code&)>;
+    using FlyRedisAsyncCmdHandler = std::function<void(const boost::system::error_code&, FlyRedisPipelineResponse&)>;
+    using FlyRedisAsyncPipelineHandler = std::function<void(const boost::system::error_code&, std::vector<FlyRedisPipelineResponse>&)>;
+
+    // Initiation of async function, the handler is kept by shared_ptr, so move only handler can be stored in std::function
+    struct InitiateOpen
+    {
+        explicit InitiateOpen(CFlyRedisAsyncSession* pAsyncSession)
+            :pAsyncSession(pAsyncSession)
+        {
+        }
+        template <typename Handler>
+        void operator()(Handler&& hHandler) const
+        {
+            std::shared_ptr<typename std::decay<Handler>::type> pHandler = std::make_shared<typename std::decay<Handler>::type>(std::forward<Handler>(hHandler));
+            pAsyncSession->StartOpen([pHandler](const boost::system::error_code& boostErrorCode) { (*pHandler)(boostErrorCode); });
+        }
+        CFlyRedisAsyncSession* pAsyncSession;
+    };
+
+    struct InitiateRunRedisCmd
+    {
+        explicit InitiateRunRedisCmd(CFlyRedisAsyncSession* pAsyncSession)
+            :pAsyncSession(pAsyncSession)
+        {
+        }
+        template <typename Handler>
+        void operator()(Handler&& hHandler, bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList) const
+        {
+            std::shared_ptr<typename std::decay<Handler>::type> pHandler = std::make_shared<typename std::decay<Handler>::type>(std::forward<Handler>(hHandler));
+            pAsyncSession->SubmitRedisCmd(bIsWrite, vecRedisCmdParamList, [pHandler](const boost::system::error_code& boostErrorCode, FlyRedisPipelineResponse& stPipelineResponse) {
+                (*pHandler)(boostErrorCode, std::move(stPipelineResponse));
+            });
+        }
+        CFlyRedisAsyncSession* pAsyncSession;
+    };
+
+    struct InitiateExecPipeline
+    {
+        explicit InitiateExecPipeline(CFlyRedisAsyncSession* pAsyncSession)
+            :pAsyncSession(pAsyncSession)
+        {
+        }
+        template <typename Handler>
+        void operator()(Handler&& hHandler, const CFlyRedisPipeline& hPipeline) const
+        {
+            std::shared_ptr<typename std::decay<Handler>::type> pHandler = std::make_shared<typename std::decay<Handler>::type>(std::forward<Handler>(hHandler));
+            pAsyncSession->SubmitPipeline(hPipeline, [pHandler](const boost::system::error_code& boostErrorCode, std::vector<FlyRedisPipelineResponse>& vecResponse) {
+                (*pHandler)(boostErrorCode, std::move(vecResponse));
+            });
+        }
+        CFlyRedisAsyncSession* pAsyncSession;
+    };
+
+    void StartOpen(const FlyRedisAsyncOpenHandler& fnOpenHandler);
+    void SubmitRedisCmd(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, const FlyRedisAsyncCmdHandler& fnCmdHandler);
+    void SubmitPipeline(const CFlyRedisPipeline& hPipeline, const FlyRedisAsyncPipelineHandler& fnPipelineHandler);
+
+    // Queue handshake cmd before every queued cmd when connect is done
+    void HandleConnect(bool bConnected);
+    void HandleHandshakeResponse(FlyRedisPipelineResponse& stPipelineResponse, const std::string& strCmd, bool bLastCmd);
+    void FinishOpen(const boost::system::error_code& boostErrorCode);
+
+    // Write queued request if no write is in flight
+    void StartWrite();
+    void HandleWrite(bool bWriteResult);
+
+    // Parse every complete response in recv buff, and pass it to the handler of the oldest cmd
+    void HandleRead(bool bReadResult);
+
+    // Restart the deadline of the oldest cmd when a response is received, it is stopped when no cmd is pending
+    void StartResponseTimer();
+    void StopResponseTimer();
+    void HandleResponseTimeout(const boost::system::error_code& boostErrorCode, unsigned int nResponseTimerSeq);
+
+    // Close connection and pass boostErrorCode to every pending cmd
+    void FailEveryRedisCmd(const boost::system::error_code& boostErrorCode);
+
+    // Post handler to io context, handler should not be called in the async function which initiates it
+    void PostRedisCmdHandler(const FlyRedisAsyncCmdHandler& fnCmdHandler, const boost::system::error_code& boostErrorCode);
+
+private:
+    boost::asio::io_context& m_boostIOContext;
+    std::string m_strRedisAddress;
+    FlyRedisHandshakeConfig m_stHandshakeConfig;
+    CFlyRedisNetStream m_hNetStream;
+    CFlyRedisRESPParser m_hRESPParser;
+    FlyRedisResponse m_stRedisResponse;
+    CFlyRedisResponseBuilder m_hResponseBuilder;
+    bool m_bOpening = false;
+    bool m_bOpen = false;
+    FlyRedisAsyncOpenHandler m_fnOpenHandler;
+    // Request which is waiting for write, and the one which is being written
+    std::string m_strPendingRequest;
+    std::string m_strWritingRequest;
+    bool m_bWriting = false;
+    // Handler of every queued cmd, in the order of cmd, the front one gets the next response
+    std::deque<FlyRedisAsyncCmdHandler> m_dequeRedisCmdHandler;
+    // Deadline of response, the read timeout of net stream is used
+    boost::asio::steady_timer m_boostResponseTimer;
+    unsigned int m_nResponseTimerSeq = 0;
+    bool m_bResponseTimerRunning = false;
+    // Timer handler holds it weakly, so the session can be destroyed with pending handler
+    std::shared_ptr<bool> m_pAliveToken = std::make_shared<bool>(true);
+};
+
+#ifdef FLY_REDIS_ENABLE_COROUTINE
+//////////////////////////////////////////////////////////////////////////
+// Define RedisCoroutineClient, co_await version of cmd, it runs on CFlyRedisAsyncSession.
+// It needs C++20, and the coroutine should be spawned on the io context of the session.
+// Result is filled like CFlyRedisClient, false is returned if the cmd failed or redis replied an error
+class CFlyRedisCoroutineClient
 {
-    ReadWriteOnMaster = 1,  // Default
-    ReadOnSlaveWriteOnMaster = 2,
-};
+public:
+    // Constructor
+    explicit CFlyRedisCoroutineClient(CFlyRedisAsyncSession& hAsyncSession);
+
+    // Open async session
+    boost::asio::awaitable<bool> Open();
+
+    // Run any cmd, or every cmd of hPipeline
+    boost::asio::awaitable<bool> RunRedisCmd(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, FlyRedisPipelineResponse& stPipelineResponse);
+    boost::asio::awaitable<bool> ExecPipeline(const CFlyRedisPipeline& hPipeline, std::vector<FlyRedisPipelineResponse>& vecResponse);
+
+    // Key
+    boost::asio::awaitable<bool> DEL(const std::string& strKey, int& nResult);
+    boost::asio::awaitable<bool> EXISTS(const std::string& strKey, int& nResult);
+    boost::asio::awaitable<bool> EXPIRE(const std::string& strKey, int nSeconds, int& nResult);
+    boost::asio::awaitable<bool> TTL(const std::string& strKey, int& nResult);
+
+    // String
+    boost::asio::awaitable<bool> GET(const std::string& strKey, std::string& strResult);
+    boost::asio::awaitable<bool> SET(const std::string& strKey, const std::string& strValue);
+    boost::asio::awaitable<bool> SETEX(const std::string& strKey, int nTimeOutSeconds, const std::string& strValue, std::string& strResult);
+    boost::asio::awaitable<bool> INCR(const std::string& strKey, int& nResult);
+    boost::asio::awaitable<bool> INCRBY(const std::string& strKey, int nIncrement, int& nResult);
+    boost::asio::awaitable<bool> MGET(const std::vector<std::string>& vecKey, std::vector<std::string>& vecResult);
+
+    // Hash
+    boost::asio::awaitable<bool> HGET(const std::string& strKey, const std::string& strField, std::string& strResult);
+    boost::asio::awaitable<bool> HSET(const std::string& strKey, const std::string& strField, const std::string& strValue, int& nResult);
+    boost::asio::awaitable<bool> HDEL(const std::string& strKey, const std::string& strField, int& nResult);
+    boost::asio::awaitable<bool> HINCRBY(const std::string& strKey, const std::string& strField, int nIncVal, int& nResult);
+    boost::asio::awaitable<bool> HGETALL(const std::string& strKey, std::map<std::string, std::string>& mapFieldValue);
+
+    // List
+    boost::asio::awaitable<bool> LPUSH(const std::string& strKey, const std::string& strValue, int& nResult);
+    boost::asio::awaitable<bool> RPUSH(const std::string& strKey, const std::string& strValue, int& nResult);
+    boost::asio::awaitable<bool> LPOP(const std::string& strKey, std::string& strResult);
+    boost::asio::awaitable<bool> RPOP(const std::string& strKey, std::string& strResult);
+    boost::asio::awaitable<bool> LRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult);
+
+    // Set
+    boost::asio::awaitable<bool> SADD(const std::string& strKey, const std::string& strValue, int& nResult);
+    boost::asio::awaitable<bool> SREM(const std::string& strKey, const std::string& strValue, int& nResult);
+    boost::asio::awaitable<bool> SMEMBERS(const std::string& strKey, std::set<std::string>& setResult);
+
+    // SortedSet
+    boost::asio::awaitable<bool> ZADD(const std::string& strKey, double fScore, const std::string& strMember, int& nResult);
+    boost::asio::awaitable<bool> ZSCORE(const std::string& strKey, const std::string& strMember, double& fResult);
+    boost::asio::awaitable<bool> ZRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult);
+
+    // Publish
+    boost::asio::awaitable<bool> PUBLISH(const std::string& strChannel, const std::string& strMsg, int& nResult);
 
-enum class FlyRedisClusterDetectType : int
-{
-    AutoDetect = 1,         // Default
-    EnableCluster = 2,
-    DisableCluster = 3,
+private:
+    boost::asio::awaitable<bool> RunRedisCmdOnResponseString(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::string& strResult);
+    boost::asio::awaitable<bool> RunRedisCmdOnResponseInt(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, int& nResult);
+    boost::asio::awaitable<bool> RunRedisCmdOnResponseDouble(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, double& fResult);
+    boost::asio::awaitable<bool> RunRedisCmdOnResponseVector(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::vector<std::string>& vecResult);
+    boost::asio::awaitable<bool> RunRedisCmdOnResponseSet(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::set<std::string>& setResult);
+    boost::asio::awaitable<bool> RunRedisCmdOnResponseKVP(bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, std::map<std::string, std::string>& mapResult);
+
+private:
+    CFlyRedisAsyncSession& m_hAsyncSession;
 };
+#endif // FLY_REDIS_ENABLE_COROUTINE
 
 //////////////////////////////////////////////////////////////////////////
-// Define FlyRedisSession, Describe TCP session to one redis server node.
-struct FlyRedisResponse
+// Define CmdName, RESP of cmd name and sub cmd name, such as "$3\r\nGET\r\n", it is built once and shared by every cmd
+class CFlyRedisCmdName
 {
-    FlyRedisResponse()
+public:
+    explicit CFlyRedisCmdName(const char* pszCmdName, const char* pszSubCmdName = nullptr);
+
+    inline const std::string& GetPrefix() const
     {
+        return m_strPrefix;
     }
 
-    inline void Reset()
+    inline size_t GetParamCount() const
     {
-        strRedisResponse.clear();
-        vecRedisResponse.clear();
-        mapRedisResponse.clear();
-        setRedisResponse.clear();
+        return m_nParamCount;
     }
 
-    std::string strRedisResponse;
-    std::vector<std::string> vecRedisResponse;
-    std::map<std::string, std::string> mapRedisResponse;
-    std::set<std::string> setRedisResponse;
+private:
+    std::string m_strPrefix;
+    size_t m_nParamCount = 0;
 };
 
-class CFlyRedisSession
+//////////////////////////////////////////////////////////////////////////
+// Define CmdEncoder, encode cmd into RESP without allocation of param, param can be string, integer, double or std::vector<std::string>
+class CFlyRedisCmdEncoder
 {
 public:
-    // Constructor
-#ifdef FLY_REDIS_ENABLE_TLS
-    CFlyRedisSession(boost::asio::io_context& boostIOContext, bool bUseTLSFlag, boost::asio::ssl::context& boostTLSContext);
-#else
-    CFlyRedisSession(boost::asio::io_context& boostIOContext);
-#endif // FLY_REDIS_ENABLE_TLS
-
-    // Destructor
-    ~CFlyRedisSession();
-
-    // Set redis address
-    void SetRedisAddress(const std::string& strAddress);
-
-    // Set read timeout seconds
-    inline void SetReadTimeoutSeconds(int nSeconds)
+    // Encode one cmd and append it to strOutput, strOutput is reserved once and keeps its capacity for the next cmd
+    template <typename... TParams>
+    static void AppendRedisCmd(std::string& strOutput, const CFlyRedisCmdName& hCmdName, const TParams&... params)
     {
-        m_hNetStream.SetReadTimeoutSeconds(nSeconds);
+        AppendCmd(strOutput, nullptr, hCmdName, params...);
     }
 
-    // Get redis address
-    const std::string& GetRedisAddr() const;
-
-    // Connect to redis node
-    bool Connect();
-
-    // Return true if accept this slot
-    bool AcceptHashSlot(int nSlot, bool bIsWrite, FlyRedisReadWriteType nFlyRedisReadWriteType) const;
-
-    // Set self slot range
-    void SetSelfSlotRange(int nMinSlot, int nMaxSlot);
-
-    // Set master flag
-    inline void SetMasterNodeFlag(bool bFlag)
+    // Encode one cmd like AppendRedisCmd, but string param which is not shorter than FLY_REDIS_GATHER_PARAM_LEN is appended into vecGatherParam instead of copied.
+    // strOutput and vecGatherParam are sent by gathered write of CFlyRedisNetStream
+    template <typename... TParams>
+    static void AppendGatherRedisCmd(std::string& strOutput, std::vector<FlyRedisGatherParam>& vecGatherParam, const CFlyRedisCmdName& hCmdName, const TParams&... params)
     {
-        m_bIsMasterNode = bFlag;
+        AppendCmd(strOutput, &vecGatherParam, hCmdName, params...);
     }
 
-    // Process redis cmd request
-    bool ProcRedisRequest(const std::string& strRedisCmdRequest);
-
-    // Try send/recv redis response
-    bool TrySendRedisRequest(const std::string& strRedisCmdRequest);
-    bool TryRecvRedisResponse(int nBlockMS);
+    // Append header of RESP, such as "$5\r\n"
+    static void AppendHeader(std::string& strOutput, char chType, size_t nLen);
 
-    // Return true if resolve server version success
-    bool ResolveServerVersion();
-
-    // Get RESP Version
-    inline int GetRESPVersion() const
+private:
+    template <typename... TParams>
+    static void AppendCmd(std::string& strOutput, std::vector<FlyRedisGatherParam>* pVecGatherParam, const CFlyRedisCmdName& hCmdName, const TParams&... params)
     {
-        return m_nRESPVersion;
+        strOutput.reserve(strOutput.length() + 16 + hCmdName.GetPrefix().length() + GetMaxEncodeLen(pVecGatherParam, params...));
+        AppendHeader(strOutput, '*', hCmdName.GetParamCount() + GetParamCount(params...));
+        strOutput.append(hCmdName.GetPrefix());
+        AppendParam(strOutput, pVecGatherParam, params...);
     }
 
-    // Return true if cluster enable
-    bool GetClusterEnabledFlag();
-
-    inline void ResetRedisResponse()
+    static inline bool IsGatherParam(const std::vector<FlyRedisGatherParam>* pVecGatherParam, const boost::string_view& strParam)
     {
-        m_stRedisResponse.Reset();
+        return nullptr != pVecGatherParam && strParam.size() >= FLY_REDIS_GATHER_PARAM_LEN;
     }
 
-    inline std::string& GetRedisResponseString()
+    static inline size_t GetParamCount()
     {
-        return m_stRedisResponse.strRedisResponse;
+        return 0;
     }
 
-    inline std::vector<std::string>& GetRedisResponseVector()
+    template <typename TParam, typename... TParams>
+    static inline size_t GetParamCount(const TParam& param, const TParams&... params)
     {
-        return m_stRedisResponse.vecRedisResponse;
+        return GetOneParamCount(param) + GetParamCount(params...);
     }
 
-    inline std::set<std::string>& GetRedisResponseSet()
+    template <typename TParam>
+    static inline size_t GetOneParamCount(const TParam& /*param*/)
     {
-        return m_stRedisResponse.setRedisResponse;
+        return 1;
     }
 
-    inline std::map<std::string, std::string>& GetRedisResponseMap()
+    static inline size_t GetOneParamCount(const std::vector<std::string>& vecParam)
     {
-        return m_stRedisResponse.mapRedisResponse;
+        return vecParam.size();
     }
 
-    inline const char* GetLastResponseErrorMsgCStr() const
+    static inline size_t GetMaxEncodeLen(const std::vector<FlyRedisGatherParam>* /*pVecGatherParam*/)
     {
-        return m_strLastResponseErrorMsg.c_str();
+        return 0;
     }
 
-    std::string GetLastFullResponseString() const;
+    template <typename TParam, typename... TParams>
+    static inline size_t GetMaxEncodeLen(const std::vector<FlyRedisGatherParam>* pVecGatherParam, const TParam& param, const TParams&... params)
+    {
+        return GetOneMaxEncodeLen(pVecGatherParam, param) + GetMaxEncodeLen(pVecGatherParam, params...);
+    }
 
-    inline const std::string& GetLocalIP() const
+    // Header and tail CRLF of one param is 16 bytes at most
+    template <typename TParam>
+    static inline typename std::enable_if<std::is_arithmetic<TParam>::value, size_t>::type GetOneMaxEncodeLen(const std::vector<FlyRedisGatherParam>* /*pVecGatherParam*/, TParam /*nParam*/)
     {
-        return m_hNetStream.GetLocalIP();
+        return 48;
     }
 
-    //////////////////////////////////////////////////////////////////////////
-    /// Begin of RedisCmd
-    bool AUTH(const std::string& strPassword);
-    bool PING();
-    bool READONLY();
-    bool INFO(const std::string& strSection, std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo);
-    bool CLUSTER_NODES(std::vector<std::string>& vecResult);
-    bool SCRIPT_LOAD(const std::string& strScript, std::string& strResult);
-    bool SCRIPT_FLUSH();
-    bool SCRIPT_EXISTS(const std::string& strSHA);
-    bool HELLO(int nVersion);
-    bool HELLO_AUTH_SETNAME(int nVersion, const std::string& strUserName, const std::string& strPassword, const std::string& strClientName);
-    /// End of RedisCmd
-    //////////////////////////////////////////////////////////////////////////
+    static inline size_t GetOneMaxEncodeLen(const std::vector<FlyRedisGatherParam>* pVecGatherParam, const boost::string_view& strParam)
+    {
+        return IsGatherParam(pVecGatherParam, strParam) ? 16 : strParam.size() + 16;
+    }
 
-private:
-    // Recv redis response
-    bool RecvRedisResponse();
-    bool ReadRedisResponseError();
-    bool ReadRedisResponseSimpleStrings();
-    bool ReadRedisResponseIntegers();
-    bool ReadRedisResponseBulkStrings();
-    bool ReadRedisResponseArrays();
-    bool ReadRedisResponseMap();
-    bool ReadRedisResponseDouble();
-    bool ReadRedisResponseNull();
-    bool ReadRedisResponseBoolean();
-    bool ReadRedisResponseBlobError();
-    bool ReadRedisResponseVerbatimString();
-    bool ReadRedisResponseBigNumber();
-    bool ReadRedisResponseSet();
-    bool ReadRedisResponseAttribute();
+    static size_t GetOneMaxEncodeLen(const std::vector<FlyRedisGatherParam>* pVecGatherParam, const std::vector<std::string>& vecParam);
 
-    // Return true if RedisServer Support this cmd
-    bool VerifyRedisServerVersion6(const char* pszCmdName) const;
+    static inline void AppendParam(std::string& /*strOutput*/, std::vector<FlyRedisGatherParam>* /*pVecGatherParam*/)
+    {
+    }
 
-    // Read one line from socket
-    bool ReadUntilCRLF();
+    template <typename TParam, typename... TParams>
+    static inline void AppendParam(std::string& strOutput, std::vector<FlyRedisGatherParam>* pVecGatherParam, const TParam& param, const TParams&... params)
+    {
+        AppendOneParam(strOutput, pVecGatherParam, param);
+        AppendParam(strOutput, pVecGatherParam, params...);
+    }
 
-    bool ReadRedisResponseVarLenString();
+    template <typename TParam>
+    static inline typename std::enable_if<std::is_integral<TParam>::value>::type AppendOneParam(std::string& strOutput, std::vector<FlyRedisGatherParam>* /*pVecGatherParam*/, TParam nParam)
+    {
+        char szParam[32];
+        size_t nLen = std::is_signed<TParam>::value ? CFlyRedisNumberCodec::EncodeInt(szParam, static_cast<long long>(nParam)) : CFlyRedisNumberCodec::EncodeUInt(szParam, static_cast<unsigned long long>(nParam));
+        AppendHeader(strOutput, '$', nLen);
+        strOutput.append(szParam, nLen).append("\r\n", 2);
+    }
 
-    std::string& TrimLastChar(std::string& strValue, size_t nTrimCount) const;
+    template <typename TParam>
+    static inline typename std::enable_if<std::is_floating_point<TParam>::value>::type AppendOneParam(std::string& strOutput, std::vector<FlyRedisGatherParam>* /*pVecGatherParam*/, TParam fParam)
+    {
+        char szParam[32];
+        size_t nLen = CFlyRedisNumberCodec::EncodeDouble(szParam, static_cast<double>(fParam));
+        AppendHeader(strOutput, '$', nLen);
+        strOutput.append(szParam, nLen).append("\r\n", 2);
+    }
 
-    std::string GetServerInfoSectionField(const std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo, const std::string& strSection, const std::string& strField);
+    static inline void AppendOneParam(std::string& strOutput, std::vector<FlyRedisGatherParam>* pVecGatherParam, const boost::string_view& strParam)
+    {
+        AppendHeader(strOutput, '$', strParam.size());
+        if (IsGatherParam(pVecGatherParam, strParam))
+        {
+            FlyRedisGatherParam stGatherParam;
+            stGatherParam.nOffset = strOutput.length();
+            stGatherParam.strParam = strParam;
+            pVecGatherParam->push_back(stGatherParam);
+        }
+        else
+        {
+            strOutput.append(strParam.data(), strParam.size());
+        }
+        strOutput.append("\r\n", 2);
+    }
 
-private:
-    // SlotRange
-    int m_nMinSlot = 0;
-    int m_nMaxSlot = 0;
-    bool m_bIsMasterNode = false;
-    //////////////////////////////////////////////////////////////////////////
-    // Network data member
-    CFlyRedisNetStream m_hNetStream;
-    bool m_bRedisResponseError = false;
-    std::string m_strLastResponseErrorMsg;
-    //////////////////////////////////////////////////////////////////////////
-    std::string m_strRedisVersion;
-    // Resp Version, default version was RESP2, if the server was greater than V6.0, it will be switched to RESP3
-    int m_nRESPVersion = 2;
-    //////////////////////////////////////////////////////////////////////////
-    // Last Response of this redis session
-    FlyRedisResponse m_stRedisResponse;
-};
-//////////////////////////////////////////////////////////////////////////
-using FlyRedisSubscribeResponse = struct FlyRedisSubscribeResponse;
-struct FlyRedisSubscribeResponse
-{
-    std::string strCmd;
-    std::string strChannel;
-    std::string strMsg;
-};
-using FlyRedisPMessageResponse = struct FlyRedisPMessageResponse;
-struct FlyRedisPMessageResponse
-{
-    std::string strCmd;
-    std::string strPattern;
-    std::string strChannel;
-    std::string strMsg;
+    static void AppendOneParam(std::string& strOutput, std::vector<FlyRedisGatherParam>* pVecGatherParam, const std::vector<std::string>& vecParam);
 };
+
 //////////////////////////////////////////////////////////////////////////
 // Define RedisClient, Describe full connection to redis server, it will connect to every redis master node
 class CFlyRedisClient
@@ -352,9 +1872,22 @@ public:
     // Set redis config, address as 127.0.0.1:6789
     void SetRedisConfig(const std::string& strHost, int nPort, const std::string& strPassword);
     void SetReadTimeoutSeconds(int nSeconds);
+    void SetReadTimeoutMS(int nMS);
     void SetRedisReadWriteType(FlyRedisReadWriteType nFlyRedisReadWriteType);
     void SetRedisClusterDetectType(FlyRedisClusterDetectType nFlyRedisClusterDetectType);
 
+    // Set HELLO and CLIENT SETNAME of handshake, they are sent with AUTH and INFO in one round trip when a session is connected.
+    // nRESPVersion 0 means HELLO is not sent, strUserName is used by AUTH for ACL of Redis 6.*
+    void SetHandshakeConfig(int nRESPVersion, const std::string& strUserName, const std::string& strClientName);
+
+    // Lease session from pool for every cmd instead of connecting by itself, the client is still used by one thread, and the pool is shared.
+    // It should be called before Open, SetRedisConfig is not needed, SUBSCRIBE is not supported in this mode
+    void SetRedisSessionPool(CFlyRedisSessionPool* pRedisSessionPool);
+
+    // Refresh cluster topology in background thread every nMS, and when a slot is moved, 0 means disabled.
+    // It should be called before Open, the logger handler will be called in the background thread too
+    void SetClusterTopologyRefreshMS(int nMS);
+
     // Set TLS config
     bool SetTLSContext(const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert);
     bool SetTLSContext(const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert, const std::string& strTLSCACertDir);
@@ -411,6 +1944,7 @@ public:
     bool ROLE(std::vector<std::string>& vecResult);
     bool DBSIZE(int& nResult);
     bool KEYS(const std::string& strMatchPattern, std::vector<std::string>& vecResult);
+    bool KEYS(const std::string& strMatchPattern, const FlyRedisElementVisitor& fnVisitor);
     bool SELECT(int nIndex);
 
     bool SCRIPT_LOAD(const std::string& strScript, std::string& strResult);
@@ -478,9 +2012,11 @@ public:
     bool HEXISTS(const std::string& strKey, const std::string& strField, int& nResult);
     bool HGET(const std::string& strKey, const std::string& strField, std::string& strResult);
     bool HGETALL(const std::string& strKey, std::map<std::string, std::string>& mapFieldValue);
+    bool HGETALL(const std::string& strKey, const FlyRedisKVPVisitor& fnVisitor);
     bool HINCRBY(const std::string& strKey, const std::string& strField, int nIncVal, int& nResult);
     bool HINCRBYFLOAT(const std::string& strKey, const std::string& strField, double fIncVal, double& fResult);
     bool HKEYS(const std::string& strKey, std::vector<std::string>& vecResult);
+    bool HKEYS(const std::string& strKey, const FlyRedisElementVisitor& fnVisitor);
     bool HLEN(const std::string& strKey, int& nResult);
     bool HMGET(const std::string& strKey, const std::string& strField, std::string& strValue);
     bool HMGET(const std::string& strKey, const std::vector<std::string>& vecField, std::vector<std::string>& vecOutput);
@@ -490,6 +2026,7 @@ public:
     bool HSETNX(const std::string& strKey, const std::string& strField, const std::string& strValue, int& nResult);
     bool HSTRLEN(const std::string& strKey, const std::string& strField, int& nResult);
     bool HVALS(const std::string& strKey, std::vector<std::string>& vecResult);
+    bool HVALS(const std::string& strKey, const FlyRedisElementVisitor& fnVisitor);
 
     bool ZADD(const std::string& strKey, double fScore, const std::string& strMember, int& nResult);
     bool ZADD(const std::string& strKey, unsigned long long nScore, const std::string& strMember, int& nResult);
@@ -497,10 +2034,12 @@ public:
     bool ZCOUNT(const std::string& strKey, const std::string& strMin, const std::string& strMax, int& nResult);
     bool ZINCRBY(const std::string& strKey, double fIncrement, const std::string& strMember, std::string& strResult);
     bool ZRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult);
+    bool ZRANGE(const std::string& strKey, int nStart, int nStop, const FlyRedisElementVisitor& fnVisitor);
     bool ZRANGE_WITHSCORES(const std::string& strKey, int nStart, int nStop, std::vector<std::pair<std::string, double> >& vecResult);
     bool ZRANGEBYSCORE(const std::string& strKey, int nMin, int nMax, std::vector<std::string>& vecResult);
     bool ZRANGEBYSCORE(const std::string& strKey, const std::string& strMin, const std::string& strMax, std::vector<std::string>& vecResult);
     bool ZREVRANGEBYSCORE(const std::string& strKey, int nMin, int nMax, std::vector<std::string>& vecResult);
+    // Return false if strMember is not in the sorted set, redis replies nil for it
     bool ZRANK(const std::string& strKey, const std::string& strMember, int& nResult);
     bool ZREM(const std::string& strKey, const std::string& strMember, int& nResult);
     bool ZREMRANGEBYSCORE(const std::string& strKey, double fFromScore, double fToScore, int& nResult);
@@ -526,6 +2065,7 @@ public:
     bool LPUSH(const std::string& strKey, const std::string& strValue, int& nResult);
     bool LPUSHX(const std::string& strKey, const std::string& strValue, int& nResult);
     bool LRANGE(const std::string& strKey, int nStart, int nStop, std::vector<std::string>& vecResult);
+    bool LRANGE(const std::string& strKey, int nStart, int nStop, const FlyRedisElementVisitor& fnVisitor);
     bool LREM(const std::string& strKey, int nCount, const std::string& strValue, int& nResult);
     bool LSET(const std::string& strKey, int nIndex, const std::string& strValue, std::string& strResult);
     bool LTRIM(const std::string& strKey, int nStart, int nStop, std::string& strResult);
@@ -544,6 +2084,7 @@ public:
     bool SINTERSTORE(const std::string& strDestKey, const std::vector<std::string>& vecSrcKey, int& nResult);
     bool SISMEMBER(const std::string& strKey, const std::string& strMember, int& nResult);
     bool SMEMBERS(const std::string& strKey, std::set<std::string>& setResult);
+    bool SMEMBERS(const std::string& strKey, const FlyRedisElementVisitor& fnVisitor);
     bool SMOVE(const std::string& strSrcKey, const std::string& strDestKey, const std::string& strMember, int& nResult);
     bool SPOP(const std::string& strKey, int nCount, std::vector<std::string>& vecResult);
     bool SRANDMEMBER(const std::string& strKey, int nCount, std::vector<std::string>& vecResult);
@@ -566,6 +2107,113 @@ public:
     /// End of RedisCmd
     //////////////////////////////////////////////////////////////////////////
 
+    // Decode reply directly into caller container, such as std::unordered_map, std::vector<std::pair<>>, std::vector<int64_t>.
+    // Container is cleared and reserved by the length header of reply, std::pair is decoded from field and value, or member and score in turn.
+    // Return false if a field is duplicate in map container
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool MGET(const std::vector<std::string>& vecKey, TContainer& hContainer)
+    {
+        if (!BuildMGETCmd(vecKey))
+        {
+            return false;
+        }
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(vecKey.front(), false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool HGETALL(const std::string& strKey, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("HGETALL");
+        EncodeRedisCmd(hCmdName, strKey);
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool HKEYS(const std::string& strKey, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("HKEYS");
+        EncodeRedisCmd(hCmdName, strKey);
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool HVALS(const std::string& strKey, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("HVALS");
+        EncodeRedisCmd(hCmdName, strKey);
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool LRANGE(const std::string& strKey, int nStart, int nStop, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("LRANGE");
+        EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool SMEMBERS(const std::string& strKey, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("SMEMBERS");
+        EncodeRedisCmd(hCmdName, strKey);
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool ZRANGE(const std::string& strKey, int nStart, int nStop, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("ZRANGE");
+        EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool ZRANGE_WITHSCORES(const std::string& strKey, int nStart, int nStop, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("ZRANGE");
+        EncodeRedisCmd(hCmdName, strKey, nStart, nStop, "WITHSCORES");
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool ZREVRANGE(const std::string& strKey, int nStart, int nStop, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("ZREVRANGE");
+        EncodeRedisCmd(hCmdName, strKey, nStart, nStop);
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    template <typename TContainer, typename = typename TContainer::value_type>
+    bool ZREVRANGE_WITHSCORES(const std::string& strKey, int nStart, int nStop, TContainer& hContainer)
+    {
+        static const CFlyRedisCmdName hCmdName("ZREVRANGE");
+        EncodeRedisCmd(hCmdName, strKey, nStart, nStop, "WITHSCORES");
+        CFlyRedisContainerDecoder<TContainer> hContainerDecoder(hContainer);
+        return RunRedisCmdOnElementDecoder(strKey, false, hContainerDecoder, __FUNCTION__);
+    }
+
+    // Run any cmd, the reply is built into typed tree which keeps nested aggregate, strKey decides the redis node.
+    // pReply is valid until the next RunRedisCmd, it is the error node if redis replied an error
+    bool RunRedisCmd(const std::string& strKey, bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, const FlyRedisReplyNode*& pReply);
+
+    // Same as RunRedisCmd, but string of reply points into recv buff without copy, use GetStringView to read it.
+    // It is valid until the next cmd of this client, it is not supported in session pool mode
+    bool RunRedisCmdOnReplyView(const std::string& strKey, bool bIsWrite, const std::vector<std::string>& vecRedisCmdParamList, const FlyRedisReplyNode*& pReply);
+
+    // Run every cmd of pipeline, cmd is grouped by redis node, and every node get its batch before recv any response.
+    // vecResponse has one response for each cmd in the queued order, return false if any cmd has no response, such cmd gets an error response
+    bool ExecPipeline(const CFlyRedisPipeline& hPipeline, std::vector<FlyRedisPipelineResponse>& vecResponse);
+
     // You should call PollSubscribeMsg/PollPSubscribeMsg after run SUBSCRIBE/PSUBSCRIBE
     bool PollSubscribeMsg(std::vector<FlyRedisSubscribeResponse>& vecResult, int nBlockMS);
     bool PollPSubscribeMsg(std::vector<FlyRedisPMessageResponse>& vecResult, int nBlockMS);
@@ -590,48 +2238,138 @@ public:
         return "";
     }
 
+    // Copy stats of every redis node and cmd, it does not stop recording, so it can be called periodically.
+    // In pool mode, connect and reconnect count is counted by the pool, which is shared by every client of it
+    void GetStatsSnapshot(FlyRedisStatsSnapshot& stStatsSnapshot) const;
+
+    // Reset every counter and histogram, such as after the snapshot has been reported, connect count of pool is not reset
+    void ResetStats();
+
 private:
     bool VerifyRedisSessionList();
 
     bool ResolveRedisSession(const std::string& strKey, bool bIsWrite);
 
-    // Define RedisClusterNodesLine
-    struct RedisClusterNodesLine
-    {
-        RedisClusterNodesLine();
-        bool ParseNodeLine(const std::string& strNodeLine);
-        std::string strNodeId;
-        std::string strNodeIPPort;
-        bool bIsMaster = false; // true: master, false: slave
-        std::string strMasterNodeId; // Only for slave node
-        int nMinSlot = 0;
-        int nMaxSlot = 0;
+    // Define batch of pipeline cmd on one redis node
+    // Config of new session, TLS context is not copied, it is loaded before Open and only read after that
+    struct RedisSessionConfig
+    {
+        FlyRedisHandshakeConfig stHandshakeConfig;
+        int nReadTimeoutMS = 5000;
+#ifdef FLY_REDIS_ENABLE_TLS
+        bool bUseTLSFlag = false;
+#endif // FLY_REDIS_ENABLE_TLS
+    };
+    struct RedisPipelineBatch
+    {
+        CFlyRedisSession* pRedisSession = nullptr;
+        bool bSendFlag = false;
+        std::string strRedisCmdRequest;
+        std::vector<int> vecCmdIndex;
+    };
+    // Define owner of one slot, slave session is used by ReadOnSlaveWriteOnMaster
+    struct RedisSlotOwner
+    {
+        CFlyRedisSession* pMasterSession = nullptr;
+        CFlyRedisSession* pSlaveSession = nullptr;
     };
-    using RedisClusterNodesLine = struct RedisClusterNodesLine;
     bool ConnectToEveryRedisNode();
-    bool ConnectToOneClusterNode(const RedisClusterNodesLine& stRedisNode);
+
+    // Connect to every redis node of topology, keep the existing session, and rebuild slot owner
+    bool ApplyClusterTopology(const std::shared_ptr<const FlyRedisClusterTopology>& pClusterTopology);
+
+    // Apply the topology which was published by refresh thread
+    void ApplyNewClusterTopology();
+
+    void StartClusterTopologyRefresh();
+    void StopClusterTopologyRefresh();
+    void NotifyClusterTopologyRefresh();
+    // Session config and seed are copied into the refresh thread, so it does not read config member which the client thread may set
+    void RunClusterTopologyRefresh(RedisSessionConfig stRedisSessionConfig, std::vector<std::string> vecRedisAddressSeed, std::shared_ptr<const FlyRedisClusterTopology> pClusterTopology);
+
+    // Lease session of pool for current cmd, the session which has been leased by current cmd is reused
+    CFlyRedisSession* LeasePoolRedisSession(const std::string& strRedisAddress);
+
+    // Return every session leased by current cmd
+    void ReturnPoolRedisSession();
+
+    // Fetch session of every node, they are leased from pool in pool mode
+    void FetchEveryRedisSession(std::vector<CFlyRedisSession*>& vecRedisSession);
+
+    // Return the leased session of pool when the cmd is done, it does nothing if the client does not use pool
+    struct PoolRedisSessionGuard
+    {
+        explicit PoolRedisSessionGuard(CFlyRedisClient& hRedisClient)
+            :hRedisClient(hRedisClient)
+        {
+        }
+        ~PoolRedisSessionGuard()
+        {
+            hRedisClient.ReturnPoolRedisSession();
+        }
+        CFlyRedisClient& hRedisClient;
+    };
+
+    // Copy config of new session from the client
+    RedisSessionConfig GetRedisSessionConfig() const;
+
+    // Create a connected redis session on boostIOContext, return nullptr if failed
+    CFlyRedisSession* ConnectRedisSession(boost::asio::io_context& boostIOContext, const RedisSessionConfig& stRedisSessionConfig, const std::string& strRedisAddress);
+
+    // Connect and handshake to every address at the same time, the failed one is nullptr in vecRedisSession.
+    // READONLY is sent to the session whose flag in vecReadOnlyFlag is true
+    void ConnectRedisSessionList(boost::asio::io_context& boostIOContext, const RedisSessionConfig& stRedisSessionConfig, const std::vector<std::string>& vecRedisAddress, const std::vector<bool>& vecReadOnlyFlag, std::vector<CFlyRedisSession*>& vecRedisSession);
 
     CFlyRedisSession* CreateRedisSession(const std::string& strRedisAddress);
 
     void DestroyRedisSession(const std::string& strIPPort);
     void DestroyRedisSession(CFlyRedisSession* pRedisSession);
 
+    // Record traffic of the new session into stats of its redis node, the node which has stats is reconnected
+    void AttachNodeStats(CFlyRedisSession* pRedisSession);
+
+    // Record one cmd into stats of pszCmdName
+    void RecordCmdStats(const char* pszCmdName, bool bResult, const std::chrono::steady_clock::time_point& tpBegin);
+
     void PingEveryRedisNode(std::vector<CFlyRedisSession*>& vecDeadRedisSession);
 
+    // Parse MOVED/ASK response, as: MOVED 3999 127.0.0.1:6381
+    bool ParseRedirectResponse(const std::string& strResponse, bool& bIsAsk, int& nSlot, std::string& strRedisAddress) const;
+
+    // Follow MOVED/ASK response, send request to the new redis node. MOVED updates slot owner, ASK does not.
+    // Return true if the request success on new redis node, m_pCurRedisSession is the new redis node
+    bool RedirectRedisCmd(const std::string& strRedirectResponse, const std::string& strRedisCmdRequest, CFlyRedisReplyBuilder* pReplyBuilder = nullptr, const std::vector<FlyRedisGatherParam>* pVecGatherParam = nullptr);
+
+    // Process request on pRedisSession, the response is built into reply tree if pReplyBuilder is not nullptr
+    bool ProcRedisRequest(CFlyRedisSession* pRedisSession, const std::string& strRedisCmdRequest, CFlyRedisReplyBuilder* pReplyBuilder, const std::vector<FlyRedisGatherParam>* pVecGatherParam);
+
     // Run redis cmd
-    bool DeliverRedisCmd(const std::string& strKey, bool bIsWrite, bool bRunRecvCmd, const char* pszCaller);
+    bool DeliverRedisCmd(const std::string& strKey, bool bIsWrite, bool bRunRecvCmd, const char* pszCaller, CFlyRedisReplyBuilder* pReplyBuilder = nullptr);
     bool RunRedisCmdOnOneLineResponseInt(const std::string& strKey, bool bIsWrite, int& nResult, const char* pszCaller);
     bool RunRedisCmdOnOneLineResponseDouble(const std::string& strKey, bool bIsWrite, double& fResult, const char* pszCaller);
     bool RunRedisCmdOnOneLineResponseString(const std::string& strKey, bool bIsWrite, std::string& strResult, const char* pszCaller);
     bool RunRedisCmdOnOneLineResponseVector(const std::string& strKey, bool bIsWrite, std::vector<std::string>& vecResult, const char* pszCaller);
     bool RunRedisCmdOnOneLineResponseSet(const std::string& strKey, bool bIsWrite, std::set<std::string>& setResult, const char* pszCaller);
     bool RunRedisCmdOnResponseKVP(const std::string& strKey, bool bIsWrite, std::map<std::string, std::string>& mapResult, const char* pszCaller);
-    bool RunRedisCmdOnResponsePairList(const std::string& strKey, bool bIsWrite, std::vector< std::pair<std::string, std::string> >& vecResult, const char* pszCaller);
+    // Element is passed to visitor while the reply is parsed, so memory is bounded for huge reply
+    bool RunRedisCmdOnElementVisitor(const std::string& strKey, bool bIsWrite, const FlyRedisElementVisitor& fnVisitor, const char* pszCaller, const FlyRedisElementCountVisitor& fnElementCountVisitor = nullptr);
+    bool RunRedisCmdOnKVPVisitor(const std::string& strKey, bool bIsWrite, const FlyRedisKVPVisitor& fnVisitor, const char* pszCaller);
+    bool RunRedisCmdOnElementDecoder(const std::string& strKey, bool bIsWrite, CFlyRedisElementDecoder& hElementDecoder, const char* pszCaller);
     bool RunRedisCmdOnScanCmd(const std::string& strKey, int& nResultCursor, std::vector<std::string>& vecResult, const char* pszCaller);
     bool RunRedisCmdOnSubscribeCmd(std::vector<FlyRedisSubscribeResponse>& vecResult, int nChannelCount, const char* pszCaller);
 
     void ClearRedisCmdCache();
 
+    // Encode cmd into m_strRedisCmdRequest directly without m_vecRedisCmdParamList, DeliverRedisCmd sends it as it is.
+    // Large param is referenced by m_vecRedisCmdGatherParam, so params should be valid until the cmd is delivered
+    template <typename... TParams>
+    void EncodeRedisCmd(const CFlyRedisCmdName& hCmdName, const TParams&... params)
+    {
+        ClearRedisCmdCache();
+        CFlyRedisCmdEncoder::AppendGatherRedisCmd(m_strRedisCmdRequest, m_vecRedisCmdGatherParam, hCmdName, params...);
+    }
+    bool BuildMGETCmd(const std::vector<std::string>& vecKey);
+
     bool BuildFlyRedisSubscribeResponse(const std::vector<std::string>& vecInput, std::vector<FlyRedisSubscribeResponse>& vecResult) const;
     bool BuildFlyRedisPMessageResponse(const std::vector<std::string>& vecInput, std::vector<FlyRedisPMessageResponse>& vecResult) const;
 
@@ -641,13 +2379,13 @@ private:
     boost::asio::io_context m_boostIOContext;
 #ifdef FLY_REDIS_ENABLE_TLS
     bool m_bUseTLSFlag = false;
-    boost::asio::ssl::context m_boostTLSContext = boost::asio::ssl::context::sslv23_client;
+    boost::asio::ssl::context m_boostTLSContext{ boost::asio::ssl::context::sslv23_client };
 #endif // FLY_REDIS_ENABLE_TLS
     //////////////////////////////////////////////////////////////////////////
-    int m_nReadTimeoutSeconds = 5;
+    int m_nReadTimeoutMS = 5000;
     std::string m_strRedisAddress;
     std::set<std::string> m_setRedisAddressSeed;
-    std::string m_strRedisPasswod;
+    FlyRedisHandshakeConfig m_stHandshakeConfig;
     bool m_bClusterFlag = false;
     FlyRedisClusterDetectType m_nFlyRedisClusterDetectType = FlyRedisClusterDetectType::AutoDetect;
     FlyRedisReadWriteType m_nFlyRedisReadWriteType = FlyRedisReadWriteType::ReadWriteOnMaster;
@@ -655,6 +2393,24 @@ private:
     // Key: redis address, ip:port
     // Value: redis session
     std::map<std::string, CFlyRedisSession*> m_mapRedisSession;
+    // Index: slot, it is filled in cluster mode only
+    std::vector<RedisSlotOwner> m_vecRedisSlotOwner;
+    //////////////////////////////////////////////////////////////////////////
+    // Session pool, the sessions leased by current cmd are returned when the cmd is done
+    CFlyRedisSessionPool* m_pRedisSessionPool = nullptr;
+    std::vector<CFlyRedisSession*> m_vecPoolRedisSession;
+    //////////////////////////////////////////////////////////////////////////
+    // Cluster topology, m_pClusterTopology is applied to m_vecRedisSlotOwner.
+    // m_pNewClusterTopology is published by refresh thread, it is accessed by std::atomic_load/std::atomic_store
+    std::shared_ptr<const FlyRedisClusterTopology> m_pClusterTopology;
+    std::shared_ptr<const FlyRedisClusterTopology> m_pNewClusterTopology;
+    std::atomic<bool> m_bHasNewClusterTopology;
+    int m_nClusterTopologyRefreshMS = 0;
+    std::thread m_hClusterTopologyRefreshThread;
+    std::mutex m_mutexClusterTopologyRefresh;
+    std::condition_variable m_cvClusterTopologyRefresh;
+    bool m_bStopClusterTopologyRefresh = false;
+    bool m_bClusterTopologyRefreshNow = false;
     int m_nRedisNodeCount = 0;
     // Flag of need verify redis session list
     bool m_bHasBadRedisSession = false;
@@ -662,6 +2418,15 @@ private:
     // Redis Request 
     std::vector<std::string> m_vecRedisCmdParamList;
     std::string m_strRedisCmdRequest;
+    // Large param of m_strRedisCmdRequest which is encoded by EncodeRedisCmd, it is sent by gathered write
+    std::vector<FlyRedisGatherParam> m_vecRedisCmdGatherParam;
+    // Reply tree of RunRedisCmd
+    CFlyRedisReplyBuilder m_hReplyBuilder;
+    //////////////////////////////////////////////////////////////////////////
+    // Stats, the node stats is not erased by ResetStats, since session points to it
+    std::map<std::string, FlyRedisNodeStats> m_mapNodeStats;
+    std::map<std::string, FlyRedisCmdStats> m_mapCmdStats;
+    std::string m_strStatsCmdName;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -675,17 +2440,94 @@ enum class FlyRedisLogLevel : int
     Command = 5,
 };
 
+//////////////////////////////////////////////////////////////////////////
+// Define AsyncLogger, bounded lock-free ring of formatted log records.
+// Any thread formats log into a free record, the only consumer is the background thread which calls logger handler
+class CFlyRedisAsyncLogger
+{
+public:
+    // nRecordCount is rounded up to power of 2, every record is 4KB
+    explicit CFlyRedisAsyncLogger(size_t nRecordCount);
+    ~CFlyRedisAsyncLogger();
+
+    // Start the background thread
+    void Start();
+
+    // Handle every pushed record, then stop the background thread
+    void Stop();
+
+    // Format log into a free record, it waits for the background thread if the ring is full, so log is kept in order.
+    // Return false if the logger is stopped
+    bool Push(FlyRedisLogLevel nLevel, const char* pszMsgFormat, va_list vaList);
+
+    // Copy request into a free record as it is, it is converted into cmd log by the background thread.
+    // Return false if the logger is stopped or the request is longer than the record
+    bool PushRedisCmdRequest(const std::string& strRedisAddress, const boost::string_view& strRedisCmdRequest);
+
+    // Log written by the background thread, such as in logger handler, is handled inline
+    inline bool IsBackgroundThread() const
+    {
+        return std::this_thread::get_id() == m_hThread.get_id();
+    }
+
+private:
+    struct LogRecord
+    {
+        // Record is free for push at pos if it is pos, and it is ready for pop at pos if it is pos + 1
+        std::atomic<size_t> nSeq;
+        FlyRedisLogLevel nLevel;
+        // Content is "RedisAddress\0RedisCmdRequest" of nLen bytes if it is cmd request, otherwise it is formatted log
+        bool bRedisCmdRequest;
+        size_t nLen;
+        char szContent[4096];
+    };
+
+    void Run();
+
+    // Claim the record at push pos, wait until it is popped if the ring is full, return nullptr if the logger is stopped
+    LogRecord* ClaimRecord(size_t& nPos);
+
+    // Handle the oldest record, return false if there is no record
+    bool Pop();
+
+    std::unique_ptr<LogRecord[]> m_pRecord;
+    size_t m_nRecordMask = 0;
+    std::atomic<size_t> m_nPushPos;
+    // Pop pos is used by the background thread only
+    size_t m_nPopPos = 0;
+    std::atomic<bool> m_bRunning;
+    std::thread m_hThread;
+    // Cmd request of record which is converted into cmd log
+    std::string m_strRedisAddress;
+};
+
 //////////////////////////////////////////////////////////////////////////
 // Define CFlyRedis
 class CFlyRedis
 {
 public:
-    // Set logger handler
+    // Set logger handler, it should be set before any log is written.
+    // Handler is called by every thread which writes log, or by the background thread of async logger, so it must be thread-safe
     static void SetLoggerHandler(FlyRedisLogLevel nLogLevel, std::function<void(const char*)> pfnLoggerHandler);
 
+    // Return true if logger handler of this level is set, it is checked before log is formatted
+    static inline bool IsLoggerEnabled(FlyRedisLogLevel nLogLevel)
+    {
+        return 0 != (ms_nLoggerLevelMask.load(std::memory_order_relaxed) & (1u << static_cast<int>(nLogLevel)));
+    }
+
+    // Logger handler is called by background thread after it is started, log is formatted and cmd request is copied into the ring of nRecordCount records.
+    // Writer waits for a free record if the ring is full, so log is never dropped or reordered. Log written in handler is handled inline.
+    // StopAsyncLogger waits for the thread which is writing log into the ring, then handles every pushed record. Start and stop it in one thread
+    static void StartAsyncLogger(size_t nRecordCount);
+    static void StopAsyncLogger();
+
     // Define logger function
     static void Logger(FlyRedisLogLevel nLevel, const char* pszMsgFormat, ...);
 
+    // Call logger handler of nLevel with formatted log, it is used by the background thread of async logger
+    static void CallLoggerHandler(FlyRedisLogLevel nLevel, const char* pszLogContent);
+
     // Calc the slot index
     static bool IsMultiKeyOnTheSameNode(const std::string& strKeyFirst, const std::string& strKeySecond);
     static bool IsMultiKeyOnTheSameNode(const std::vector<std::string>& vecKey);
@@ -697,12 +2539,38 @@ public:
     // Util function split string
     static std::vector<std::string> SplitString(const std::string& strInput, char chDelim);
 
+    // Util function find the first chDelim, or either of chDelim and chOtherDelim, in [pBegin, pEnd), return pEnd if it is not found.
+    // It scans 32 bytes per step by AVX2 or 16 bytes by SSE2 if the compiler enables them, otherwise byte by byte
+    static const char* FindDelim(const char* pBegin, const char* pEnd, char chDelim);
+    static const char* FindDelim(const char* pBegin, const char* pEnd, char chDelim, char chOtherDelim);
+
+    // Util function parse the response of INFO into section key-value field
+    static void ParseInfoResponse(const std::string& strInfoResponse, std::map<std::string, std::map<std::string, std::string> >& mapSectionInfo);
+
     // Util function build RedisCmdRequest
     static void BuildRedisCmdRequest(const std::string& strRedisAddress, const std::vector<std::string>& vecRedisCmdParamList, std::string& strRedisCmdRequest, bool bIsWriteCmd);
+    static void AppendRedisCmdRequest(const std::string& strRedisAddress, const std::vector<std::string>& vecRedisCmdParamList, std::string& strRedisCmdRequest, bool bIsWriteCmd);
+
+    // Util function write log of RedisCmdRequest which is encoded already, it is skipped if there is no cmd logger
+    static void LogRedisCmdRequest(const std::string& strRedisAddress, const boost::string_view& strRedisCmdRequest, const std::vector<FlyRedisGatherParam>* pVecGatherParam = nullptr);
+
+#ifdef FLY_REDIS_ENABLE_TLS
+    // Load cert, key and CA into TLS context
+    static bool LoadTLSContext(boost::asio::ssl::context& boostTLSContext, const std::string& strTLSCert, const std::string& strTLSKey, const std::string& strTLSCACert, const std::string& strTLSCACertDir);
+#endif // FLY_REDIS_ENABLE_TLS
 
 private:
+    // Writer holds the async logger while it pushes a record, StopAsyncLogger does not stop and delete it until every guard is released
+    struct AsyncLoggerGuard
+    {
+        AsyncLoggerGuard();
+        ~AsyncLoggerGuard();
+        CFlyRedisAsyncLogger* pAsyncLogger = nullptr;
+        bool bHeld = false;
+    };
+
     // Get logger handler by log level
-    static std::function<void(const char*)> GetLoggerHandler(FlyRedisLogLevel nLogLevel);
+    static const std::function<void(const char*)>& GetLoggerHandler(FlyRedisLogLevel nLogLevel);
 
     // Util function, CRC16
     static int CRC16(const char* buff, int nLen);
@@ -713,6 +2581,11 @@ private:
     static std::function<void(const char*)> ms_pfnLoggerWarning;
     static std::function<void(const char*)> ms_pfnLoggerError;
     static std::function<void(const char*)> ms_pfnLoggerPersistence;
+    // Bit of level whose logger handler is set
+    static std::atomic<unsigned int> ms_nLoggerLevelMask;
+    static std::atomic<CFlyRedisAsyncLogger*> ms_pAsyncLogger;
+    // Count of writer which holds AsyncLoggerGuard
+    static std::atomic<int> ms_nAsyncLoggerWriterCount;
 };
 
 #endif // _FLYREDIS_H_
\ No newline at end of file
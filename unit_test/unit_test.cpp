@@ -1,5 +1,10 @@
 #include "FlyRedis/FlyRedis.h"
+#include <unordered_map>
 #include "boost/thread.hpp"
+#ifdef FLY_REDIS_ENABLE_COROUTINE
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/detached.hpp"
+#endif // FLY_REDIS_ENABLE_COROUTINE
 
 #define BOOST_TEST_MODULE UTFlyRedis
 #include "boost/test/included/unit_test.hpp"
@@ -730,3 +735,487 @@ BOOST_AUTO_TEST_CASE(PUBSUB_CMD)
     BOOST_CHECK(pFlyRedisClient->PUBLISH("ch1", "msg1", nResult));
     DESTROY_REDIS_CLIENT();
 }
+
+BOOST_AUTO_TEST_CASE(PIPELINE)
+{
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_pipeline_" + std::to_string(time(nullptr));
+    CFlyRedisPipeline hPipeline;
+    hPipeline.HSET(strKey, "field", "1");
+    hPipeline.HINCRBY(strKey, "field", 2);
+    hPipeline.AppendRedisCmd(strKey, false, { "NOSUCHCMD", strKey });
+    hPipeline.EXPIRE(strKey, 10);
+    hPipeline.HGET(strKey, "field");
+    hPipeline.DEL(strKey);
+    std::vector<FlyRedisPipelineResponse> vecResponse;
+    BOOST_CHECK(pFlyRedisClient->ExecPipeline(hPipeline, vecResponse));
+    BOOST_CHECK_EQUAL(vecResponse.size(), 6);
+    BOOST_CHECK_EQUAL(vecResponse[0].stRedisResponse.strRedisResponse, "1");
+    BOOST_CHECK_EQUAL(vecResponse[1].stRedisResponse.strRedisResponse, "3");
+    BOOST_CHECK(vecResponse[2].bResponseError);
+    BOOST_CHECK_EQUAL(vecResponse[3].stRedisResponse.strRedisResponse, "1");
+    BOOST_CHECK_EQUAL(vecResponse[4].stRedisResponse.strRedisResponse, "3");
+    BOOST_CHECK_EQUAL(vecResponse[5].stRedisResponse.strRedisResponse, "1");
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(REPLY_TREE)
+{
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_reply_tree_" + std::to_string(time(nullptr));
+    const FlyRedisReplyNode* pReply = nullptr;
+    BOOST_CHECK(pFlyRedisClient->RunRedisCmd(strKey, true, { "RPUSH", strKey, "a", "b" }, pReply));
+    BOOST_CHECK(FlyRedisReplyType::Int == pReply->nType);
+    BOOST_CHECK_EQUAL(pReply->nInt, 2);
+    // Nested aggregate keeps its structure
+    BOOST_CHECK(pFlyRedisClient->RunRedisCmd(strKey, true, { "EVAL", "return {redis.call('LRANGE', KEYS[1], 0, -1), 3}", "1", strKey }, pReply));
+    BOOST_CHECK(FlyRedisReplyType::Array == pReply->nType);
+    BOOST_CHECK_EQUAL(pReply->GetElementCount(), 2);
+    BOOST_CHECK(FlyRedisReplyType::Array == pReply->GetElement(0).nType);
+    BOOST_CHECK_EQUAL(pReply->GetElement(0).GetElement(1).GetString(), "b");
+    BOOST_CHECK_EQUAL(pReply->GetElement(1).nInt, 3);
+    BOOST_CHECK(!pFlyRedisClient->RunRedisCmd(strKey, false, { "NOSUCHCMD", strKey }, pReply));
+    BOOST_CHECK(FlyRedisReplyType::Error == pReply->nType);
+    BOOST_CHECK(pFlyRedisClient->RunRedisCmd(strKey, true, { "DEL", strKey }, pReply));
+    BOOST_CHECK_EQUAL(pReply->nInt, 1);
+    // INFO is VerbatimString of RESP3, it is the same text as RESP2
+    BOOST_CHECK(pFlyRedisClient->RunRedisCmd(strKey, false, { "INFO", "Server" }, pReply));
+    BOOST_CHECK(FlyRedisReplyType::Bulk == pReply->nType);
+    BOOST_CHECK(pReply->GetStringView().starts_with("# Server"));
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(REPLY_VIEW)
+{
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_reply_view_" + std::to_string(time(nullptr));
+    std::string strValue(64 * 1024, 'v');
+    BOOST_CHECK(pFlyRedisClient->SET(strKey, strValue));
+    const FlyRedisReplyNode* pReply = nullptr;
+    BOOST_CHECK(pFlyRedisClient->RunRedisCmdOnReplyView(strKey, false, { "GET", strKey }, pReply));
+    BOOST_CHECK(pReply->GetStringView() == boost::string_view(strValue));
+    BOOST_CHECK(pFlyRedisClient->RunRedisCmdOnReplyView(strKey, true, { "DEL", strKey }, pReply));
+    BOOST_CHECK_EQUAL(pReply->nInt, 1);
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(ELEMENT_VISITOR)
+{
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_element_visitor_" + std::to_string(time(nullptr));
+    int nResult = 0;
+    for (int nIndex = 0; nIndex < 100; ++nIndex)
+    {
+        BOOST_CHECK(pFlyRedisClient->HSET(strKey, "field" + std::to_string(nIndex), std::to_string(nIndex), nResult));
+    }
+    int nKVPCount = 0;
+    BOOST_CHECK(pFlyRedisClient->HGETALL(strKey, [&nKVPCount](const boost::string_view& strField, const boost::string_view& strValue) {
+        BOOST_CHECK(strField == "field" + std::string(strValue.data(), strValue.size()));
+        ++nKVPCount;
+    }));
+    BOOST_CHECK_EQUAL(nKVPCount, 100);
+    int nElementCount = 0;
+    BOOST_CHECK(pFlyRedisClient->HKEYS(strKey, [&nElementCount](const boost::string_view& /*strElement*/) { ++nElementCount; }));
+    BOOST_CHECK_EQUAL(nElementCount, 100);
+    BOOST_CHECK(pFlyRedisClient->DEL(strKey, nResult));
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(DECODE_CONTAINER)
+{
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_decode_container_" + std::to_string(time(nullptr));
+    int nResult = 0;
+    for (int nIndex = 0; nIndex < 100; ++nIndex)
+    {
+        BOOST_CHECK(pFlyRedisClient->HSET(strKey, "field" + std::to_string(nIndex), std::to_string(nIndex), nResult));
+    }
+    std::unordered_map<std::string, int64_t> mapFieldValue;
+    BOOST_CHECK(pFlyRedisClient->HGETALL(strKey, mapFieldValue));
+    BOOST_CHECK_EQUAL(mapFieldValue.size(), 100);
+    BOOST_CHECK_EQUAL(mapFieldValue["field7"], 7);
+    std::vector<std::pair<std::string, std::string> > vecFieldValue;
+    BOOST_CHECK(pFlyRedisClient->HGETALL(strKey, vecFieldValue));
+    BOOST_CHECK_EQUAL(vecFieldValue.size(), 100);
+    std::vector<int64_t> vecValue;
+    BOOST_CHECK(pFlyRedisClient->HVALS(strKey, vecValue));
+    BOOST_CHECK_EQUAL(vecValue.size(), 100);
+    std::vector<int64_t> vecField;
+    BOOST_CHECK(!pFlyRedisClient->HKEYS(strKey, vecField));
+    // Container is cleared before decode, so it can be reused
+    BOOST_CHECK(pFlyRedisClient->HGETALL(strKey, mapFieldValue));
+    BOOST_CHECK_EQUAL(mapFieldValue.size(), 100);
+    BOOST_CHECK(pFlyRedisClient->DEL(strKey, nResult));
+    // Duplicate field can not be kept in map
+    CFlyRedisContainerDecoder<std::unordered_map<std::string, int64_t> > hContainerDecoder(mapFieldValue);
+    hContainerDecoder.OnElement("field");
+    hContainerDecoder.OnElement("1");
+    hContainerDecoder.OnElement("field");
+    hContainerDecoder.OnElement("2");
+    BOOST_CHECK(!hContainerDecoder.IsDecodeSuccess());
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(FIND_DELIM)
+{
+    std::string strInput(100, 'a');
+    strInput[70] = ':';
+    strInput[90] = '\r';
+    const char* pEnd = strInput.data() + strInput.length();
+    BOOST_CHECK(CFlyRedis::FindDelim(strInput.data(), pEnd, '\r') == strInput.data() + 90);
+    BOOST_CHECK(CFlyRedis::FindDelim(strInput.data(), pEnd, '\r', ':') == strInput.data() + 70);
+    BOOST_CHECK(CFlyRedis::FindDelim(strInput.data() + 91, pEnd, '\r') == pEnd);
+    std::vector<std::string> vecResult = CFlyRedis::SplitString("a\n\nb\n", '\n');
+    BOOST_CHECK_EQUAL(vecResult.size(), 4);
+    BOOST_CHECK_EQUAL(vecResult[2], "b");
+    std::map<std::string, std::map<std::string, std::string> > mapSectionInfo;
+    CFlyRedis::ParseInfoResponse("# Server\r\nredis_version:7.2.4\r\n\r\n# Cluster\r\ncluster_enabled:1\r\n", mapSectionInfo);
+    BOOST_CHECK_EQUAL(mapSectionInfo["# Server"]["redis_version"], "7.2.4");
+    BOOST_CHECK_EQUAL(mapSectionInfo["# Cluster"]["cluster_enabled"], "1");
+}
+
+BOOST_AUTO_TEST_CASE(CMD_ENCODER)
+{
+    std::vector<std::string> vecMember = { "m1", "m2" };
+    std::vector<std::string> vecRedisCmdParamList = { "CLIENT", "KILL", "key", "", "-42", "18446744073709551615", "m1", "m2" };
+    std::string strExpectRequest;
+    CFlyRedis::BuildRedisCmdRequest("", vecRedisCmdParamList, strExpectRequest, false);
+    static const CFlyRedisCmdName hCmdName("CLIENT", "KILL");
+    std::string strRequest;
+    CFlyRedisCmdEncoder::AppendRedisCmd(strRequest, hCmdName, "key", std::string(), -42, 18446744073709551615ULL, vecMember);
+    BOOST_CHECK_EQUAL(strRequest, strExpectRequest);
+}
+
+BOOST_AUTO_TEST_CASE(GATHER_WRITE)
+{
+    std::string strValue(FLY_REDIS_GATHER_PARAM_LEN * 64, 'v');
+    static const CFlyRedisCmdName hCmdName("SET");
+    std::string strRequest;
+    std::vector<FlyRedisGatherParam> vecGatherParam;
+    CFlyRedisCmdEncoder::AppendGatherRedisCmd(strRequest, vecGatherParam, hCmdName, "key", strValue);
+    BOOST_CHECK_EQUAL(vecGatherParam.size(), 1);
+    BOOST_CHECK(vecGatherParam[0].strParam.data() == strValue.data());
+    BOOST_CHECK(strRequest.length() < 64);
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_gather_write_" + std::to_string(time(nullptr));
+    std::string strResult;
+    int nResult = 0;
+    BOOST_CHECK(pFlyRedisClient->SET(strKey, strValue));
+    BOOST_CHECK(pFlyRedisClient->GET(strKey, strResult));
+    BOOST_CHECK(strResult == strValue);
+    BOOST_CHECK(pFlyRedisClient->DEL(strKey, nResult));
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(NUMBER_CODEC)
+{
+    char szValue[32];
+    size_t nLen = CFlyRedisNumberCodec::EncodeDouble(szValue, 0.1);
+    BOOST_CHECK_EQUAL(std::string(szValue, nLen), "0.1");
+    BOOST_CHECK_EQUAL(CFlyRedisNumberCodec::DoubleToString(0.1 + 0.2), "0.30000000000000004");
+    BOOST_CHECK_EQUAL(CFlyRedisNumberCodec::DoubleToString(-1e300), "-1e+300");
+    double fValue = 0.0;
+    BOOST_CHECK(CFlyRedisNumberCodec::DecodeDouble(szValue, szValue + nLen, fValue));
+    BOOST_CHECK_EQUAL(fValue, 0.1);
+    std::string strValue = "-9223372036854775808";
+    long long nValue = 0;
+    BOOST_CHECK(CFlyRedisNumberCodec::DecodeInt(strValue.data(), strValue.data() + strValue.length(), nValue));
+    BOOST_CHECK_EQUAL(nValue, LLONG_MIN);
+    strValue = "9223372036854775808";
+    BOOST_CHECK(!CFlyRedisNumberCodec::DecodeInt(strValue.data(), strValue.data() + strValue.length(), nValue));
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_number_codec_" + std::to_string(time(nullptr));
+    int nResult = 0;
+    BOOST_CHECK(pFlyRedisClient->ZADD(strKey, 0.1234567891234, "member", nResult));
+    BOOST_CHECK(pFlyRedisClient->ZSCORE(strKey, "member", fValue));
+    BOOST_CHECK_EQUAL(fValue, 0.1234567891234);
+    BOOST_CHECK(pFlyRedisClient->DEL(strKey, nResult));
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(ASYNC_LOGGER)
+{
+    static std::atomic<int> s_nCmdLogCount(0);
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Command, nullptr);
+    BOOST_CHECK(!CFlyRedis::IsLoggerEnabled(FlyRedisLogLevel::Command));
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Command, [](const char* pszLogContent) {
+        if (0 == strcmp(pszLogContent, "RedisCmd,127.0.0.1:6379,SET key value "))
+        {
+            ++s_nCmdLogCount;
+        }
+    });
+    BOOST_CHECK(CFlyRedis::IsLoggerEnabled(FlyRedisLogLevel::Command));
+    CFlyRedis::StartAsyncLogger(16);
+    std::string strRequest;
+    for (int nIndex = 0; nIndex < 100; ++nIndex)
+    {
+        strRequest.clear();
+        CFlyRedis::BuildRedisCmdRequest("127.0.0.1:6379", { "SET", "key", "value" }, strRequest, true);
+    }
+    // Writer waits for a free record of the full ring, and Stop drains all records
+    CFlyRedis::StopAsyncLogger();
+    BOOST_CHECK_EQUAL(s_nCmdLogCount.load(), 100);
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Command, nullptr);
+    // Log is kept in order when the ring is full
+    static std::vector<int> s_vecLogIndex;
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Notice, [](const char* pszLogContent) {
+        s_vecLogIndex.push_back(atoi(pszLogContent));
+    });
+    CFlyRedis::StartAsyncLogger(16);
+    for (int nIndex = 0; nIndex < 1000; ++nIndex)
+    {
+        CFlyRedis::Logger(FlyRedisLogLevel::Notice, "%d", nIndex);
+    }
+    CFlyRedis::StopAsyncLogger();
+    BOOST_CHECK_EQUAL(s_vecLogIndex.size(), 1000);
+    BOOST_CHECK(std::is_sorted(s_vecLogIndex.begin(), s_vecLogIndex.end()));
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Notice, nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(LATENCY_STATS)
+{
+    CFlyRedisLatencyHistogram hLatency;
+    BOOST_CHECK_EQUAL(hLatency.GetPercentileUS(99), 0ULL);
+    for (unsigned long long nLatencyUS = 1; nLatencyUS <= 1000; ++nLatencyUS)
+    {
+        hLatency.Record(nLatencyUS);
+    }
+    BOOST_CHECK_EQUAL(hLatency.GetCount(), 1000ULL);
+    BOOST_CHECK_EQUAL(hLatency.GetMaxUS(), 1000ULL);
+    BOOST_CHECK(hLatency.GetPercentileUS(50) >= 500 && hLatency.GetPercentileUS(50) <= 500 + 500 / 16);
+    BOOST_CHECK(hLatency.GetPercentileUS(99) >= 990 && hLatency.GetPercentileUS(99) <= 1000);
+    BOOST_CHECK_EQUAL(hLatency.GetPercentileUS(100), 1000ULL);
+    CREATE_REDIS_CLIENT();
+    std::string strKey = "key_latency_stats_" + std::to_string(time(nullptr));
+    std::string strResult;
+    int nResult = 0;
+    pFlyRedisClient->ResetStats();
+    for (int nIndex = 0; nIndex < 10; ++nIndex)
+    {
+        BOOST_CHECK(pFlyRedisClient->SET(strKey, "value"));
+        BOOST_CHECK(pFlyRedisClient->GET(strKey, strResult));
+    }
+    BOOST_CHECK(pFlyRedisClient->DEL(strKey, nResult));
+    FlyRedisStatsSnapshot stStatsSnapshot;
+    pFlyRedisClient->GetStatsSnapshot(stStatsSnapshot);
+    BOOST_CHECK_EQUAL(stStatsSnapshot.mapCmdStats["SET"].nCmdCount, 10ULL);
+    BOOST_CHECK_EQUAL(stStatsSnapshot.mapCmdStats["GET"].hLatency.GetCount(), 10ULL);
+    BOOST_CHECK_EQUAL(stStatsSnapshot.mapCmdStats["DEL"].nFailedCount, 0ULL);
+    unsigned long long nBulkReplyCount = 0;
+    unsigned long long nBytesSent = 0;
+    for (auto& kvp : stStatsSnapshot.mapNodeStats)
+    {
+        nBulkReplyCount += kvp.second.GetReplyCount(FlyRedisReplyType::Bulk);
+        nBytesSent += kvp.second.nBytesSent;
+    }
+    BOOST_CHECK_EQUAL(nBulkReplyCount, 10ULL);
+    BOOST_CHECK(nBytesSent > 0);
+    DESTROY_REDIS_CLIENT();
+}
+
+BOOST_AUTO_TEST_CASE(RESP3_HANDSHAKE)
+{
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Error, Logger);
+    std::vector<std::string> vecAddr = CFlyRedis::SplitString(CONFIG_REDIS_ADDR, ':');
+    CFlyRedisClient hFlyRedisClient;
+    if (CONFIG_USE_TLS && !hFlyRedisClient.SetTLSContext("./tls/redis.crt", "./tls/redis.key", "./tls/ca.crt", "")) { return; }
+    hFlyRedisClient.SetRedisConfig(vecAddr[0], atoi(vecAddr[1].c_str()), CONFIG_REDIS_PASSWORD);
+    // INFO is VerbatimString after HELLO 3, handshake must still get redis_version from it
+    hFlyRedisClient.SetHandshakeConfig(3, "", "");
+    BOOST_CHECK(hFlyRedisClient.Open());
+    std::string strKey = "key_resp3_handshake_" + std::to_string(time(nullptr));
+    std::string strResult;
+    int nResult = 0;
+    BOOST_CHECK(hFlyRedisClient.SET(strKey, "value"));
+    BOOST_CHECK(hFlyRedisClient.GET(strKey, strResult));
+    BOOST_CHECK_EQUAL(strResult, "value");
+    BOOST_CHECK(hFlyRedisClient.DEL(strKey, nResult));
+}
+
+BOOST_AUTO_TEST_CASE(SESSION_POOL)
+{
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Error, Logger);
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Warning, Logger);
+    std::vector<std::string> vecAddr = CFlyRedis::SplitString(CONFIG_REDIS_ADDR, ':');
+    CFlyRedisSessionPool hRedisSessionPool;
+    if (CONFIG_USE_TLS && !hRedisSessionPool.SetTLSContext("./tls/redis.crt", "./tls/redis.key", "./tls/ca.crt", "")) { return; }
+    hRedisSessionPool.SetRedisConfig(vecAddr[0], atoi(vecAddr[1].c_str()), CONFIG_REDIS_PASSWORD);
+    hRedisSessionPool.SetHandshakeConfig(CONFIG_RESP_VER, "", "");
+    hRedisSessionPool.SetSessionCountPerNode(1, 2);
+    BOOST_CHECK(hRedisSessionPool.Open());
+    std::vector<boost::thread*> vecThread;
+    for (int nThreadIndex = 0; nThreadIndex < 4; ++nThreadIndex)
+    {
+        vecThread.push_back(new boost::thread([&hRedisSessionPool, nThreadIndex]() {
+            CFlyRedisClient hFlyRedisClient;
+            hFlyRedisClient.SetRedisSessionPool(&hRedisSessionPool);
+            BOOST_CHECK(hFlyRedisClient.Open());
+            std::string strKey = "key_pool_" + std::to_string(nThreadIndex) + "_" + std::to_string(time(nullptr));
+            std::string strResult;
+            int nResult = 0;
+            BOOST_CHECK(hFlyRedisClient.SET(strKey, strKey));
+            BOOST_CHECK(hFlyRedisClient.GET(strKey, strResult));
+            BOOST_CHECK_EQUAL(strResult, strKey);
+            BOOST_CHECK(hFlyRedisClient.DEL(strKey, nResult));
+        }));
+    }
+    for (boost::thread* pThread : vecThread)
+    {
+        pThread->join();
+        delete pThread;
+    }
+    std::vector<std::string> vecRedisNodeList;
+    hRedisSessionPool.FetchRedisNodeList(vecRedisNodeList);
+    BOOST_CHECK(hRedisSessionPool.GetRedisSessionCount() <= static_cast<int>(vecRedisNodeList.size()) * 2);
+    // Session of pool is connected by the pool, its connect count is in the snapshot of client
+    CFlyRedisClient hFlyRedisClient;
+    hFlyRedisClient.SetRedisSessionPool(&hRedisSessionPool);
+    FlyRedisStatsSnapshot stStatsSnapshot;
+    hFlyRedisClient.GetStatsSnapshot(stStatsSnapshot);
+    unsigned long long nConnectCount = 0;
+    for (auto& kvp : stStatsSnapshot.mapNodeStats)
+    {
+        nConnectCount += kvp.second.nConnectCount;
+    }
+    BOOST_CHECK(nConnectCount >= vecRedisNodeList.size());
+}
+
+BOOST_AUTO_TEST_CASE(MULTIPLEX_SESSION)
+{
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Error, Logger);
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Warning, Logger);
+    std::vector<std::string> vecAddr = CFlyRedis::SplitString(CONFIG_REDIS_ADDR, ':');
+    CFlyRedisMultiplexSession hMultiplexSession;
+    if (CONFIG_USE_TLS && !hMultiplexSession.SetTLSContext("./tls/redis.crt", "./tls/redis.key", "./tls/ca.crt", "")) { return; }
+    hMultiplexSession.SetRedisConfig(vecAddr[0], atoi(vecAddr[1].c_str()), CONFIG_REDIS_PASSWORD);
+    hMultiplexSession.SetHandshakeConfig(CONFIG_RESP_VER, "", "");
+    BOOST_CHECK(hMultiplexSession.Open());
+    std::vector<boost::thread*> vecThread;
+    for (int nThreadIndex = 0; nThreadIndex < 4; ++nThreadIndex)
+    {
+        vecThread.push_back(new boost::thread([&hMultiplexSession, nThreadIndex]() {
+            std::string strKey = "key_multiplex_" + std::to_string(nThreadIndex) + "_" + std::to_string(time(nullptr));
+            for (int nIndex = 0; nIndex < 100; ++nIndex)
+            {
+                FlyRedisPipelineResponse stResponse;
+                BOOST_CHECK(hMultiplexSession.RunRedisCmd(false, { "INCR", strKey }, stResponse));
+                BOOST_CHECK_EQUAL(stResponse.stRedisResponse.strRedisResponse, std::to_string(nIndex + 1));
+            }
+            CFlyRedisPipeline hPipeline;
+            hPipeline.GET(strKey);
+            hPipeline.DEL(strKey);
+            std::vector<FlyRedisPipelineResponse> vecResponse;
+            BOOST_CHECK(hMultiplexSession.ExecPipeline(hPipeline, vecResponse));
+            BOOST_CHECK_EQUAL(vecResponse[0].stRedisResponse.strRedisResponse, "100");
+            BOOST_CHECK_EQUAL(vecResponse[1].stRedisResponse.strRedisResponse, "1");
+        }));
+    }
+    for (boost::thread* pThread : vecThread)
+    {
+        pThread->join();
+        delete pThread;
+    }
+    hMultiplexSession.Close();
+}
+
+BOOST_AUTO_TEST_CASE(ASYNC_SESSION)
+{
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Error, Logger);
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Warning, Logger);
+    std::vector<std::string> vecAddr = CFlyRedis::SplitString(CONFIG_REDIS_ADDR, ':');
+    boost::asio::io_context boostIOContext;
+#ifdef FLY_REDIS_ENABLE_TLS
+    boost::asio::ssl::context boostTLSContext{ boost::asio::ssl::context::sslv23_client };
+    if (!CFlyRedis::LoadTLSContext(boostTLSContext, "./tls/redis.crt", "./tls/redis.key", "./tls/ca.crt", "")) { return; }
+    CFlyRedisAsyncSession hAsyncSession(boostIOContext, CONFIG_USE_TLS, boostTLSContext);
+#else
+    CFlyRedisAsyncSession hAsyncSession(boostIOContext);
+#endif // FLY_REDIS_ENABLE_TLS
+    hAsyncSession.SetRedisConfig(vecAddr[0], atoi(vecAddr[1].c_str()), CONFIG_REDIS_PASSWORD);
+    hAsyncSession.SetHandshakeConfig(CONFIG_RESP_VER, "", "");
+    bool bOpenResult = false;
+    hAsyncSession.AsyncOpen([&bOpenResult](const boost::system::error_code& boostErrorCode) {
+        bOpenResult = !boostErrorCode;
+    });
+    // Cmd can be queued before the session is open
+    std::string strKey = "key_async_" + std::to_string(time(nullptr));
+    int nDoneCount = 0;
+    for (int nIndex = 0; nIndex < 100; ++nIndex)
+    {
+        hAsyncSession.AsyncRunRedisCmd(false, { "INCR", strKey }, [&nDoneCount, nIndex](const boost::system::error_code& boostErrorCode, const FlyRedisPipelineResponse& stResponse) {
+            BOOST_CHECK(!boostErrorCode);
+            BOOST_CHECK_EQUAL(stResponse.stRedisResponse.strRedisResponse, std::to_string(nIndex + 1));
+            ++nDoneCount;
+        });
+    }
+    CFlyRedisPipeline hPipeline;
+    hPipeline.GET(strKey);
+    hPipeline.DEL(strKey);
+    hAsyncSession.AsyncExecPipeline(hPipeline, [&hAsyncSession](const boost::system::error_code& boostErrorCode, const std::vector<FlyRedisPipelineResponse>& vecResponse) {
+        BOOST_CHECK(!boostErrorCode);
+        BOOST_CHECK_EQUAL(vecResponse[0].stRedisResponse.strRedisResponse, "100");
+        BOOST_CHECK_EQUAL(vecResponse[1].stRedisResponse.strRedisResponse, "1");
+        hAsyncSession.Close();
+    });
+    boostIOContext.run();
+    BOOST_CHECK(bOpenResult);
+    BOOST_CHECK_EQUAL(nDoneCount, 100);
+    // Session can be deleted while connect is pending, pending cmd gets operation_aborted
+#ifdef FLY_REDIS_ENABLE_TLS
+    CFlyRedisAsyncSession* pAsyncSession = new CFlyRedisAsyncSession(boostIOContext, CONFIG_USE_TLS, boostTLSContext);
+#else
+    CFlyRedisAsyncSession* pAsyncSession = new CFlyRedisAsyncSession(boostIOContext);
+#endif // FLY_REDIS_ENABLE_TLS
+    pAsyncSession->SetRedisConfig(vecAddr[0], atoi(vecAddr[1].c_str()), CONFIG_REDIS_PASSWORD);
+    boost::system::error_code boostCmdErrorCode;
+    pAsyncSession->AsyncOpen([](const boost::system::error_code&) {});
+    pAsyncSession->AsyncRunRedisCmd(false, { "PING" }, [&boostCmdErrorCode](const boost::system::error_code& boostErrorCode, const FlyRedisPipelineResponse&) {
+        boostCmdErrorCode = boostErrorCode;
+    });
+    delete pAsyncSession;
+    boostIOContext.restart();
+    boostIOContext.run();
+    BOOST_CHECK(boost::asio::error::operation_aborted == boostCmdErrorCode);
+}
+
+#ifdef FLY_REDIS_ENABLE_COROUTINE
+BOOST_AUTO_TEST_CASE(COROUTINE_CLIENT)
+{
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Error, Logger);
+    CFlyRedis::SetLoggerHandler(FlyRedisLogLevel::Warning, Logger);
+    std::vector<std::string> vecAddr = CFlyRedis::SplitString(CONFIG_REDIS_ADDR, ':');
+    boost::asio::io_context boostIOContext;
+#ifdef FLY_REDIS_ENABLE_TLS
+    boost::asio::ssl::context boostTLSContext{ boost::asio::ssl::context::sslv23_client };
+    if (!CFlyRedis::LoadTLSContext(boostTLSContext, "./tls/redis.crt", "./tls/redis.key", "./tls/ca.crt", "")) { return; }
+    CFlyRedisAsyncSession hAsyncSession(boostIOContext, CONFIG_USE_TLS, boostTLSContext);
+#else
+    CFlyRedisAsyncSession hAsyncSession(boostIOContext);
+#endif // FLY_REDIS_ENABLE_TLS
+    hAsyncSession.SetRedisConfig(vecAddr[0], atoi(vecAddr[1].c_str()), CONFIG_REDIS_PASSWORD);
+    hAsyncSession.SetHandshakeConfig(CONFIG_RESP_VER, "", "");
+    CFlyRedisCoroutineClient hCoroutineClient(hAsyncSession);
+    int nDoneCount = 0;
+    boost::asio::co_spawn(boostIOContext, [&]() -> boost::asio::awaitable<void> {
+        BOOST_CHECK(co_await hCoroutineClient.Open());
+        std::string strKey = "key_coroutine_" + std::to_string(time(nullptr));
+        BOOST_CHECK(co_await hCoroutineClient.SET(strKey, "1"));
+        int nResult = 0;
+        BOOST_CHECK(co_await hCoroutineClient.INCRBY(strKey, 10, nResult));
+        BOOST_CHECK_EQUAL(nResult, 11);
+        std::string strResult;
+        BOOST_CHECK(co_await hCoroutineClient.GET(strKey, strResult));
+        BOOST_CHECK_EQUAL(strResult, "11");
+        std::map<std::string, std::string> mapFieldValue;
+        BOOST_CHECK(co_await hCoroutineClient.HSET(strKey + "_hash", "field", "value", nResult));
+        BOOST_CHECK(co_await hCoroutineClient.HGETALL(strKey + "_hash", mapFieldValue));
+        BOOST_CHECK_EQUAL(mapFieldValue["field"], "value");
+        BOOST_CHECK(co_await hCoroutineClient.DEL(strKey, nResult));
+        BOOST_CHECK(co_await hCoroutineClient.DEL(strKey + "_hash", nResult));
+        ++nDoneCount;
+        hAsyncSession.Close();
+    }, boost::asio::detached);
+    boostIOContext.run();
+    BOOST_CHECK_EQUAL(nDoneCount, 1);
+}
+#endif // FLY_REDIS_ENABLE_COROUTINE